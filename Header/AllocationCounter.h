@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+
+// ============================================================================
+// ALLOCATION COUNTER
+// ============================================================================
+// Counts heap allocations through replaced global operator new, the aligned and
+// nothrow forms included. Only compiled in when KOSTUR_TRACK_ALLOCATIONS is
+// defined (benchmark builds), otherwise the counts stay at zero and allocation
+// tracking reports itself as disabled.
+//
+// Allocations are attributed to the scope set on the allocating thread, so a
+// frame's allocations can be told apart from the benchmark's own bookkeeping.
+enum class AllocationScope {
+    Frame,     // Anything not covered by a narrower scope
+    Input,
+    Render,
+    Benchmark, // Scenario playback and recording, excluded from the zero-allocation check
+    Count
+};
+
+constexpr int ALLOCATION_SCOPE_COUNT = static_cast<int>(AllocationScope::Count);
+
+const char *getAllocationScopeName(AllocationScope scope);
+
+struct AllocationStats {
+    uint64_t counts[ALLOCATION_SCOPE_COUNT]{};
+    uint64_t bytes[ALLOCATION_SCOPE_COUNT]{};
+
+    uint64_t get(const AllocationScope scope) const {
+        return counts[static_cast<int>(scope)];
+    }
+
+    uint64_t total() const;
+};
+
+bool isAllocationTrackingEnabled();
+
+// Moves everything counted since the last call into stats and starts over
+void collectAllocations(AllocationStats &stats);
+
+// Sets the scope allocations on this thread are attributed to, returns the previous one
+AllocationScope setAllocationScope(AllocationScope scope);
+
+class AllocationScopeGuard {
+public:
+    explicit AllocationScopeGuard(const AllocationScope scope) : previous(setAllocationScope(scope)) {}
+    ~AllocationScopeGuard() { setAllocationScope(previous); }
+
+    AllocationScopeGuard(const AllocationScopeGuard &) = delete;
+    AllocationScopeGuard &operator=(const AllocationScopeGuard &) = delete;
+
+private:
+    AllocationScope previous;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "GlStats.h"
+#include "InputQueue.h"
+
+// ============================================================================
+// BENCHMARK SCENARIOS
+// ============================================================================
+// A scenario is a small text script, one command per line:
+//
+//   frames N                 run N frames without new input
+//   key NAME down|up         press or release a letter key, F1-F25 or ESCAPE
+//   tap NAME                 press and release in the same frame
+//   click X Y                left click at NDC coordinates
+//   scatter N PER_FRAME SEED [shift]
+//                            N pseudo-random clicks, PER_FRAME of them each frame,
+//                            with shift held every click appends a point
+//   wander N SEED            move the cursor to a pseudo-random point every frame for N frames
+//   repeat N ... end         repeat the enclosed commands N times
+//
+// Input is injected through the regular InputQueue, so the scenario drives
+// exactly the code paths a user would.
+enum class ScenarioOp {
+    Frames,
+    Key,
+    Click,
+    Scatter,
+    Wander
+};
+
+struct ScenarioStep {
+    ScenarioOp op;
+    int count;    // Frames to run or wander, or clicks to scatter
+    int code;     // GLFW key
+    int action;   // GLFW_PRESS / GLFW_RELEASE
+    float x, y;   // Click position in NDC
+    int perFrame; // Scatter clicks per frame
+    int mods;     // GLFW modifiers held for scatter clicks
+    uint32_t seed;
+};
+
+struct BenchmarkRunner {
+    std::string name;
+    std::vector<ScenarioStep> steps;
+    size_t stepIndex = 0;
+    int stepProgress = 0;
+    uint32_t random = 0;
+
+    int warmupFrames = 10;
+    int frameIndex = 0;
+
+    bool assertNoAllocations = false; // Report every measured frame that allocates
+    int allocatingFrames = 0;
+
+    size_t routePoints = 0; // In the active measuring layer when the scenario ended
+
+    std::vector<double> cpuFrameMs;
+    std::vector<double> gpuFrameMs;
+    std::vector<double> glCounts[GL_COUNTER_COUNT]; // Frame totals per counter
+    double glSubsystemSums[GL_SUBSYSTEM_COUNT][GL_COUNTER_COUNT]{};
+    std::vector<double> allocations; // Without the benchmark's own bookkeeping
+    double allocationScopeSums[ALLOCATION_SCOPE_COUNT]{};
+};
+
+bool loadScenario(BenchmarkRunner &runner, const char *filePath);
+
+// Pushes this frame's input events, returns false once the scenario is over
+bool advanceScenario(BenchmarkRunner &runner, InputQueue &inputQueue, double time,
+                     int screenWidth, int screenHeight);
+
+// Counters are per frame. Warmup frames are dropped so that texture uploads and
+// shader compilation do not end up in the percentiles.
+void recordBenchmarkFrame(BenchmarkRunner &runner, double cpuMs, const GlFrameStats &glStats,
+                          const AllocationStats &allocations);
+void recordBenchmarkGpuTime(BenchmarkRunner &runner, double gpuMs);
+
+bool writeBenchmarkReport(const BenchmarkRunner &runner, const char *filePath);
+
+// Prints every metric that got slower than the baseline by more than the threshold,
+// returns the number of regressions or -1 if the baseline could not be read
+int compareWithBaseline(const BenchmarkRunner &runner, const char *baselinePath, double thresholdPercent);
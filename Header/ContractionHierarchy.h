@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MappedFile.h"
+#include "RoadGraph.h"
+#include "RoadRouter.h"
+#include "SpatialGrid.h"
+
+// ============================================================================
+// CONTRACTION HIERARCHY
+// ============================================================================
+// A road graph preprocessed so that a shortest path query settles a few hundred
+// nodes however large the graph is. Nodes are contracted least important first:
+// a contracted node leaves the graph, and every shortest path through it is kept
+// as a shortcut between two of its neighbours, unless a witness search finds a
+// path around it that is no longer. A query then searches from both ends over
+// edges that only lead to later contracted nodes, and the two searches meet at
+// the highest node of the path.
+//
+// Contraction runs in rounds. Each round takes the nodes whose priority is lower
+// than that of all their neighbours, so no two of them are adjacent, and runs
+// their witness searches on worker threads against a graph nobody writes to.
+// Shortcuts are merged after the round and the priorities of the neighbours
+// updated. The priority is the edge difference, shortcuts added less edges
+// removed, plus the number of neighbours already contracted, which spreads the
+// contraction evenly over the map.
+//
+// Only the upward edges are kept, in CSR form like RoadGraph, and a shortcut
+// records the node it bypasses so paths unpack back into streets. Node ids and
+// positions are those of the graph. The file holds the arrays as queries use
+// them, so a loaded hierarchy is a view into the mapped file.
+constexpr uint32_t NO_MIDDLE = 0xffffffffu;
+
+struct ContractionOptions {
+    size_t threads = 0;           // 0 for one per hardware thread
+    size_t witnessSettleLimit = 64; // Nodes a witness search settles before giving up and keeping the shortcut
+};
+
+struct ContractionStats {
+    size_t rounds = 0;
+    size_t shortcuts = 0; // Upward edges that bypass a node
+    double seconds = 0.0;
+};
+
+struct ContractionHierarchyData {
+    int width = 0, height = 0;  // Of the image the graph was traced from
+    std::vector<float> xs, ys;  // Per node, image pixels
+    std::vector<uint32_t> levels; // Round the node was contracted in, edges only lead to higher levels
+    std::vector<uint32_t> firstEdge; // Node count + 1 offsets into targets, weights and middles
+    std::vector<uint32_t> targets;
+    std::vector<float> weights;   // Pixels
+    std::vector<uint32_t> middles; // Node a shortcut bypasses, NO_MIDDLE for a street
+};
+
+// Arrays of ContractionHierarchyData, owned either by one or by the mapped file
+struct ContractionHierarchy {
+    int width = 0, height = 0;
+    size_t nodeCount = 0, edgeCount = 0;
+    const float *xs = nullptr, *ys = nullptr;
+    const uint32_t *levels = nullptr;
+    const uint32_t *firstEdge = nullptr;
+    const uint32_t *targets = nullptr;
+    const float *weights = nullptr;
+    const uint32_t *middles = nullptr;
+    MappedFile file;
+};
+
+void buildContractionHierarchy(const RoadGraph &graph, const ContractionOptions &options,
+                               ContractionHierarchyData &data, ContractionStats &stats);
+
+// Binary file, little endian: a 32-byte header with the magic, version, image size
+// and node and edge counts, then xs, ys, levels, firstEdge, targets, weights and
+// middles as stored in ContractionHierarchyData
+bool saveContractionHierarchy(const char *path, const ContractionHierarchyData &data);
+
+// Maps the file and checks that every edge leads up and every shortcut bypasses a
+// lower node, so unpacking always ends
+bool loadContractionHierarchy(const char *path, ContractionHierarchy &hierarchy);
+
+// Points the hierarchy at data, which must outlive it
+void viewContractionHierarchy(const ContractionHierarchyData &data, ContractionHierarchy &hierarchy);
+void closeContractionHierarchy(ContractionHierarchy &hierarchy);
+
+// ============================================================================
+// HIERARCHY QUERY
+// ============================================================================
+// Bidirectional Dijkstra over the upward edges, with the scratch of RoadRouter:
+// sized when the query is created, stamped per query rather than cleared. A
+// direction stops once its closest open node is no nearer than the best meeting
+// found so far.
+struct HierarchyQuery {
+    const ContractionHierarchy *hierarchy = nullptr;
+    SpatialGrid nodes; // Node ids by pixel position
+    float snapRadius = 0.0f;
+
+    // Forward search from the source at 0, backward from the target at 1
+    std::vector<float> distances[2];
+    std::vector<uint32_t> parents[2];
+    std::vector<uint32_t> reachedIn[2];
+    std::vector<RoadHeapEntry> heaps[2];
+    uint32_t query = 0;
+
+    std::vector<uint32_t> chain;  // Hierarchy nodes of the last path, before unpacking
+    std::vector<uint32_t> unpack; // Pending node pairs while unpacking shortcuts
+
+    std::vector<uint32_t> path; // Street nodes of the last path found, source first
+    float pathLength = 0.0f;    // Pixels
+    size_t settled = 0;         // Nodes settled by both searches
+};
+
+// The hierarchy must outlive the query
+void createHierarchyQuery(HierarchyQuery &query, const ContractionHierarchy &hierarchy, float snapRadius);
+
+// Nearest node within the snap radius of a pixel position, -1 if there is none
+int32_t snapToHierarchy(const HierarchyQuery &query, float x, float y);
+
+// Fills path and pathLength, false if the target cannot be reached from the source
+bool findHierarchyPath(HierarchyQuery &query, uint32_t source, uint32_t target);
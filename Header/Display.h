@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Headless.h"
+#include "InputQueue.h"
+
+// ============================================================================
+// DISPLAY
+// ============================================================================
+// Either a fullscreen GLFW window or a headless EGL context. The main loop only
+// talks to the display through these functions, so the walking and measuring
+// code paths run the same way in both.
+struct Display {
+    GLFWwindow *window = nullptr; // Null when rendering headless
+    HeadlessContext headless;
+    bool closeRequested = false;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    // Headless only: when set, time advances by exactly this much per presented frame
+    // and frames are not throttled, which makes benchmark runs reproducible
+    double fixedTimeStep = 0.0;
+    double virtualTime = 0.0;
+};
+
+// Fullscreen window on the primary monitor, input callbacks feed the queue
+bool createWindowDisplay(Display &display, InputQueue &inputQueue);
+bool createHeadlessDisplay(Display &display, int width, int height);
+void destroyDisplay(Display &display);
+
+GLADloadproc getDisplayLoader(const Display &display);
+
+// Needs loaded GL functions, creates the offscreen framebuffer in headless mode
+void setupDisplayFramebuffer(Display &display);
+
+// Seconds since start, same clock as the input event timestamps
+double getDisplayTime(const Display &display);
+
+bool shouldCloseDisplay(const Display &display);
+void requestDisplayClose(Display &display);
+
+// Window size is in screen coordinates (cursor, HUD layout), framebuffer size in pixels
+void getDisplaySize(const Display &display, int &screenWidth, int &screenHeight,
+                    int &framebufferWidth, int &framebufferHeight);
+
+// Framebuffer the finished frame goes to, 0 for the window
+unsigned int getDisplayFramebuffer(const Display &display);
+
+// Latest cursor position, headless mode has no pointer and uses the one from the event stream
+void getDisplayCursor(const Display &display, const InputState &input, double &x, double &y);
+
+void presentDisplay(Display &display);
+
+// Sleeps out the rest of the frame, a window keeps receiving input events meanwhile
+void waitDisplay(const Display &display, double seconds);
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// ============================================================================
+// FENWICK TREE
+// ============================================================================
+// Binary indexed tree over positions 0..size-1: point update and prefix sum in
+// O(log n), plus a descent that finds the position holding a given rank when
+// all values are non-negative.
+template <typename T>
+struct FenwickTree {
+    std::vector<T> tree; // 1-based, tree[0] unused
+    size_t size = 0;
+};
+
+// O(n) build, value(i) supplies the value at position i
+template <typename T, typename ValueAt>
+void buildFenwick(FenwickTree<T> &fenwick, const size_t size, ValueAt value) {
+    fenwick.size = size;
+    fenwick.tree.assign(size + 1, T{});
+
+    for (size_t i = 1; i <= size; ++i) {
+        fenwick.tree[i] += value(i - 1);
+        const size_t parent = i + (i & (~i + 1));
+        if (parent <= size) {
+            fenwick.tree[parent] += fenwick.tree[i];
+        }
+    }
+}
+
+template <typename T>
+void addFenwick(FenwickTree<T> &fenwick, const size_t position, const T delta) {
+    for (size_t i = position + 1; i <= fenwick.size; i += i & (~i + 1)) {
+        fenwick.tree[i] += delta;
+    }
+}
+
+// Sum of the first count values
+template <typename T>
+T prefixFenwick(const FenwickTree<T> &fenwick, const size_t count) {
+    T sum{};
+    for (size_t i = count; i > 0; i -= i & (~i + 1)) {
+        sum += fenwick.tree[i];
+    }
+    return sum;
+}
+
+// Number of leading positions whose running sum stays <= target, which is the
+// position that contains rank target when the values are counts
+template <typename T>
+size_t findFenwick(const FenwickTree<T> &fenwick, T target) {
+    size_t step = 1;
+    while (step * 2 <= fenwick.size) {
+        step *= 2;
+    }
+
+    size_t position = 0;
+    for (; step > 0; step /= 2) {
+        const size_t next = position + step;
+        if (next <= fenwick.size && fenwick.tree[next] <= target) {
+            position = next;
+            target -= fenwick.tree[next];
+        }
+    }
+    return position;
+}
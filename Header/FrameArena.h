@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// ============================================================================
+// FRAME ARENA
+// ============================================================================
+// Bump allocator for data that lives for a single frame: draw lists, matrices,
+// formatted text. Allocating is a pointer bump, nothing is freed individually,
+// and the whole arena is reset at the top of every loop iteration.
+//
+// When a frame needs more than the capacity the rest is served from heap
+// blocks, which are released by the next reset. The reset then grows the main
+// block to the high-water mark, so overflow only happens on a new peak.
+struct FrameArena {
+    unsigned char *memory = nullptr;
+    size_t capacity = 0;
+    size_t offset = 0;
+
+    void *overflowBlocks = nullptr; // Singly linked through the first pointer of every block
+    size_t overflowBytes = 0;       // Served from overflow blocks this frame
+    size_t highWater = 0;           // Most bytes a frame has needed, overflow included
+};
+
+void createFrameArena(FrameArena &arena, size_t capacity);
+void destroyFrameArena(FrameArena &arena);
+void resetFrameArena(FrameArena &arena);
+
+// Never returns nullptr, alignment must be a power of two
+void *allocateFromArena(FrameArena &arena, size_t size, size_t alignment);
+
+// STL allocator over a frame arena. Deallocation is a no-op, so containers
+// must not outlive the frame they were created in.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena &arena) : arena(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(const size_t count) {
+        return static_cast<T *>(allocateFromArena(*arena, count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+
+    FrameArena *arena;
+};
+
+// Growing one of these leaves the old storage behind until the reset, reserve when the size is known
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+
+#include "Georeference.h"
+
+// ============================================================================
+// GEODESIC DISTANCES
+// ============================================================================
+// Ground distances between geographic coordinates, in metres and in double.
+// Longitudes and latitudes are in degrees.
+//   Haversine - great circle on the mean Earth sphere, about 0.3% off the ellipsoid
+//   Vincenty  - inverse problem on the WGS 84 ellipsoid, sub-millimetre. It falls
+//               back to haversine for the nearly antipodal pairs it cannot solve.
+enum class GeodesicMethod {
+    Haversine,
+    Vincenty
+};
+
+constexpr double MEAN_EARTH_RADIUS = 6371008.8;
+
+double haversineDistance(double longitude1, double latitude1, double longitude2, double latitude2);
+double vincentyDistance(double longitude1, double latitude1, double longitude2, double latitude2);
+double geodesicDistance(GeodesicMethod method, double longitude1, double latitude1, double longitude2,
+                        double latitude2);
+
+// ============================================================================
+// COMPENSATED SUMS
+// ============================================================================
+// Neumaier summation, the error stays at one rounding of the total however many
+// small steps are added, where a plain float total stops growing after a while
+struct DistanceSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+};
+
+void addDistance(DistanceSum &total, double distance);
+double getDistance(const DistanceSum &total);
+
+// ============================================================================
+// POLYLINES
+// ============================================================================
+// lengths[i] receives the length of segment i, count - 1 values. Haversine goes
+// through unit vectors, so every point is converted once and the chord lengths
+// run through a SIMD kernel.
+void computeGeodesicLengths(GeodesicMethod method, const double *longitudes, const double *latitudes, size_t count,
+                            double *lengths);
+double sumGeodesicLengths(GeodesicMethod method, const double *longitudes, const double *latitudes, size_t count);
+
+// Polylines in georeferenced metres, converted to geographic coordinates a chunk
+// at a time. Maps without a geographic projection are measured in the plane.
+struct MapGeodesic {
+    const Georeference *georeference = nullptr;
+    GeodesicMethod method = GeodesicMethod::Vincenty;
+};
+
+// The context is a MapGeodesic, the signature matches RouteLengthFunction
+double measureMapPolyline(const void *context, const float *xs, const float *ys, size_t count);
+
+// Ground distance between two map space points, all in double for short steps
+double measureMapStep(const MapGeodesic &geodesic, double mapX1, double mapY1, double mapX2, double mapY2);
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+
+#include "PointKernels.h"
+
+// ============================================================================
+// GEOREFERENCE
+// ============================================================================
+// Ties the map texture to the ground. Coordinates move between four spaces:
+//   pixel  - image pixels, origin at the centre of the top left pixel, y down
+//   map    - [-1, 1] x [-1, 1] over the texture, y up. Measuring mode NDC is map
+//            space, walking mode offsets the map by mapPos and scales it by mapScale
+//   world  - projected coordinates of the world file, kept in double
+//   metres - metres east and north of the map centre, small enough for float,
+//            routes are stored and measured in this space
+//
+// The world file is the usual six-line affine (map.jgw next to map.jpg). For Web
+// Mercator world files metres use the scale factor at the latitude of the map
+// centre, which stays within 0.1% over a city-sized map.
+enum class MapProjection {
+    LocalMetric, // World file units are metres on a local plane
+    WebMercator  // World file units are EPSG:3857 metres
+};
+
+// x' = a x + b y + c, y' = d x + e y + f
+struct AffineTransform {
+    double a = 1.0, b = 0.0, c = 0.0;
+    double d = 0.0, e = 1.0, f = 0.0;
+};
+
+struct Georeference {
+    MapProjection projection = MapProjection::LocalMetric;
+    int imageWidth = 1, imageHeight = 1;
+
+    AffineTransform pixelToWorld, worldToPixel;
+    AffineTransform mapToPixel, pixelToMap;
+    AffineTransform mapToMetres, metresToMap;
+    double centreX = 0.0, centreY = 0.0; // World coordinates of the map centre
+    bool loaded = false;
+};
+
+AffineTransform composeAffine(const AffineTransform &outer, const AffineTransform &inner);
+AffineTransform invertAffine(const AffineTransform &transform);
+PointTransform toPointTransform(const AffineTransform &transform);
+
+void applyAffine(const AffineTransform &transform, double x, double y, double &outX, double &outY);
+
+// Linear part only, for displacements
+void applyAffineToVector(const AffineTransform &transform, double x, double y, double &outX, double &outY);
+
+// Reads the world file of an imageWidth x imageHeight image. On failure the
+// error is reported and the map falls back to one metre per pixel.
+bool loadGeoreference(Georeference &geo, const char *worldFilePath, int imageWidth, int imageHeight,
+                      MapProjection projection);
+
+// NDC to map space for a view that draws the map centred at (mapPosX, mapPosY)
+// with a quad scale of mapScale, as renderWalkingMap and renderMeasuringMap do
+AffineTransform ndcToMapTransform(float mapPosX, float mapPosY, float mapScale);
+
+// Batch transforms through the point kernels, output arrays may be the input arrays
+void mapToMetres(const Georeference &geo, const float *xs, const float *ys, size_t count, float *outXs, float *outYs);
+void metresToMap(const Georeference &geo, const float *xs, const float *ys, size_t count, float *outXs, float *outYs);
+void mapToPixels(const Georeference &geo, const float *xs, const float *ys, size_t count, float *outXs, float *outYs);
+void pixelsToMap(const Georeference &geo, const float *xs, const float *ys, size_t count, float *outXs, float *outYs);
+
+// World coordinates need double, metres are converted back around the map centre
+void metresToWorld(const Georeference &geo, const float *xs, const float *ys, size_t count, double *outXs,
+                   double *outYs);
+
+// Degrees, available for Web Mercator world files only
+bool worldToGeographic(const Georeference &geo, double x, double y, double &longitude, double &latitude);
+bool metresToGeographic(const Georeference &geo, const float *xs, const float *ys, size_t count, double *longitudes,
+                        double *latitudes);
+bool geographicToWorld(const Georeference &geo, double longitude, double latitude, double &x, double &y);
+bool geographicToMetres(const Georeference &geo, const double *longitudes, const double *latitudes, size_t count,
+                        float *outXs, float *outYs);
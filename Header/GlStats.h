@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+
+// ============================================================================
+// GL CALL STATISTICS
+// ============================================================================
+// Optional instrumentation of the GL function table. installGlStats swaps the
+// glad_gl* pointers loaded by gladLoadGLLoader for counting wrappers, so the
+// rest of the code keeps calling gl* as usual. Every count is attributed to
+// the subsystem set on the calling thread, see GlSubsystemScope.
+enum class GlCounter {
+    DrawCalls,
+    Binds,          // Program, vertex array, buffer, texture and framebuffer binds
+    StateChanges,   // Enable/disable, blend, stencil, viewport, active texture unit
+    UniformUploads,
+    BufferUploads,  // Including writes into persistently mapped buffers
+    TextureUploads,
+    UploadBytes,
+    Count
+};
+
+enum class GlSubsystem {
+    Other,
+    Map,
+    Overlay,
+    Resolve,
+    Hud,
+    Badge,
+    Profiler,  // The profiler overlay itself
+    LateLatch,
+    Loading,
+    Count
+};
+
+constexpr int GL_COUNTER_COUNT = static_cast<int>(GlCounter::Count);
+constexpr int GL_SUBSYSTEM_COUNT = static_cast<int>(GlSubsystem::Count);
+
+const char *getGlCounterName(GlCounter counter);
+const char *getGlSubsystemName(GlSubsystem subsystem);
+
+struct GlFrameStats {
+    uint64_t counts[GL_SUBSYSTEM_COUNT][GL_COUNTER_COUNT]{};
+
+    uint64_t get(const GlSubsystem subsystem, const GlCounter counter) const {
+        return counts[static_cast<int>(subsystem)][static_cast<int>(counter)];
+    }
+
+    uint64_t total(GlCounter counter) const;
+};
+
+// Call once after gladLoadGLLoader, counts stay at zero until then
+void installGlStats();
+bool isGlStatsInstalled();
+
+// Moves everything counted since the last call into frame and starts over
+void collectGlFrameStats(GlFrameStats &frame);
+
+// Data written through a mapped pointer never passes through GL, the owner reports it here
+void recordGlMappedUpload(uint64_t bytes);
+
+// Sets the subsystem GL calls on this thread are attributed to, returns the previous one
+GlSubsystem setGlSubsystem(GlSubsystem subsystem);
+
+class GlSubsystemScope {
+public:
+    explicit GlSubsystemScope(const GlSubsystem subsystem) : previous(setGlSubsystem(subsystem)) {}
+    ~GlSubsystemScope() { setGlSubsystem(previous); }
+
+    GlSubsystemScope(const GlSubsystemScope &) = delete;
+    GlSubsystemScope &operator=(const GlSubsystemScope &) = delete;
+
+private:
+    GlSubsystem previous;
+};
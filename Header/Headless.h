@@ -0,0 +1,31 @@
+#pragma once
+
+// ============================================================================
+// HEADLESS CONTEXT
+// ============================================================================
+// OpenGL context without a window, created through EGL (surfaceless when the
+// driver supports it, a 1x1 pbuffer otherwise). Frames are rendered into an
+// offscreen framebuffer of the requested size, which takes the place of the
+// window's default framebuffer. Mesa's llvmpipe is enough to run it.
+struct HeadlessContext {
+    void *display = nullptr; // EGLDisplay, kept opaque so EGL headers stay out of the rest of the code
+    void *context = nullptr; // EGLContext
+    void *surface = nullptr; // EGLSurface, only used when surfaceless contexts are unavailable
+
+    unsigned int framebuffer = 0;
+    unsigned int colorRenderbuffer = 0;
+    unsigned int stencilRenderbuffer = 0; // Depth and stencil, the stencil is used by polygon fills
+    int width = 0;
+    int height = 0;
+};
+
+// Creates the EGL context and makes it current, GL functions are not loaded yet
+bool createHeadlessContext(HeadlessContext &headless, int width, int height);
+void *getHeadlessProcAddress(const char *name);
+
+// Needs loaded GL functions
+void createHeadlessFramebuffer(HeadlessContext &headless);
+void destroyHeadlessContext(HeadlessContext &headless);
+
+// Writes the current contents of the offscreen framebuffer as a binary PPM
+bool saveHeadlessFrame(const HeadlessContext &headless, const char *filePath);
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// ============================================================================
+// INPUT EVENTS
+// ============================================================================
+enum class InputEventType {
+    Key,
+    MouseButton,
+    CursorPos
+};
+
+struct InputEvent {
+    InputEventType type;
+    int code;   // GLFW key or mouse button, unused for cursor events
+    int action; // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+    int mods;
+    double x, y; // Cursor position in window coordinates when the event arrived
+    double time; // glfwGetTime() when the event arrived
+};
+
+// Lock-free single-producer / single-consumer ring buffer. The GLFW callbacks
+// are the producer, the main loop drains it in order once per frame.
+//
+// Cursor moves may only fill the ring up to the reserved slots. A move that finds
+// no room is held by the producer, replacing any move held before it, and goes
+// out with the next flush or ahead of the next key or button event. A long stall
+// so loses intermediate positions but never a key or button event, and held keys
+// are always released.
+class InputQueue {
+public:
+    static constexpr size_t CAPACITY = 1024;
+    static constexpr size_t RESERVED = 128; // Slots only key and button events take
+
+    // Producer side, false if the event was dropped
+    bool push(const InputEvent &event);
+    // Producer side, publishes the held cursor move once there is room for it
+    void flush();
+
+    bool pop(InputEvent &event);
+    // Events dropped since the last call, for the consumer to report
+    size_t takeDroppedCount();
+
+private:
+    bool publish(const InputEvent &event, size_t limit);
+
+    InputEvent events[CAPACITY]{};
+    std::atomic<size_t> head{0}; // Next slot to read, owned by the consumer
+    std::atomic<size_t> tail{0}; // Next slot to write, owned by the producer
+    std::atomic<size_t> dropped{0};
+
+    // Newest cursor move not yet published, owned by the producer
+    InputEvent pendingMove{};
+    bool hasPendingMove = false;
+};
+
+// Held keys/buttons and the last cursor position, rebuilt from the event stream
+struct InputState {
+    bool keys[GLFW_KEY_LAST + 1]{};
+    bool buttons[GLFW_MOUSE_BUTTON_LAST + 1]{};
+    double cursorX = 0.0;
+    double cursorY = 0.0;
+};
+
+void applyInputEvent(InputState &state, const InputEvent &event);
+bool isPressEvent(const InputEvent &event, InputEventType type, int code);
+
+// Key press with at least the given modifiers held, e.g. GLFW_MOD_CONTROL
+bool isShortcutEvent(const InputEvent &event, int key, int mods);
+
+// Routes key, mouse button and cursor callbacks of the window into the queue
+void installInputCallbacks(GLFWwindow *window, InputQueue &queue);
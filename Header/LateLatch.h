@@ -0,0 +1,30 @@
+#pragma once
+#include <glad/glad.h>
+
+// ============================================================================
+// LATE-LATCHED CURSOR
+// ============================================================================
+// The cursor position is written into a persistently mapped uniform buffer right
+// before the frame is submitted, after the draws that read it were recorded.
+// Slots are ring-buffered and fenced so the CPU never overwrites a slot the GPU
+// may still be reading for an earlier frame.
+struct LateLatch {
+    static constexpr int SLOT_COUNT = 3;
+    static constexpr GLuint BINDING = 0; // Matches "binding = 0" of the LateLatch block in hud.vert
+
+    unsigned int buffer = 0;
+    unsigned char *mapped = nullptr;
+    GLsizeiptr slotStride = 0;
+    GLsync fences[SLOT_COUNT]{};
+    int slot = 0;
+};
+
+void createLateLatch(LateLatch &latch);
+void destroyLateLatch(LateLatch &latch);
+
+// Waits for the current slot to be free, binds it and seeds it with the cursor position.
+// Cursor coordinates are in window coordinates, as reported by glfwGetCursorPos.
+void beginLateLatchFrame(LateLatch &latch, double cursorX, double cursorY, int screenWidth, int screenHeight);
+
+// Stores the freshly sampled cursor and fences the slot, call right before presenting
+void latchCursor(LateLatch &latch, double cursorX, double cursorY, int screenWidth, int screenHeight);
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// LZ COMPRESSION
+// ============================================================================
+// Byte-oriented LZ77 in the style of LZ4, for blocks of at most 64 KB. Every
+// sequence is a token byte, with the literal run length in the high nibble and
+// the match length minus four in the low one, followed by extra length bytes
+// when a nibble is 15, the literals and a two-byte match offset. The last
+// sequence has literals only.
+//
+// Matches are found through a single-probe hash table of four-byte prefixes, so
+// compression is one pass and decompression is copies only. Works best on data
+// with repeated byte patterns, e.g. delta-encoded coordinates of a regular track.
+constexpr size_t LZ_MAX_INPUT = 65536;
+
+// Worst case output size for an input of size bytes
+constexpr size_t lzBound(const size_t size) {
+    return size + size / 255 + 16;
+}
+
+// Returns the compressed size, output must hold lzBound(size) bytes
+size_t compressLz(const uint8_t *input, size_t size, uint8_t *output);
+
+// False if the data is malformed or does not decompress to exactly outputSize bytes
+bool decompressLz(const uint8_t *input, size_t size, uint8_t *output, size_t outputSize);
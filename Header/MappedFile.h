@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+// ============================================================================
+// MEMORY-MAPPED FILES
+// ============================================================================
+// Read-only view of a whole file. Pages are faulted in by the OS as they are
+// touched, so large files are read without copying them into the heap.
+struct MappedFile {
+    const char *data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+};
+
+// Reports the error and returns false if the file cannot be opened. Empty files
+// open with a null data pointer.
+bool openMappedFile(MappedFile &mapped, const char *path);
+void closeMappedFile(MappedFile &mapped);
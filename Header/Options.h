@@ -0,0 +1,32 @@
+#pragma once
+
+// ============================================================================
+// COMMAND LINE OPTIONS
+// ============================================================================
+struct AppOptions {
+    bool dynamicResolution = false; // Render the scene into a scaled target driven by GPU frame time
+    double frameBudgetMs = 0.0;     // GPU budget for dynamic resolution, 0 means the target frame time
+
+    bool headless = false;          // Render offscreen through EGL instead of a fullscreen window
+    int headlessWidth = 1920;
+    int headlessHeight = 1080;
+    long long maxFrames = 0;        // Stop after this many frames, 0 runs until the window is closed
+    const char *screenshotPath = nullptr; // Headless only, the last frame is written here as PPM
+
+    const char *benchmarkPath = nullptr; // Scenario script, runs headless with a fixed time step and no frame cap
+    const char *reportPath = nullptr;    // Benchmark JSON report, printed to stdout when not set
+    const char *baselinePath = nullptr;  // Report to compare against, regressions make the run fail
+    double regressionThreshold = 10.0;   // Allowed slowdown against the baseline, in percent
+    int warmupFrames = 10;
+    bool assertNoAllocations = false;    // Fail the benchmark if a frame after warmup allocates, needs KOSTUR_TRACK_ALLOCATIONS
+
+    const char *tracePath = nullptr;     // Chrome trace JSON of the whole run, written on exit
+    bool glStats = false;                // Count GL calls per subsystem for the F3 overlay, always on for benchmarks
+
+    const char *trackPath = nullptr;     // GPX or CSV track loaded into the measuring route at startup
+    const char *routePath = nullptr;     // Route file for Ctrl+S and Ctrl+O, loaded at startup when given
+    bool compressRoute = false;          // Save route blocks through the LZ pass
+    const char *hierarchyPath = nullptr; // Contraction hierarchy for routed measuring, as written by KosturContract
+};
+
+AppOptions parseOptions(int argc, char **argv);
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// POINT KERNELS
+// ============================================================================
+// Loops over points kept as separate x and y arrays. Every kernel has a scalar,
+// an SSE2 and an AVX2 version, the best one the CPU supports is picked on first
+// use. Arrays need no particular alignment, but 32-byte aligned ones load fastest.
+//
+// Segment lengths are computed in float and accumulated in double by every
+// version, so the versions differ only in summation order.
+enum class PointKernelLevel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// x' = a x + b y + c, y' = d x + e y + f
+struct PointTransform {
+    float a, b, c, d, e, f;
+};
+
+// Empty bounds have min > max
+struct PointBounds {
+    float minX, minY, maxX, maxY;
+};
+
+PointKernelLevel getPointKernelLevel();
+
+// Requests above what the CPU supports are clamped, lowering is meant for comparisons
+void setPointKernelLevel(PointKernelLevel level);
+const char *getPointKernelName(PointKernelLevel level);
+
+// Sum of the count - 1 segment lengths between consecutive points
+double sumSegmentLengths(const float *xs, const float *ys, size_t count);
+
+// lengths[i] receives the length of the segment from point i to i + 1, count - 1 values
+void computeSegmentLengths(const float *xs, const float *ys, size_t count, float *lengths);
+
+// distances[i] receives start plus the length of the polyline up to point i,
+// count values. Returns the distance at the last point.
+double accumulateDistances(const float *xs, const float *ys, size_t count, double start, double *distances);
+
+// Index of the point closest to (x, y), -1 when count is 0. The lowest index wins ties.
+int64_t findNearestPoint(const float *xs, const float *ys, size_t count, float x, float y, float &distanceSquared);
+
+// Output arrays may be the input arrays
+void transformPoints(const float *xs, const float *ys, size_t count, const PointTransform &transform,
+                     float *outXs, float *outYs);
+
+// lengths[i] receives the distance from point i to i + 1 in 3D, count - 1 values, in double
+void computeChordLengths(const double *xs, const double *ys, const double *zs, size_t count, double *lengths);
+
+PointBounds emptyBounds();
+void expandBounds(const float *xs, const float *ys, size_t count, PointBounds &bounds);
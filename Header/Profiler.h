@@ -0,0 +1,71 @@
+#pragma once
+#include <chrono>
+#include <glad/glad.h>
+
+#include "GlStats.h"
+
+// ============================================================================
+// PROFILER
+// ============================================================================
+// Wraps every render pass in a GL_TIME_ELAPSED query and a CPU timer. Queries
+// live in a ring several frames deep and a frame's results are only read back
+// once the driver reports all of them available, so profiling never stalls.
+enum class ProfilePass {
+    Map,
+    Overlay, // Pin, measurement points and lines, hover marker
+    Resolve, // Dynamic-resolution upscale, only when enabled
+    Hud,
+    Badge,
+    Count
+};
+
+constexpr int PROFILE_PASS_COUNT = static_cast<int>(ProfilePass::Count);
+
+const char *getProfilePassName(ProfilePass pass);
+
+struct ProfilerFrame {
+    unsigned int queries[PROFILE_PASS_COUNT]{};
+    bool used[PROFILE_PASS_COUNT]{};
+    double cpuMs[PROFILE_PASS_COUNT]{};
+    bool pending = false;
+};
+
+struct Profiler {
+    static constexpr int RING_SIZE = 4;
+
+    ProfilerFrame frames[RING_SIZE];
+    int current = 0;
+    bool frameActive = false;
+
+    int activePass = -1;
+    int tracedPass = -1; // Traced even on frames whose queries are skipped
+    GlSubsystem previousGlSubsystem = GlSubsystem::Other;
+    std::chrono::high_resolution_clock::time_point passStart;
+
+    // Latest frame whose GPU results have resolved
+    double gpuMs[PROFILE_PASS_COUNT]{};
+    double cpuMs[PROFILE_PASS_COUNT]{};
+    double gpuTotalMs = 0.0;
+    double cpuTotalMs = 0.0;
+    bool hasNewResult = false;
+
+    bool overlayVisible = false;
+};
+
+void createProfiler(Profiler &profiler);
+void destroyProfiler(Profiler &profiler);
+
+// A frame is skipped (passes become no-ops) while its ring slot is still waiting on the GPU
+void beginProfilerFrame(Profiler &profiler);
+void endProfilerFrame(Profiler &profiler);
+
+// Passes must not nest, GL allows a single active GL_TIME_ELAPSED query.
+// GL calls inside a pass are attributed to the matching GlSubsystem.
+void beginProfilerPass(Profiler &profiler, ProfilePass pass);
+void endProfilerPass(Profiler &profiler);
+
+// Reads back resolved frames in submission order, returns true if a new frame was published
+bool collectProfiler(Profiler &profiler);
+
+// Emits the published GPU pass times as trace counters
+void traceProfilerResults(const Profiler &profiler);
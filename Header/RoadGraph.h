@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// ROAD GRAPH
+// ============================================================================
+// Streets traced from the map image, for routing and snapping. Extraction runs
+// in four passes over the pixels:
+//
+//   classify - every pixel is tested against a few colour ranges, 16 or 32
+//              pixels at a time at the kernel level of PointKernels
+//   fill     - a small closing bridges street names printed across the roads,
+//              and enclosed specks of other colours left over become road, so
+//              labels leave no gaps or holes
+//   thin     - Zhang-Suen thinning to a one pixel wide skeleton. Each sub-
+//              iteration splits the rows into bands on worker threads, and
+//              rows whose neighbourhood did not change are skipped.
+//   trace    - skeleton pixels with other than two branches become nodes and
+//              the paths between them edges. Paths are simplified and their
+//              corners kept as nodes, so every edge is a straight line, and
+//              short dead ends left by bumps in the mask are pruned.
+//
+// The graph is kept in CSR form: the edges leaving node i are firstEdge[i] up to
+// firstEdge[i + 1] in targets and lengths, every street once in each direction.
+// Nodes are in image pixels, x right and y down from the top left corner, and
+// lengths in pixels along the skeleton.
+struct RoadColorRange {
+    uint8_t min[3]; // RGB, inclusive
+    uint8_t max[3];
+};
+
+struct RoadGraphOptions {
+    // White streets and yellow main roads of the shipped map
+    std::vector<RoadColorRange> colors = {
+        {{236, 236, 236}, {255, 255, 255}},
+        {{224, 208, 64}, {255, 255, 160}}
+    };
+    int closeRadius = 2;            // Pixels, gaps this narrow are closed before filling holes
+    size_t maxHoleSize = 160;       // Pixels, larger enclosed areas are blocks rather than labels
+    float simplifyTolerance = 1.5f; // Pixels
+    float minSpurLength = 12.0f;    // Pixels, shorter dead ends are pruned
+    size_t threads = 0;             // 0 for one per hardware thread
+};
+
+struct RoadGraph {
+    int width = 0, height = 0; // Of the image the graph was traced from
+    std::vector<float> xs, ys; // Per node
+    std::vector<uint32_t> firstEdge; // Node count + 1 offsets into targets and lengths
+    std::vector<uint32_t> targets;
+    std::vector<float> lengths;
+};
+
+struct RoadGraphStats {
+    size_t roadPixels = 0;
+    size_t filledPixels = 0;
+    size_t skeletonPixels = 0;
+    size_t iterations = 0; // Zhang-Suen iterations, two sub-iterations each
+    size_t prunedSpurs = 0;
+    double classifySeconds = 0.0;
+    double thinSeconds = 0.0;
+    double traceSeconds = 0.0;
+};
+
+// mask[i] receives 1 if RGBA pixel i falls in any of the ranges, 0 otherwise
+void classifyRoadPixels(const uint8_t *rgba, size_t count, const RoadColorRange *ranges, size_t rangeCount,
+                        uint8_t *mask);
+
+// Thins a 0/1 mask of width x height in place, returns the number of iterations
+size_t thinRoadMask(uint8_t *mask, int width, int height, size_t threads);
+
+// Traces the graph from RGBA pixels, rows from the top
+void extractRoadGraph(const uint8_t *rgba, int width, int height, const RoadGraphOptions &options, RoadGraph &graph,
+                      RoadGraphStats &stats);
+
+// Loads the image like loadImageToTexture, but upright in memory, and traces its streets
+bool loadImageToRoadGraph(const char *filePath, const RoadGraphOptions &options, RoadGraph &graph,
+                          RoadGraphStats &stats);
+
+// Binary graph file, little endian: a 32-byte header with the magic, version,
+// image size and node and edge counts, then xs, ys, firstEdge, targets and
+// lengths as stored in RoadGraph
+bool saveRoadGraph(const char *path, const RoadGraph &graph);
+bool loadRoadGraph(const char *path, RoadGraph &graph);
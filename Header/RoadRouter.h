@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "RoadGraph.h"
+#include "SpatialGrid.h"
+
+// ============================================================================
+// ROAD ROUTER
+// ============================================================================
+// Shortest paths over a RoadGraph with A*. The heuristic is the straight line
+// to the target, which never overestimates since every edge is at least as long
+// as its chord. The open set is a binary heap with stale entries skipped when
+// popped rather than a decrease-key, so it never holds more entries than there
+// are directed edges.
+//
+// All scratch is sized for the graph when the router is created. Per-node state
+// is tagged with the query that wrote it instead of being cleared, so a query
+// touches only the nodes it visits and never allocates.
+//
+// Points are snapped to the nearest node within the snap radius through a
+// SpatialGrid over the graph's pixels.
+struct RoadHeapEntry {
+    float estimate; // Distance so far plus the heuristic
+    uint32_t node;
+};
+
+struct RoadRouter {
+    const RoadGraph *graph = nullptr;
+    SpatialGrid nodes; // Node ids by pixel position
+    float snapRadius = 0.0f;
+
+    std::vector<float> distances;    // Best known distance from the source
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> reachedIn; // Query that set distances and parents
+    std::vector<uint32_t> closedIn;  // Query that settled the node
+    std::vector<RoadHeapEntry> heap;
+    uint32_t query = 0;
+
+    std::vector<uint32_t> path; // Nodes of the last path found, source first
+    float pathLength = 0.0f;    // Pixels
+    size_t settled = 0;         // Nodes settled by the last query
+};
+
+// The graph must outlive the router
+void createRoadRouter(RoadRouter &router, const RoadGraph &graph, float snapRadius);
+
+// Nearest node within the snap radius of a pixel position, -1 if there is none
+int32_t snapToRoad(const RoadRouter &router, float x, float y);
+
+// Fills path and pathLength, false if the target cannot be reached from the source
+bool findRoadPath(RoadRouter &router, uint32_t source, uint32_t target);
+
+// Measuring-mode map space, [-1, 1] with y up, to pixels of a width x height graph
+// image and back
+void mapToRoadPixels(int width, int height, float mapX, float mapY, float &x, float &y);
+void roadPixelsToMap(int width, int height, float x, float y, float &mapX, float &mapY);
@@ -0,0 +1,62 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "RouteStore.h"
+
+// ============================================================================
+// ROUTE VERTEX BUFFER
+// ============================================================================
+// The part of a route worth drawing at the current zoom, kept on the GPU and
+// rebuilt only when the route or the tolerance changes. Segments and vertex
+// markers are instances of the unit quad, read straight from the buffer by
+// hud.vert, so a route is two draws however long it is.
+//
+// The line keeps the vertices whose Visvalingam rank reaches tolerance squared,
+// a triangle area in route units. Every vertex gets a marker while the route has
+// at most maxMarkers of them, longer routes mark only the vertices drawn.
+//
+// Rebuilds are compared with what the buffer already holds and only the range
+// from the first changed vertex on is uploaded, so appending to a long route
+// sends the last few vertices rather than the whole route.
+//
+// The line vertices can also be drawn as a triangle fan, for a stencil fill of
+// the route closed into a polygon.
+struct RouteBuffer {
+    // Instance attributes, matching hud.vert
+    static constexpr GLuint START_LOCATION = 2;
+    static constexpr GLuint END_LOCATION = 3;
+
+    unsigned int vertexArray = 0;
+    unsigned int fillVertexArray = 0; // Line vertices as aPos, for the fan
+    unsigned int buffer = 0;
+    size_t capacity = 0;       // Vertices the GPU buffer holds
+    std::vector<float> staging; // Interleaved x, y in route units
+    std::vector<float> uploaded; // Current contents of the buffer
+    size_t maxMarkers = 0;
+
+    GLuint lineFirst = 0, lineCount = 0;
+    GLuint markerFirst = 0, markerCount = 0;
+
+    uint64_t revision = 0;
+    float tolerance = -1.0f;
+};
+
+// Shares the unit quad of setupBuffers, reserves room for reservedVertices
+void createRouteBuffer(RouteBuffer &routeBuffer, unsigned int quadBuffer, unsigned int quadIndices,
+                       size_t reservedVertices, size_t maxMarkers);
+void destroyRouteBuffer(RouteBuffer &routeBuffer);
+
+// Ranks edited blocks and refills the buffer if the route or the tolerance changed,
+// returns whether it did
+bool updateRouteBuffer(RouteBuffer &routeBuffer, RouteStore &route, float tolerance);
+
+// Bind the vertex array and draw, the program and its uniforms are set by the caller
+void drawRouteSegments(const RouteBuffer &routeBuffer);
+void drawRouteMarkers(const RouteBuffer &routeBuffer);
+
+// Fan from the first line vertex over the rest, inverting the stencil under every
+// triangle leaves the inside of the closed route odd
+void drawRouteFan(const RouteBuffer &routeBuffer);
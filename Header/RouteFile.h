@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Georeference.h"
+#include "MappedFile.h"
+#include "RouteStore.h"
+#include "TrackImport.h"
+
+// ============================================================================
+// ROUTE FILES
+// ============================================================================
+// Binary route format, little endian:
+//
+//   header  - 64 bytes: magic, version, flags, quantum, map centre, point and
+//             block counts, index offset and the route length
+//   blocks  - up to ROUTE_FILE_BLOCK_POINTS points each, back to back
+//   index   - one 40-byte entry per block: offset, stored and encoded sizes,
+//             point count, flags and the quantised bounds of the block
+//
+// Points are metres from the map centre quantised to the header's quantum. A
+// block stores its first point and then the difference to the previous point,
+// every value a zig-zag varint, so a block decodes on its own and a regular
+// track takes two or three bytes per point. Blocks may go through the LZ pass,
+// and keep it only where it made them smaller.
+//
+// The index is read when the file is opened, the blocks are decoded straight
+// from the mapped file on demand.
+constexpr size_t ROUTE_FILE_BLOCK_POINTS = 4096;
+constexpr double ROUTE_FILE_QUANTUM = 0.001; // Metres, about the float precision at the edge of a city-sized map
+
+struct RouteFileBlock {
+    uint64_t offset = 0;
+    uint32_t storedSize = 0;  // Bytes in the file
+    uint32_t encodedSize = 0; // Bytes of varints, same as storedSize unless compressed
+    uint32_t count = 0;
+    bool compressed = false;
+    int32_t minX = 0, minY = 0, maxX = 0, maxY = 0; // In quanta
+};
+
+struct RouteFile {
+    MappedFile mapped;
+    double quantum = ROUTE_FILE_QUANTUM;
+    double centreX = 0.0, centreY = 0.0; // World coordinates of the map the route was drawn on
+    double length = 0.0;                 // Metres, as measured when saved
+    uint64_t pointCount = 0;
+    std::vector<RouteFileBlock> blocks;
+};
+
+struct RouteFileStats {
+    size_t points = 0;
+    size_t blocks = 0;
+    size_t bytes = 0;
+    double seconds = 0.0;
+};
+
+// Writes the route in order, each block through the LZ pass when compress is set
+bool saveRouteFile(const char *path, const RouteStore &route, const Georeference &geo, bool compress,
+                   RouteFileStats &stats);
+
+// Maps the file and reads its header and index. Reports the error and returns
+// false if the file is not a route file or belongs to a different map.
+bool openRouteFile(RouteFile &file, const char *path, const Georeference &geo);
+void closeRouteFile(RouteFile &file);
+
+// Decodes one block into metres, xs and ys hold blocks[block].count values.
+// scratch keeps the decompressed bytes of compressed blocks.
+bool decodeRouteFileBlock(const RouteFile &file, size_t block, float *xs, float *ys, std::vector<uint8_t> &scratch);
+
+// Decodes every block in order into the sink, false if a block is corrupt
+bool readRouteFile(const RouteFile &file, TrackPointSink sink, void *context, RouteFileStats &stats);
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// ROUTE HISTORY
+// ============================================================================
+// Undo and redo as a log of point edits rather than snapshots. An edit is the
+// index and coordinates of one inserted or removed point, so it takes the same
+// few bytes however long the route is, and undoing it is the opposite edit.
+// Edits made by one action, like the points of a routed path, are chained to
+// the edit before them and undone and redone together.
+//
+// The log is a ring of fixed capacity, allocated once. Undone edits stay after
+// the applied ones until redone or dropped by a new edit, and when the ring is
+// full the oldest edit is forgotten.
+enum class RouteEditType : uint32_t {
+    Insert,
+    Remove
+};
+
+struct RouteEdit {
+    RouteEditType type;
+    uint32_t index;
+    float x, y; // The point inserted or removed, in route units
+    bool chained = false; // Part of the same action as the edit before it
+};
+
+struct RouteHistory {
+    std::vector<RouteEdit> edits;
+    size_t first = 0;     // Ring position of the oldest edit
+    size_t undoCount = 0; // Applied edits, oldest first
+    size_t redoCount = 0; // Undone edits after them, the next one to redo first
+};
+
+void createRouteHistory(RouteHistory &history, size_t capacity);
+void clearRouteHistory(RouteHistory &history);
+
+// Logs an edit that was just applied, forgetting everything that could be redone
+void recordRouteEdit(RouteHistory &history, const RouteEdit &edit);
+
+// The edit to revert, false when there is nothing to undo
+bool popUndoEdit(RouteHistory &history, RouteEdit &edit);
+
+// The edit to apply again, false when there is nothing to redo
+bool popRedoEdit(RouteHistory &history, RouteEdit &edit);
+
+// The edit popRedoEdit would return, without taking it
+bool peekRedoEdit(const RouteHistory &history, RouteEdit &edit);
@@ -0,0 +1,114 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Fenwick.h"
+#include "PointKernels.h"
+
+// ============================================================================
+// ROUTE STORE
+// ============================================================================
+// Ordered route vertices kept as an unrolled list of blocks of at most
+// ROUTE_BLOCK_CAPACITY points. Two Fenwick trees run over the blocks in route
+// order, one with point counts and one with lengths, so locating vertex k,
+// the total length and the distance from the start to vertex k are O(log n + B).
+// Inserts and removals shift at most one block. Splitting, merging or dropping
+// a block rebuilds the trees in O(n / B).
+//
+// Blocks store coordinates as 32-byte aligned x and y arrays so the length,
+// nearest-point and bounds loops run through the SIMD point kernels.
+//
+// Lengths are in the units of the stored coordinates, accumulated in double,
+// unless a length function is set, e.g. to measure geodesically.
+//
+// For drawing at a reduced level of detail every block carries Visvalingam ranks
+// of its points, see Simplify.h. Blocks are ranked on their own with their end
+// points kept, and only blocks edited since they were last ranked are redone.
+// Lengths and distances always use every point.
+//
+// The signed area of the route closed back to its first point is kept as a
+// shoelace sum. Every edit changes only the cross products of the edges around
+// the edited points, so the area is updated with those instead of a rescan.
+constexpr size_t ROUTE_BLOCK_CAPACITY = 512;
+
+struct Point {
+    float x, y;
+    uint32_t id; // Stable handle, e.g. into a spatial index, recycled after removal
+
+    bool operator==(const Point &other) const {
+        return std::abs(x - other.x) < 0.001f && std::abs(y - other.y) < 0.001f;
+    }
+};
+
+struct RouteBlock {
+    alignas(32) float xs[ROUTE_BLOCK_CAPACITY];
+    alignas(32) float ys[ROUTE_BLOCK_CAPACITY];
+    uint32_t ids[ROUTE_BLOCK_CAPACITY];
+    float ranks[ROUTE_BLOCK_CAPACITY];
+    uint32_t count = 0;
+    double length = 0.0; // Segments inside the block plus the one joining it to the previous block
+    bool ranked = false; // Whether ranks match the points
+};
+
+// Length of the polyline through count points
+using RouteLengthFunction = double (*)(const void *context, const float *xs, const float *ys, size_t count);
+
+struct RouteStore {
+    std::vector<RouteBlock> blocks;   // Slot pool, route order is given by order
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> order;      // Slots in route order
+    std::vector<uint32_t> positionOf; // Slot -> position in order, refreshed on structural changes
+    std::vector<uint32_t> slotOfPoint; // Point id -> slot holding it
+
+    FenwickTree<int64_t> counts;      // Over positions in order
+    FenwickTree<double> lengths;
+    size_t size = 0;
+    uint64_t revision = 0;            // Bumped by every edit, for caches of the route
+    double crossSum = 0.0;            // Twice the signed area of the closed route
+
+    RouteLengthFunction measure = nullptr; // Planar lengths when not set
+    const void *measureContext = nullptr;
+};
+
+// Preallocates blocks and index arrays for reservedPoints, so that editing a
+// route of up to that size never touches the heap
+void createRouteStore(RouteStore &store, size_t reservedPoints);
+void clearRouteStore(RouteStore &store);
+
+// Remeasures every block, the context must outlive the store
+void setRouteLengthFunction(RouteStore &store, RouteLengthFunction measure, const void *context);
+
+void appendRoutePoint(RouteStore &store, const Point &point);
+
+// Bulk append, e.g. for imported tracks. Blocks are filled with straight copies
+// and measured once each, and the trees are rebuilt once at the end.
+void appendRoutePoints(RouteStore &store, const float *xs, const float *ys, const uint32_t *ids, size_t count);
+void insertRoutePoint(RouteStore &store, size_t index, const Point &point);
+Point removeRoutePoint(RouteStore &store, size_t index);
+
+Point getRoutePoint(const RouteStore &store, size_t index);
+
+// Index of the point with the given id, false if it is not in the route
+bool findRoutePoint(const RouteStore &store, uint32_t id, size_t &index);
+
+double getRouteLength(const RouteStore &store);
+
+// Length of the route from the first vertex to vertex index
+double getRouteDistanceTo(const RouteStore &store, size_t index);
+
+// distances[i] receives the length of the route up to vertex i, size values
+void computeRouteDistances(const RouteStore &store, double *distances);
+
+// Index of the vertex closest to (x, y), false for an empty route. Scans every vertex.
+bool findNearestRoutePoint(const RouteStore &store, float x, float y, size_t &index);
+
+PointBounds getRouteBounds(const RouteStore &store);
+
+// Area enclosed by the route and the edge from its last point back to the first,
+// positive when counterclockwise, in squared units of the stored coordinates
+double getRouteSignedArea(const RouteStore &store);
+
+// Ranks the blocks edited since the last call
+void rankRouteBlocks(RouteStore &store);
@@ -0,0 +1,40 @@
+#pragma once
+#include <glad/glad.h>
+
+// ============================================================================
+// SCENE RENDER TARGET
+// ============================================================================
+// Offscreen color target for the map and measurement overlay, with a stencil
+// for polygon fills. The texture is allocated at framebuffer size and the scene
+// is rendered into a scaled sub-rectangle of it, so changing the scale never
+// reallocates.
+struct SceneTarget {
+    unsigned int framebuffer = 0;
+    unsigned int colorTexture = 0;
+    unsigned int stencilRenderbuffer = 0; // Depth and stencil, same size as the texture
+    int textureWidth = 0;
+    int textureHeight = 0;
+
+    int width = 0;  // Region rendered this frame
+    int height = 0;
+    float scale = 1.0f;
+};
+
+// Resolution scale bounds and the GPU frame time the controller aims for
+struct ResolutionPolicy {
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    double budgetMs = 0.0;
+};
+
+void destroySceneTarget(SceneTarget &target);
+
+// (Re)allocates for the framebuffer size if needed, binds the target and sets the scaled viewport
+void bindSceneTarget(SceneTarget &target, int framebufferWidth, int framebufferHeight);
+
+// Upscales the rendered region into the output framebuffer, leaves it bound with the full viewport
+void resolveSceneTarget(const SceneTarget &target, unsigned int outputFramebuffer,
+                        int framebufferWidth, int framebufferHeight);
+
+// Steps the scale down when over budget and back up when there is clear headroom
+void updateResolutionScale(SceneTarget &target, const ResolutionPolicy &policy, double gpuFrameMs);
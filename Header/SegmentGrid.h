@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// SEGMENT GRID
+// ============================================================================
+// Nearest-segment queries over a fixed rectangle. Segments can be any length,
+// so a single grid would have to list long ones in many cells. Instead there
+// is a stack of grids with doubling cell sizes, the last one a single cell,
+// and every segment sits in one cell: the cell holding its midpoint, in the
+// finest grid whose cells are at least as long as the segment. Every point of
+// a segment is then within half a cell of its midpoint, and a radius query
+// visits the cells within radius plus half a cell on each level.
+//
+// Cells are intrusive doubly linked lists threaded through per-id arrays as in
+// SpatialGrid, so insert and remove are O(1) and never allocate while ids stay
+// below the reserved count. Ids are owned by the caller.
+struct SegmentGridLevel {
+    float cellSize = 1.0f;
+    int columns = 0, rows = 0;
+    size_t firstCell = 0; // Of the level's cells in cellHeads
+    size_t count = 0;     // Segments in the level, empty levels are skipped by queries
+};
+
+struct SegmentGrid {
+    float minX = 0.0f, minY = 0.0f;
+    std::vector<SegmentGridLevel> levels; // Finest first
+
+    std::vector<int32_t> cellHeads; // First id in each cell of every level, -1 when empty
+    std::vector<int32_t> next;      // Per id links within its cell
+    std::vector<int32_t> previous;
+    std::vector<int32_t> cellOf;    // Per id, -1 when the id is not in the grid
+    std::vector<uint8_t> levelOf;
+    std::vector<float> x1s, y1s, x2s, y2s;
+    size_t count = 0;
+};
+
+void createSegmentGrid(SegmentGrid &grid, float minX, float minY, float maxX, float maxY, float finestCellSize,
+                       size_t reservedIds);
+void clearSegmentGrid(SegmentGrid &grid);
+
+// Inserting an id that is already in the grid moves it, removing one that is not does nothing
+void insertSegment(SegmentGrid &grid, uint32_t id, float x1, float y1, float x2, float y2);
+void removeSegment(SegmentGrid &grid, uint32_t id);
+
+// Closest segment within radius of (x, y), -1 if there is none
+int32_t findNearestSegment(const SegmentGrid &grid, float x, float y, float radius);
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+
+// ============================================================================
+// POLYLINE SIMPLIFICATION
+// ============================================================================
+// Visvalingam-Whyatt ranks, computed once per polyline: vertices are eliminated
+// smallest triangle first, and each one is ranked with the area of the triangle
+// it formed with its neighbours when it went. Ranks never decrease along the
+// elimination order, so keeping the vertices ranked at least minRank gives the
+// simplification at that area threshold for any minRank, without recomputing.
+// End points are ranked infinite and always kept.
+//
+// Scratch lives on the stack, polylines are limited to SIMPLIFY_MAX_POINTS.
+constexpr size_t SIMPLIFY_MAX_POINTS = 512;
+
+void rankVisvalingam(const float *xs, const float *ys, size_t count, float *ranks);
+
+// Copies the points ranked at least minRank into xys as interleaved x, y pairs,
+// returns how many points were written
+size_t selectRankedPoints(const float *xs, const float *ys, const float *ranks, size_t count, float minRank,
+                          float *xys);
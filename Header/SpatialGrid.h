@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// SPATIAL GRID
+// ============================================================================
+// Uniform grid over a fixed rectangle for radius queries on point ids. Every
+// cell is an intrusive doubly linked list threaded through per-id arrays, so
+// insert and remove are O(1) and never allocate while ids stay below the
+// reserved count. Points outside the rectangle are clamped into border cells.
+//
+// Ids are small integers owned by the caller and should be recycled, the
+// per-id arrays are sized by the largest id ever inserted.
+struct SpatialGrid {
+    float minX = 0.0f, minY = 0.0f;
+    float cellSize = 1.0f;
+    int columns = 0, rows = 0;
+
+    std::vector<int32_t> cellHeads; // First id in each cell, -1 when empty
+    std::vector<int32_t> next;      // Per id links within its cell
+    std::vector<int32_t> previous;
+    std::vector<int32_t> cellOf;    // Per id, -1 when the id is not in the grid
+    std::vector<float> xs, ys;
+    size_t count = 0;
+};
+
+void createSpatialGrid(SpatialGrid &grid, float minX, float minY, float maxX, float maxY, float cellSize,
+                       size_t reservedIds);
+void clearSpatialGrid(SpatialGrid &grid);
+
+void insertIntoGrid(SpatialGrid &grid, uint32_t id, float x, float y);
+void removeFromGrid(SpatialGrid &grid, uint32_t id);
+
+// Closest id within radius of (x, y), -1 if there is none. Only the cells
+// overlapping the query square are visited.
+int32_t findNearestInGrid(const SpatialGrid &grid, float x, float y, float radius);
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// TRACE EVENTS
+// ============================================================================
+// Records CPU slices and GPU counters into per-thread buffers and writes them
+// as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev). Every thread
+// appends only to its own buffer, so recording takes no locks; the buffers are
+// read once, at flush time. Recording is off unless --trace is given.
+enum class TracePhase : char {
+    Begin = 'B',
+    End = 'E',
+    Counter = 'C'
+};
+
+struct TraceEvent {
+    const char *name;     // Must outlive the trace, string literals in practice
+    const char *category;
+    TracePhase phase;
+    int64_t timestampNs;  // Since startTrace
+    double value;         // Counter events only
+    char detail[48];      // Optional argument, copied, e.g. the file a load slice is reading
+};
+
+struct TraceBuffer {
+    static constexpr size_t CAPACITY = 1 << 16;
+
+    TraceEvent events[CAPACITY];
+    std::atomic<size_t> count{0};    // Published events, written only by the owning thread
+    std::atomic<size_t> dropped{0};
+    int threadId = 0;
+    const char *threadName = nullptr;
+    TraceBuffer *next = nullptr;     // Registry of all buffers, see registerTraceBuffer
+};
+
+extern std::atomic<bool> traceEnabled;
+
+void startTrace();
+// Writes all buffers to a trace JSON file and stops recording, returns false if the file could not be written
+bool writeTrace(const char *path);
+
+// Does nothing unless recording, call after startTrace
+void setTraceThreadName(const char *name);
+
+void beginTraceSlice(const char *name, const char *category, const char *detail = nullptr);
+void endTraceSlice(const char *name, const char *category);
+void recordTraceCounter(const char *name, const char *category, double value);
+
+// Scoped slice, no-op while tracing is off
+class TraceScope {
+public:
+    TraceScope(const char *name, const char *category, const char *detail = nullptr)
+        : name(name), category(category), active(traceEnabled.load(std::memory_order_relaxed)) {
+        if (active) {
+            beginTraceSlice(name, category, detail);
+        }
+    }
+
+    ~TraceScope() {
+        if (active) {
+            endTraceSlice(name, category);
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name;
+    const char *category;
+    bool active;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category)
+#define TRACE_SCOPE_DETAIL(name, category, detail) \
+    TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category, detail)
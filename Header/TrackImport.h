@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+
+#include "Georeference.h"
+
+// ============================================================================
+// TRACK IMPORT
+// ============================================================================
+// Loads recorded tracks from GPX or CSV files. The file is memory-mapped and
+// cut into fixed-size chunks that worker threads tokenize in place, parsing
+// numbers with std::from_chars and projecting them to metres. Chunks are handed
+// to the sink in file order while later ones are still being parsed, and only a
+// few chunks are in flight at a time, so memory stays bounded for any file size.
+//
+//   GPX - lat and lon attributes of every trkpt and rtept element, no DOM is built
+//   CSV - one point per line. A header row names the columns (lat / latitude and
+//         lon / lng / long / longitude), without one the first two columns are
+//         latitude and longitude. Comma, semicolon and tab delimiters.
+//
+// The format is told from the content, a file starting with '<' is GPX.
+// Tracks are in WGS 84 degrees, the map needs a geographic world file.
+struct TrackImportStats {
+    size_t points = 0;
+    size_t skipped = 0; // Records without a valid position
+    size_t bytes = 0;
+    double seconds = 0.0;
+};
+
+// Receives projected points in track order, on the thread that called importTrack
+using TrackPointSink = void (*)(void *context, const float *xs, const float *ys, size_t count);
+
+// Reports the error and returns false if the file cannot be read or placed on the map
+bool importTrack(const char *path, const Georeference &geo, TrackPointSink sink, void *context,
+                 TrackImportStats &stats);
@@ -1,15 +1,16 @@
-#version 460 core
+#version 450 core
 in vec2 TexCoord;
 out vec4 FragColor;
 
 uniform sampler2D texture1;
 uniform vec3 customColor;
 uniform bool useCustomColor;
+uniform float customAlpha = 1.0;
 
 void main()
 {
     if (useCustomColor) {
-        FragColor = vec4(customColor, 1.0);
+        FragColor = vec4(customColor, customAlpha);
     } else {
         FragColor = texture(texture1, TexCoord);
     }
@@ -1,13 +1,51 @@
-#version 460 core
+#version 450 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec2 aStart; // Per instance, route vertices for latchMode 3 and 4
+layout (location = 3) in vec2 aEnd;
+
+// Cursor position in NDC, written right before the frame is submitted
+layout (std140, binding = 0) uniform LateLatch {
+    vec4 latchedCursor;
+};
 
 uniform mat4 model;
+// 0: model only, 1: model offset to the cursor, 2: segment from anchor to the cursor,
+// 3: segment from aStart to aEnd, 4: marker of size thickness at aStart.
+// In 3 and 4 model takes the route vertices to NDC, as it does in 0 when the
+// route buffer is bound as aPos to fill the closed route.
+uniform int latchMode;
+uniform vec2 anchor;
+uniform float thickness;
 
 out vec2 TexCoord;
 
 void main()
 {
-    gl_Position = model * vec4(aPos, 1.0);
+    vec2 cursor = latchedCursor.xy;
+
+    if (latchMode == 3) {
+        vec2 start = (model * vec4(aStart, 0.0, 1.0)).xy;
+        vec2 delta = (model * vec4(aEnd, 0.0, 1.0)).xy - start;
+        float len = length(delta);
+        vec2 dir = len > 0.0 ? delta / len : vec2(1.0, 0.0);
+        vec2 normal = vec2(-dir.y, dir.x);
+        vec2 pos = start + delta * 0.5 + dir * aPos.x * len + normal * aPos.y * thickness;
+        gl_Position = vec4(pos, 0.0, 1.0);
+    } else if (latchMode == 4) {
+        vec2 centre = (model * vec4(aStart, 0.0, 1.0)).xy;
+        gl_Position = vec4(centre + aPos.xy * thickness, 0.0, 1.0);
+    } else if (latchMode == 1) {
+        gl_Position = model * vec4(aPos, 1.0) + vec4(cursor, 0.0, 0.0);
+    } else if (latchMode == 2) {
+        vec2 delta = cursor - anchor;
+        float len = length(delta);
+        vec2 dir = len > 0.0 ? delta / len : vec2(1.0, 0.0);
+        vec2 normal = vec2(-dir.y, dir.x);
+        vec2 pos = (anchor + cursor) * 0.5 + dir * aPos.x * len + normal * aPos.y * thickness;
+        gl_Position = vec4(pos, 0.0, 1.0);
+    } else {
+        gl_Position = model * vec4(aPos, 1.0);
+    }
     TexCoord = aTexCoord;
 }
\ No newline at end of file
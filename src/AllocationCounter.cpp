@@ -0,0 +1,179 @@
+#include "../Header/AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+    // Worker threads may allocate too, unlike the GL counters these need to be atomic
+    std::atomic<uint64_t> allocationCounts[ALLOCATION_SCOPE_COUNT]{};
+    std::atomic<uint64_t> allocationBytes[ALLOCATION_SCOPE_COUNT]{};
+
+    // Constant-initialized, so reading it from operator new never allocates itself
+    thread_local AllocationScope currentScope = AllocationScope::Frame;
+}
+
+#ifdef KOSTUR_TRACK_ALLOCATIONS
+namespace {
+    void countAllocation(const size_t size) {
+        const int scope = static_cast<int>(currentScope);
+        allocationCounts[scope].fetch_add(1, std::memory_order_relaxed);
+        allocationBytes[scope].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void *allocate(const size_t size) noexcept {
+        countAllocation(size);
+        return std::malloc(size ? size : 1);
+    }
+
+    // Over-aligned types such as RouteBlock come through here
+    void *allocateAligned(const size_t size, const std::align_val_t alignment) noexcept {
+        countAllocation(size);
+        const auto bytes = static_cast<size_t>(alignment);
+        const size_t requested = size ? size : 1;
+#ifdef _WIN32
+        return _aligned_malloc(requested, bytes);
+#else
+        // aligned_alloc takes whole multiples of the alignment
+        return std::aligned_alloc(bytes, (requested + bytes - 1) / bytes * bytes);
+#endif
+    }
+
+    void freeAligned(void *memory) noexcept {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+void *operator new(const size_t size) {
+    if (void *memory = allocate(size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](const size_t size) {
+    return operator new(size);
+}
+
+void *operator new(const size_t size, const std::nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new[](const size_t size, const std::nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new(const size_t size, const std::align_val_t alignment) {
+    if (void *memory = allocateAligned(size, alignment)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](const size_t size, const std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void *operator new(const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void *operator new[](const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::align_val_t) noexcept {
+    freeAligned(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t) noexcept {
+    freeAligned(memory);
+}
+
+void operator delete(void *memory, size_t, std::align_val_t) noexcept {
+    freeAligned(memory);
+}
+
+void operator delete[](void *memory, size_t, std::align_val_t) noexcept {
+    freeAligned(memory);
+}
+
+void operator delete(void *memory, std::align_val_t, const std::nothrow_t &) noexcept {
+    freeAligned(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t, const std::nothrow_t &) noexcept {
+    freeAligned(memory);
+}
+#endif
+
+const char *getAllocationScopeName(const AllocationScope scope) {
+    switch (scope) {
+        case AllocationScope::Frame: return "frame";
+        case AllocationScope::Input: return "input";
+        case AllocationScope::Render: return "render";
+        case AllocationScope::Benchmark: return "benchmark";
+        default: return "unknown";
+    }
+}
+
+uint64_t AllocationStats::total() const {
+    uint64_t sum = 0;
+    for (const uint64_t count: counts) {
+        sum += count;
+    }
+    return sum;
+}
+
+bool isAllocationTrackingEnabled() {
+#ifdef KOSTUR_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void collectAllocations(AllocationStats &stats) {
+    for (int scope = 0; scope < ALLOCATION_SCOPE_COUNT; ++scope) {
+        stats.counts[scope] = allocationCounts[scope].exchange(0, std::memory_order_relaxed);
+        stats.bytes[scope] = allocationBytes[scope].exchange(0, std::memory_order_relaxed);
+    }
+}
+
+AllocationScope setAllocationScope(const AllocationScope scope) {
+    const AllocationScope previous = currentScope;
+    currentScope = scope;
+    return previous;
+}
@@ -0,0 +1,500 @@
+#include "../Header/Benchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "../Header/PointKernels.h"
+
+
+// ============================================================================
+// SCENARIO PARSING
+// ============================================================================
+namespace {
+    int parseKeyName(const std::string &name) {
+        if (name.size() == 1 && name[0] >= 'A' && name[0] <= 'Z') {
+            return GLFW_KEY_A + (name[0] - 'A');
+        }
+        if (name.size() >= 2 && name[0] == 'F' && std::isdigit(static_cast<unsigned char>(name[1]))) {
+            const int number = std::atoi(name.c_str() + 1);
+            if (number >= 1 && number <= 25) {
+                return GLFW_KEY_F1 + number - 1;
+            }
+        }
+        if (name == "ESCAPE") {
+            return GLFW_KEY_ESCAPE;
+        }
+        return GLFW_KEY_UNKNOWN;
+    }
+
+    // Parses lines until "end" or EOF, expanding repeat blocks in place
+    bool parseBlock(std::istream &input, std::vector<ScenarioStep> &steps, int &lineNumber, const bool nested) {
+        std::string line;
+        while (std::getline(input, line)) {
+            ++lineNumber;
+            if (const size_t comment = line.find('#'); comment != std::string::npos) {
+                line.erase(comment);
+            }
+
+            std::istringstream tokens(line);
+            std::string command;
+            if (!(tokens >> command)) {
+                continue;
+            }
+
+            ScenarioStep step{};
+            bool valid = true;
+
+            if (command == "end") {
+                return nested;
+            } else if (command == "frames") {
+                step.op = ScenarioOp::Frames;
+                valid = static_cast<bool>(tokens >> step.count);
+            } else if (command == "key" || command == "tap") {
+                std::string name, action = "tap";
+                valid = static_cast<bool>(tokens >> name) && (command == "tap" || tokens >> action);
+                step.op = ScenarioOp::Key;
+                step.code = parseKeyName(name);
+                valid = valid && step.code != GLFW_KEY_UNKNOWN;
+
+                if (valid && action == "tap") {
+                    step.action = GLFW_PRESS;
+                    steps.push_back(step);
+                    step.action = GLFW_RELEASE;
+                } else {
+                    step.action = action == "up" ? GLFW_RELEASE : GLFW_PRESS;
+                }
+            } else if (command == "click") {
+                step.op = ScenarioOp::Click;
+                valid = static_cast<bool>(tokens >> step.x >> step.y);
+            } else if (command == "scatter") {
+                step.op = ScenarioOp::Scatter;
+                valid = static_cast<bool>(tokens >> step.count >> step.perFrame >> step.seed) && step.perFrame > 0;
+                if (std::string modifier; valid && tokens >> modifier) {
+                    step.mods = GLFW_MOD_SHIFT;
+                    valid = modifier == "shift";
+                }
+            } else if (command == "wander") {
+                step.op = ScenarioOp::Wander;
+                valid = static_cast<bool>(tokens >> step.count >> step.seed);
+            } else if (command == "repeat") {
+                int times = 0;
+                valid = static_cast<bool>(tokens >> times);
+
+                std::vector<ScenarioStep> body;
+                if (!valid || !parseBlock(input, body, lineNumber, true)) {
+                    std::cout << "Scenario: neispravan repeat blok u liniji " << lineNumber << std::endl;
+                    return false;
+                }
+                for (int i = 0; i < times; ++i) {
+                    steps.insert(steps.end(), body.begin(), body.end());
+                }
+                continue;
+            } else {
+                valid = false;
+            }
+
+            if (!valid) {
+                std::cout << "Scenario: neispravna komanda u liniji " << lineNumber << ": " << line << std::endl;
+                return false;
+            }
+            steps.push_back(step);
+        }
+
+        return !nested;
+    }
+
+    void pushClick(InputQueue &inputQueue, const float ndcX, const float ndcY, const double time,
+                   const int screenWidth, const int screenHeight, const int mods = 0) {
+        InputEvent event{};
+        event.type = InputEventType::MouseButton;
+        event.code = GLFW_MOUSE_BUTTON_LEFT;
+        event.mods = mods;
+        event.x = (ndcX + 1.0) * 0.5 * screenWidth;
+        event.y = (1.0 - ndcY) * 0.5 * screenHeight;
+        event.time = time;
+
+        event.action = GLFW_PRESS;
+        inputQueue.push(event);
+        event.action = GLFW_RELEASE;
+        inputQueue.push(event);
+    }
+
+    void pushCursor(InputQueue &inputQueue, const float ndcX, const float ndcY, const double time,
+                    const int screenWidth, const int screenHeight) {
+        InputEvent event{};
+        event.type = InputEventType::CursorPos;
+        event.x = (ndcX + 1.0) * 0.5 * screenWidth;
+        event.y = (1.0 - ndcY) * 0.5 * screenHeight;
+        event.time = time;
+        inputQueue.push(event);
+    }
+
+    // xorshift32, deterministic across platforms unlike std::rand
+    float nextRandom(uint32_t &state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<float>(state & 0xFFFFFF) / static_cast<float>(0xFFFFFF);
+    }
+
+    size_t countScenarioFrames(const std::vector<ScenarioStep> &steps) {
+        size_t frames = 1;
+        for (const ScenarioStep &step: steps) {
+            if (step.op == ScenarioOp::Frames) {
+                frames += step.count;
+            } else if (step.op == ScenarioOp::Scatter) {
+                frames += (step.count + step.perFrame - 1) / step.perFrame;
+            } else if (step.op == ScenarioOp::Wander) {
+                frames += step.count;
+            }
+        }
+        return frames;
+    }
+}
+
+bool loadScenario(BenchmarkRunner &runner, const char *filePath) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cout << "Greska pri citanju fajla sa putanje \"" << filePath << "\"!" << std::endl;
+        return false;
+    }
+
+    // Scenario name is the file name without directory and extension
+    std::string name = filePath;
+    name = name.substr(name.find_last_of("/\\") + 1);
+    runner.name = name.substr(0, name.find('.'));
+
+    int lineNumber = 0;
+    runner.steps.clear();
+    if (!parseBlock(file, runner.steps, lineNumber, false)) {
+        return false;
+    }
+
+    // Recording must not allocate, or it would show up in the frames it measures
+    const size_t frames = countScenarioFrames(runner.steps);
+    runner.cpuFrameMs.reserve(frames);
+    runner.gpuFrameMs.reserve(frames);
+    for (std::vector<double> &counts: runner.glCounts) {
+        counts.reserve(frames);
+    }
+    runner.allocations.reserve(frames);
+    return true;
+}
+
+bool advanceScenario(BenchmarkRunner &runner, InputQueue &inputQueue, const double time,
+                     const int screenWidth, const int screenHeight) {
+    // Instant commands run until one that takes up frames
+    while (runner.stepIndex < runner.steps.size()) {
+        const ScenarioStep &step = runner.steps[runner.stepIndex];
+
+        switch (step.op) {
+            case ScenarioOp::Key: {
+                InputEvent event{};
+                event.type = InputEventType::Key;
+                event.code = step.code;
+                event.action = step.action;
+                event.time = time;
+                inputQueue.push(event);
+                ++runner.stepIndex;
+                continue;
+            }
+            case ScenarioOp::Click:
+                pushClick(inputQueue, step.x, step.y, time, screenWidth, screenHeight);
+                ++runner.stepIndex;
+                continue;
+            case ScenarioOp::Frames:
+                if (runner.stepProgress < step.count) {
+                    ++runner.stepProgress;
+                    return true;
+                }
+                break;
+            case ScenarioOp::Scatter:
+                if (runner.stepProgress == 0) {
+                    runner.random = step.seed ? step.seed : 1;
+                }
+                if (runner.stepProgress < step.count) {
+                    // Stay below the mode indicator in the top left corner, a click there switches modes
+                    const int clicks = std::min(step.perFrame, step.count - runner.stepProgress);
+                    for (int i = 0; i < clicks; ++i) {
+                        const float x = -0.9f + 1.8f * nextRandom(runner.random);
+                        const float y = -0.9f + 1.4f * nextRandom(runner.random);
+                        pushClick(inputQueue, x, y, time, screenWidth, screenHeight, step.mods);
+                    }
+                    runner.stepProgress += clicks;
+                    return true;
+                }
+                break;
+            case ScenarioOp::Wander:
+                if (runner.stepProgress == 0) {
+                    runner.random = step.seed ? step.seed : 1;
+                }
+                if (runner.stepProgress < step.count) {
+                    // Same area as scatter
+                    const float x = -0.9f + 1.8f * nextRandom(runner.random);
+                    const float y = -0.9f + 1.4f * nextRandom(runner.random);
+                    pushCursor(inputQueue, x, y, time, screenWidth, screenHeight);
+                    ++runner.stepProgress;
+                    return true;
+                }
+                break;
+        }
+
+        ++runner.stepIndex;
+        runner.stepProgress = 0;
+    }
+
+    return false;
+}
+
+// ============================================================================
+// MEASUREMENTS
+// ============================================================================
+void recordBenchmarkFrame(BenchmarkRunner &runner, const double cpuMs, const GlFrameStats &glStats,
+                          const AllocationStats &allocations) {
+    if (runner.frameIndex++ < runner.warmupFrames) {
+        return;
+    }
+
+    runner.cpuFrameMs.push_back(cpuMs);
+    for (int counter = 0; counter < GL_COUNTER_COUNT; ++counter) {
+        runner.glCounts[counter].push_back(static_cast<double>(glStats.total(static_cast<GlCounter>(counter))));
+        for (int subsystem = 0; subsystem < GL_SUBSYSTEM_COUNT; ++subsystem) {
+            runner.glSubsystemSums[subsystem][counter] += static_cast<double>(glStats.counts[subsystem][counter]);
+        }
+    }
+
+    const uint64_t frameAllocations = allocations.total() - allocations.get(AllocationScope::Benchmark);
+    runner.allocations.push_back(static_cast<double>(frameAllocations));
+    for (int scope = 0; scope < ALLOCATION_SCOPE_COUNT; ++scope) {
+        runner.allocationScopeSums[scope] += static_cast<double>(allocations.counts[scope]);
+    }
+
+    if (runner.assertNoAllocations && frameAllocations > 0) {
+        // Only the first few, a leak in every frame would flood the output
+        if (runner.allocatingFrames++ < 10) {
+            std::cout << "Frejm " << runner.frameIndex - 1 << ": " << frameAllocations << " alokacija (";
+            for (int scope = 0; scope < ALLOCATION_SCOPE_COUNT; ++scope) {
+                if (scope != static_cast<int>(AllocationScope::Benchmark) && allocations.counts[scope] > 0) {
+                    std::cout << " " << getAllocationScopeName(static_cast<AllocationScope>(scope)) << " "
+                              << allocations.counts[scope];
+                }
+            }
+            std::cout << " )" << std::endl;
+        }
+    }
+}
+
+void recordBenchmarkGpuTime(BenchmarkRunner &runner, const double gpuMs) {
+    // GPU results arrive a few frames late, so warmup is judged by the CPU frame count
+    if (runner.frameIndex > runner.warmupFrames) {
+        runner.gpuFrameMs.push_back(gpuMs);
+    }
+}
+
+namespace {
+    struct Summary {
+        double mean = 0.0, p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+    };
+
+    Summary summarize(std::vector<double> samples) {
+        Summary summary;
+        if (samples.empty()) {
+            return summary;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        const auto percentile = [&samples](const double p) {
+            // Nearest rank
+            const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+            return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+        };
+
+        double sum = 0.0;
+        for (const double sample: samples) {
+            sum += sample;
+        }
+
+        summary.mean = sum / samples.size();
+        summary.p50 = percentile(50.0);
+        summary.p90 = percentile(90.0);
+        summary.p99 = percentile(99.0);
+        summary.max = samples.back();
+        return summary;
+    }
+
+    void writeSummary(std::ostream &out, const char *name, const Summary &summary) {
+        out << "  \"" << name << "\": {"
+            << "\"mean\": " << summary.mean << ", "
+            << "\"p50\": " << summary.p50 << ", "
+            << "\"p90\": " << summary.p90 << ", "
+            << "\"p99\": " << summary.p99 << ", "
+            << "\"max\": " << summary.max << "},\n";
+    }
+
+    void writeAllocationScopes(std::ostream &out, const BenchmarkRunner &runner) {
+        const double frames = static_cast<double>(std::max<size_t>(runner.cpuFrameMs.size(), 1));
+        out << "  \"allocationScopes\": {";
+        for (int scope = 0; scope < ALLOCATION_SCOPE_COUNT; ++scope) {
+            out << (scope ? ", " : "") << "\"" << getAllocationScopeName(static_cast<AllocationScope>(scope))
+                << "\": " << runner.allocationScopeSums[scope] / frames;
+        }
+        out << "},\n";
+    }
+
+    // Mean per frame of every counter, for each subsystem that issued any GL calls
+    void writeGlSubsystems(std::ostream &out, const BenchmarkRunner &runner) {
+        const double frames = static_cast<double>(std::max<size_t>(runner.cpuFrameMs.size(), 1));
+        out << "  \"glSubsystems\": {";
+
+        bool first = true;
+        for (int subsystem = 0; subsystem < GL_SUBSYSTEM_COUNT; ++subsystem) {
+            const double *sums = runner.glSubsystemSums[subsystem];
+            if (std::all_of(sums, sums + GL_COUNTER_COUNT, [](const double sum) { return sum == 0.0; })) {
+                continue;
+            }
+
+            out << (first ? "\n" : ",\n") << "    \"" << getGlSubsystemName(static_cast<GlSubsystem>(subsystem))
+                << "\": {";
+            for (int counter = 0; counter < GL_COUNTER_COUNT; ++counter) {
+                out << (counter ? ", " : "") << "\"" << getGlCounterName(static_cast<GlCounter>(counter)) << "\": "
+                    << sums[counter] / frames;
+            }
+            out << "}";
+            first = false;
+        }
+        out << (first ? "}\n" : "\n  }\n");
+    }
+
+    // Flattens the numbers of a JSON document into "object.key" entries, enough for reports written above
+    void parseJsonNumbers(const std::string &text, std::map<std::string, double> &values) {
+        std::vector<std::string> path;
+        std::string key;
+        size_t i = 0;
+
+        while (i < text.size()) {
+            const char c = text[i];
+            if (c == '"') {
+                const size_t close = text.find('"', i + 1);
+                if (close == std::string::npos) {
+                    return;
+                }
+                key = text.substr(i + 1, close - i - 1);
+                i = close + 1;
+            } else if (c == '{') {
+                if (!key.empty()) {
+                    path.push_back(key);
+                    key.clear();
+                }
+                ++i;
+            } else if (c == '}') {
+                if (!path.empty()) {
+                    path.pop_back();
+                }
+                ++i;
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                char *end = nullptr;
+                const double value = std::strtod(text.c_str() + i, &end);
+                std::string fullKey;
+                for (const std::string &part: path) {
+                    fullKey += part + ".";
+                }
+                values[fullKey + key] = value;
+                key.clear();
+                i = static_cast<size_t>(end - text.c_str());
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    std::string buildReport(const BenchmarkRunner &runner) {
+        std::ostringstream out;
+        out << "{\n";
+        out << "  \"scenario\": \"" << runner.name << "\",\n";
+        out << "  \"frames\": " << runner.cpuFrameMs.size() << ",\n";
+        out << "  \"allocationsTracked\": " << (isAllocationTrackingEnabled() ? "true" : "false") << ",\n";
+        out << "  \"pointKernels\": \"" << getPointKernelName(getPointKernelLevel()) << "\",\n";
+        out << "  \"routePoints\": " << runner.routePoints << ",\n";
+        writeSummary(out, "cpuFrameMs", summarize(runner.cpuFrameMs));
+        writeSummary(out, "gpuFrameMs", summarize(runner.gpuFrameMs));
+        for (int counter = 0; counter < GL_COUNTER_COUNT; ++counter) {
+            writeSummary(out, getGlCounterName(static_cast<GlCounter>(counter)), summarize(runner.glCounts[counter]));
+        }
+        if (isAllocationTrackingEnabled()) {
+            writeSummary(out, "allocations", summarize(runner.allocations));
+            writeAllocationScopes(out, runner);
+        }
+        writeGlSubsystems(out, runner);
+        out << "}\n";
+        return out.str();
+    }
+}
+
+bool writeBenchmarkReport(const BenchmarkRunner &runner, const char *filePath) {
+    const std::string report = buildReport(runner);
+    if (!filePath) {
+        std::cout << report;
+        return true;
+    }
+
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        std::cout << "Greska pri pisanju fajla sa putanje \"" << filePath << "\"!" << std::endl;
+        return false;
+    }
+    file << report;
+    return true;
+}
+
+int compareWithBaseline(const BenchmarkRunner &runner, const char *baselinePath, const double thresholdPercent) {
+    std::ifstream file(baselinePath);
+    if (!file.is_open()) {
+        std::cout << "Greska pri citanju fajla sa putanje \"" << baselinePath << "\"!" << std::endl;
+        return -1;
+    }
+
+    std::stringstream baselineText, currentText;
+    baselineText << file.rdbuf();
+    currentText << buildReport(runner);
+
+    std::map<std::string, double> baseline, current;
+    parseJsonNumbers(baselineText.str(), baseline);
+    parseJsonNumbers(currentText.str(), current);
+
+    // Timings get a small absolute slack so sub-microsecond noise on tiny frames does not fail the run
+    struct Metric {
+        const char *key;
+        double slack;
+    };
+    constexpr Metric metrics[] = {
+        {"cpuFrameMs.p50", 0.05}, {"cpuFrameMs.p99", 0.05},
+        {"gpuFrameMs.p50", 0.05}, {"gpuFrameMs.p99", 0.05},
+        {"drawCalls.mean", 0.0}, {"binds.mean", 0.0}, {"stateChanges.mean", 0.0},
+        {"uniformUploads.mean", 0.0}, {"uploadBytes.mean", 0.0}, {"allocations.mean", 0.0}
+    };
+
+    int regressions = 0;
+    for (const Metric &metric: metrics) {
+        const auto base = baseline.find(metric.key);
+        const auto now = current.find(metric.key);
+        if (base == baseline.end() || now == current.end()) {
+            continue;
+        }
+
+        const double limit = base->second * (1.0 + thresholdPercent / 100.0) + metric.slack;
+        if (now->second > limit) {
+            std::cout << "Regresija " << metric.key << ": " << base->second << " -> " << now->second
+                      << " (prag " << thresholdPercent << "%)" << std::endl;
+            ++regressions;
+        }
+    }
+
+    return regressions;
+}
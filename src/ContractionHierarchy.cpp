@@ -0,0 +1,615 @@
+#include "../Header/ContractionHierarchy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+#include "../Header/Trace.h"
+
+namespace {
+    constexpr char MAGIC[4] = {'K', 'C', 'H', 'F'};
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t HEADER_SIZE = 32;
+    constexpr size_t MAX_THREADS = 64;
+    constexpr uint32_t UNCONTRACTED = 0xffffffffu;
+    constexpr float INFINITE_DISTANCE = std::numeric_limits<float>::infinity();
+
+    size_t resolveThreads(const size_t threads) {
+        const size_t count = threads > 0 ? threads : std::thread::hardware_concurrency();
+        return std::clamp<size_t>(count, 1, MAX_THREADS);
+    }
+
+    // Calls work(first, last, worker) for even slices of [0, count), one per thread,
+    // the last slice on the calling thread
+    template<typename Work>
+    void runSlices(const size_t threads, const size_t count, const Work &work) {
+        const size_t slices = std::max<size_t>(1, std::min(threads, count));
+        std::vector<std::thread> workers;
+        workers.reserve(slices - 1);
+        for (size_t slice = 0; slice + 1 < slices; ++slice) {
+            workers.emplace_back([&work, slice, slices, count] {
+                work(count * slice / slices, count * (slice + 1) / slices, slice);
+            });
+        }
+        work(count * (slices - 1) / slices, count, slices - 1);
+        for (std::thread &worker: workers) {
+            worker.join();
+        }
+    }
+
+    bool laterEntry(const RoadHeapEntry &a, const RoadHeapEntry &b) {
+        return a.estimate > b.estimate || (a.estimate == b.estimate && a.node > b.node);
+    }
+
+    // ========================================================================
+    // CONTRACTION
+    // ========================================================================
+    // Edge of the graph still being contracted, every one is kept at both ends
+    struct Arc {
+        uint32_t node;
+        float weight;
+        uint32_t middle;
+    };
+
+    struct Shortcut {
+        uint32_t from, to;
+        float weight;
+        uint32_t middle;
+    };
+
+    // Parallel streets between two nodes keep only the shorter one
+    void addArc(std::vector<Arc> &arcs, const uint32_t node, const float weight, const uint32_t middle) {
+        for (Arc &arc: arcs) {
+            if (arc.node == node) {
+                if (weight < arc.weight) {
+                    arc.weight = weight;
+                    arc.middle = middle;
+                }
+                return;
+            }
+        }
+        arcs.push_back({node, weight, middle});
+    }
+
+    void removeArc(std::vector<Arc> &arcs, const uint32_t node) {
+        for (size_t i = 0; i < arcs.size(); ++i) {
+            if (arcs[i].node == node) {
+                arcs[i] = arcs.back();
+                arcs.pop_back();
+                return;
+            }
+        }
+    }
+
+    // Per worker Dijkstra scratch, stamped like the router's
+    struct WitnessSearch {
+        std::vector<float> distances;
+        std::vector<uint32_t> reachedIn;
+        std::vector<RoadHeapEntry> heap;
+        uint32_t query = 0;
+    };
+
+    // Distances from source over uncontracted nodes other than skipped, up to limit or
+    // until settleLimit nodes are settled. Nodes contracted in the current round are
+    // already levelled, so a witness never leans on a node leaving the graph with it.
+    void searchWitnesses(WitnessSearch &search, const std::vector<std::vector<Arc>> &arcs,
+                         const std::vector<uint32_t> &levels, const uint32_t source, const uint32_t skipped,
+                         const float limit, const size_t settleLimit) {
+        if (++search.query == 0) {
+            std::fill(search.reachedIn.begin(), search.reachedIn.end(), 0);
+            search.query = 1;
+        }
+        const uint32_t query = search.query;
+
+        search.heap.clear();
+        search.distances[source] = 0.0f;
+        search.reachedIn[source] = query;
+        search.heap.push_back({0.0f, source});
+
+        size_t settled = 0;
+        while (!search.heap.empty() && settled < settleLimit) {
+            std::pop_heap(search.heap.begin(), search.heap.end(), laterEntry);
+            const RoadHeapEntry entry = search.heap.back();
+            search.heap.pop_back();
+            if (entry.estimate > search.distances[entry.node]) {
+                continue;
+            }
+            if (entry.estimate > limit) {
+                break;
+            }
+            ++settled;
+
+            for (const Arc &arc: arcs[entry.node]) {
+                if (arc.node == skipped || levels[arc.node] != UNCONTRACTED) {
+                    continue;
+                }
+                const float candidate = entry.estimate + arc.weight;
+                if (search.reachedIn[arc.node] == query && candidate >= search.distances[arc.node]) {
+                    continue;
+                }
+                search.distances[arc.node] = candidate;
+                search.reachedIn[arc.node] = query;
+                search.heap.push_back({candidate, arc.node});
+                std::push_heap(search.heap.begin(), search.heap.end(), laterEntry);
+            }
+        }
+    }
+
+    // Shortcuts contracting node would add, appended to shortcuts when given
+    size_t contractNode(WitnessSearch &search, const std::vector<std::vector<Arc>> &arcs,
+                        const std::vector<uint32_t> &levels, const uint32_t node, const size_t settleLimit,
+                        std::vector<Shortcut> *shortcuts) {
+        const std::vector<Arc> &neighbours = arcs[node];
+        size_t count = 0;
+        for (size_t i = 0; i + 1 < neighbours.size(); ++i) {
+            const Arc &from = neighbours[i];
+            float limit = 0.0f;
+            for (size_t j = i + 1; j < neighbours.size(); ++j) {
+                limit = std::max(limit, from.weight + neighbours[j].weight);
+            }
+            searchWitnesses(search, arcs, levels, from.node, node, limit, settleLimit);
+
+            for (size_t j = i + 1; j < neighbours.size(); ++j) {
+                const Arc &to = neighbours[j];
+                const float via = from.weight + to.weight;
+                if (search.reachedIn[to.node] == search.query && search.distances[to.node] <= via) {
+                    continue;
+                }
+                ++count;
+                if (shortcuts) {
+                    shortcuts->push_back({from.node, to.node, via, node});
+                }
+            }
+        }
+        return count;
+    }
+
+    int32_t nodePriority(WitnessSearch &search, const std::vector<std::vector<Arc>> &arcs,
+                         const std::vector<uint32_t> &levels, const std::vector<uint32_t> &contractedNeighbours,
+                         const uint32_t node, const size_t settleLimit) {
+        const size_t shortcuts = contractNode(search, arcs, levels, node, settleLimit, nullptr);
+        return static_cast<int32_t>(shortcuts) - static_cast<int32_t>(arcs[node].size()) +
+               static_cast<int32_t>(contractedNeighbours[node]);
+    }
+
+    // ========================================================================
+    // FILE
+    // ========================================================================
+    uint8_t *putField(uint8_t *p, const uint32_t value) {
+        for (size_t i = 0; i < 4; ++i) {
+            *p++ = static_cast<uint8_t>(value >> (8 * i));
+        }
+        return p;
+    }
+
+    uint32_t getField(const uint8_t *p) {
+        return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    // Every edge leads to a higher level and every shortcut bypasses a node below both
+    // of its ends, which bounds the unpacking stack by the number of levels
+    bool isValidHierarchy(const ContractionHierarchy &hierarchy) {
+        const size_t nodeCount = hierarchy.nodeCount;
+        if (hierarchy.firstEdge[0] != 0 || hierarchy.firstEdge[nodeCount] != hierarchy.edgeCount) {
+            return false;
+        }
+        for (size_t node = 0; node < nodeCount; ++node) {
+            const uint32_t first = hierarchy.firstEdge[node];
+            const uint32_t last = hierarchy.firstEdge[node + 1];
+            if (first > last || last > hierarchy.edgeCount) {
+                return false;
+            }
+            for (uint32_t edge = first; edge < last; ++edge) {
+                const uint32_t target = hierarchy.targets[edge];
+                const uint32_t middle = hierarchy.middles[edge];
+                if (target >= nodeCount || hierarchy.levels[target] <= hierarchy.levels[node] ||
+                    (middle != NO_MIDDLE &&
+                     (middle >= nodeCount || hierarchy.levels[middle] >= hierarchy.levels[node]))) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // ========================================================================
+    // QUERY
+    // ========================================================================
+    // The edge between two adjacent nodes is kept at the lower one
+    bool findHierarchyEdge(const ContractionHierarchy &hierarchy, const uint32_t a, const uint32_t b,
+                           uint32_t &edge) {
+        const bool aLower = hierarchy.levels[a] < hierarchy.levels[b];
+        const uint32_t lower = aLower ? a : b;
+        const uint32_t upper = aLower ? b : a;
+        for (edge = hierarchy.firstEdge[lower]; edge < hierarchy.firstEdge[lower + 1]; ++edge) {
+            if (hierarchy.targets[edge] == upper) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Appends the streets from a to b to the path, b included, a not
+    bool unpackEdge(HierarchyQuery &query, const uint32_t a, const uint32_t b) {
+        const ContractionHierarchy &hierarchy = *query.hierarchy;
+        query.unpack.clear();
+        query.unpack.push_back(a);
+        query.unpack.push_back(b);
+        while (!query.unpack.empty()) {
+            const uint32_t to = query.unpack.back();
+            query.unpack.pop_back();
+            const uint32_t from = query.unpack.back();
+            query.unpack.pop_back();
+
+            uint32_t edge;
+            if (!findHierarchyEdge(hierarchy, from, to, edge)) {
+                return false;
+            }
+            const uint32_t middle = hierarchy.middles[edge];
+            if (middle == NO_MIDDLE) {
+                query.path.push_back(to);
+                continue;
+            }
+            // The first half is popped first
+            query.unpack.push_back(middle);
+            query.unpack.push_back(to);
+            query.unpack.push_back(from);
+            query.unpack.push_back(middle);
+        }
+        return true;
+    }
+}
+
+void buildContractionHierarchy(const RoadGraph &graph, const ContractionOptions &options,
+                               ContractionHierarchyData &data, ContractionStats &stats) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t nodeCount = graph.xs.size();
+    const size_t threads = resolveThreads(options.threads);
+    stats = ContractionStats{};
+
+    std::vector<std::vector<Arc>> arcs(nodeCount);
+    for (uint32_t node = 0; node < nodeCount; ++node) {
+        for (uint32_t edge = graph.firstEdge[node]; edge < graph.firstEdge[node + 1]; ++edge) {
+            if (graph.targets[edge] != node) {
+                addArc(arcs[node], graph.targets[edge], graph.lengths[edge], NO_MIDDLE);
+            }
+        }
+    }
+
+    std::vector<uint32_t> levels(nodeCount, UNCONTRACTED);
+    std::vector<uint32_t> contractedNeighbours(nodeCount, 0);
+    std::vector<int32_t> priorities(nodeCount, 0);
+    std::vector<std::vector<Arc>> upward(nodeCount);
+
+    std::vector<WitnessSearch> searches(threads);
+    for (WitnessSearch &search: searches) {
+        search.distances.assign(nodeCount, 0.0f);
+        search.reachedIn.assign(nodeCount, 0);
+    }
+    std::vector<std::vector<Shortcut>> shortcuts(threads);
+
+    // Priorities of the given nodes, sliced over the workers
+    const auto updatePriorities = [&](const std::vector<uint32_t> &nodes) {
+        runSlices(threads, nodes.size(), [&](const size_t first, const size_t last, const size_t worker) {
+            for (size_t i = first; i < last; ++i) {
+                priorities[nodes[i]] = nodePriority(searches[worker], arcs, levels, contractedNeighbours, nodes[i],
+                                                    options.witnessSettleLimit);
+            }
+        });
+    };
+
+    std::vector<uint32_t> remaining(nodeCount);
+    for (uint32_t node = 0; node < nodeCount; ++node) {
+        remaining[node] = node;
+    }
+    updatePriorities(remaining);
+
+    std::vector<uint32_t> selected;
+    std::vector<uint32_t> touched;
+    std::vector<uint8_t> isTouched(nodeCount, 0);
+    for (uint32_t level = 0; !remaining.empty(); ++level) {
+        // Nodes below all their neighbours, ties to the lower id, so the set is never empty
+        selected.clear();
+        for (const uint32_t node: remaining) {
+            const bool lowest = std::all_of(arcs[node].begin(), arcs[node].end(), [&](const Arc &arc) {
+                return priorities[node] < priorities[arc.node] ||
+                       (priorities[node] == priorities[arc.node] && node < arc.node);
+            });
+            if (lowest) {
+                selected.push_back(node);
+                levels[node] = level;
+            }
+        }
+
+        runSlices(threads, selected.size(), [&](const size_t first, const size_t last, const size_t worker) {
+            for (size_t i = first; i < last; ++i) {
+                contractNode(searches[worker], arcs, levels, selected[i], options.witnessSettleLimit,
+                             &shortcuts[worker]);
+            }
+        });
+
+        // Edges to the neighbours still in the graph are the contracted node's upward edges
+        touched.clear();
+        for (const uint32_t node: selected) {
+            for (const Arc &arc: arcs[node]) {
+                removeArc(arcs[arc.node], node);
+                ++contractedNeighbours[arc.node];
+                if (!isTouched[arc.node]) {
+                    isTouched[arc.node] = 1;
+                    touched.push_back(arc.node);
+                }
+            }
+            upward[node] = std::move(arcs[node]);
+            arcs[node] = std::vector<Arc>();
+        }
+        for (std::vector<Shortcut> &list: shortcuts) {
+            for (const Shortcut &shortcut: list) {
+                addArc(arcs[shortcut.from], shortcut.to, shortcut.weight, shortcut.middle);
+                addArc(arcs[shortcut.to], shortcut.from, shortcut.weight, shortcut.middle);
+            }
+            list.clear();
+        }
+
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                       [&](const uint32_t node) { return levels[node] != UNCONTRACTED; }),
+                        remaining.end());
+        updatePriorities(touched);
+        for (const uint32_t node: touched) {
+            isTouched[node] = 0;
+        }
+        ++stats.rounds;
+    }
+
+    data.width = graph.width;
+    data.height = graph.height;
+    data.xs = graph.xs;
+    data.ys = graph.ys;
+    data.levels = std::move(levels);
+    data.firstEdge.assign(nodeCount + 1, 0);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        data.firstEdge[node + 1] = data.firstEdge[node] + static_cast<uint32_t>(upward[node].size());
+    }
+    const size_t edgeCount = data.firstEdge[nodeCount];
+    data.targets.resize(edgeCount);
+    data.weights.resize(edgeCount);
+    data.middles.resize(edgeCount);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        uint32_t edge = data.firstEdge[node];
+        for (const Arc &arc: upward[node]) {
+            data.targets[edge] = arc.node;
+            data.weights[edge] = arc.weight;
+            data.middles[edge] = arc.middle;
+            stats.shortcuts += arc.middle != NO_MIDDLE;
+            ++edge;
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool saveContractionHierarchy(const char *path, const ContractionHierarchyData &data) {
+    std::FILE *out = std::fopen(path, "wb");
+    if (!out) {
+        std::cout << "Greska pri pisanju fajla sa putanje \"" << path << "\"!" << std::endl;
+        return false;
+    }
+
+    uint8_t header[HEADER_SIZE] = {};
+    uint8_t *p = header;
+    std::memcpy(p, MAGIC, sizeof(MAGIC));
+    p += sizeof(MAGIC);
+    p = putField(p, VERSION);
+    p = putField(p, static_cast<uint32_t>(data.width));
+    p = putField(p, static_cast<uint32_t>(data.height));
+    p = putField(p, static_cast<uint32_t>(data.xs.size()));
+    putField(p, static_cast<uint32_t>(data.targets.size()));
+
+    const size_t nodeCount = data.xs.size();
+    const size_t edgeCount = data.targets.size();
+    bool written = std::fwrite(header, 1, HEADER_SIZE, out) == HEADER_SIZE;
+    written = written && std::fwrite(data.xs.data(), sizeof(float), nodeCount, out) == nodeCount;
+    written = written && std::fwrite(data.ys.data(), sizeof(float), nodeCount, out) == nodeCount;
+    written = written && std::fwrite(data.levels.data(), sizeof(uint32_t), nodeCount, out) == nodeCount;
+    written = written && std::fwrite(data.firstEdge.data(), sizeof(uint32_t), nodeCount + 1, out) == nodeCount + 1;
+    written = written && std::fwrite(data.targets.data(), sizeof(uint32_t), edgeCount, out) == edgeCount;
+    written = written && std::fwrite(data.weights.data(), sizeof(float), edgeCount, out) == edgeCount;
+    written = written && std::fwrite(data.middles.data(), sizeof(uint32_t), edgeCount, out) == edgeCount;
+    written = std::fclose(out) == 0 && written;
+    if (!written) {
+        std::cout << "Greska pri pisanju fajla sa putanje \"" << path << "\"!" << std::endl;
+    }
+    return written;
+}
+
+bool loadContractionHierarchy(const char *path, ContractionHierarchy &hierarchy) {
+    closeContractionHierarchy(hierarchy);
+    if (!openMappedFile(hierarchy.file, path)) {
+        return false;
+    }
+
+    // The arrays are used in place, the mapping starts on a page and every field is 4 bytes
+    const auto *data = reinterpret_cast<const uint8_t *>(hierarchy.file.data);
+    const size_t size = hierarchy.file.size;
+    bool valid = size >= HEADER_SIZE && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0 &&
+                 getField(data + 4) == VERSION;
+    const size_t nodeCount = valid ? getField(data + 16) : 0;
+    const size_t edgeCount = valid ? getField(data + 20) : 0;
+    valid = valid && size == HEADER_SIZE + nodeCount * 16 + 4 + edgeCount * 12;
+
+    if (valid) {
+        hierarchy.width = static_cast<int>(getField(data + 8));
+        hierarchy.height = static_cast<int>(getField(data + 12));
+        hierarchy.nodeCount = nodeCount;
+        hierarchy.edgeCount = edgeCount;
+        hierarchy.xs = reinterpret_cast<const float *>(data + HEADER_SIZE);
+        hierarchy.ys = hierarchy.xs + nodeCount;
+        hierarchy.levels = reinterpret_cast<const uint32_t *>(hierarchy.ys + nodeCount);
+        hierarchy.firstEdge = hierarchy.levels + nodeCount;
+        hierarchy.targets = hierarchy.firstEdge + nodeCount + 1;
+        hierarchy.weights = reinterpret_cast<const float *>(hierarchy.targets + edgeCount);
+        hierarchy.middles = reinterpret_cast<const uint32_t *>(hierarchy.weights + edgeCount);
+        valid = isValidHierarchy(hierarchy);
+    }
+
+    if (!valid) {
+        std::cout << "Fajl \"" << path << "\" nije ispravna hijerarhija ulica!" << std::endl;
+        closeContractionHierarchy(hierarchy);
+    }
+    return valid;
+}
+
+void viewContractionHierarchy(const ContractionHierarchyData &data, ContractionHierarchy &hierarchy) {
+    closeContractionHierarchy(hierarchy);
+    hierarchy.width = data.width;
+    hierarchy.height = data.height;
+    hierarchy.nodeCount = data.xs.size();
+    hierarchy.edgeCount = data.targets.size();
+    hierarchy.xs = data.xs.data();
+    hierarchy.ys = data.ys.data();
+    hierarchy.levels = data.levels.data();
+    hierarchy.firstEdge = data.firstEdge.data();
+    hierarchy.targets = data.targets.data();
+    hierarchy.weights = data.weights.data();
+    hierarchy.middles = data.middles.data();
+}
+
+void closeContractionHierarchy(ContractionHierarchy &hierarchy) {
+    closeMappedFile(hierarchy.file);
+    hierarchy = ContractionHierarchy{};
+}
+
+void createHierarchyQuery(HierarchyQuery &query, const ContractionHierarchy &hierarchy, const float snapRadius) {
+    const size_t nodeCount = hierarchy.nodeCount;
+    query.hierarchy = &hierarchy;
+    query.snapRadius = snapRadius;
+
+    createSpatialGrid(query.nodes, 0.0f, 0.0f, static_cast<float>(hierarchy.width),
+                      static_cast<float>(hierarchy.height), std::max(snapRadius, 1.0f), nodeCount);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        insertIntoGrid(query.nodes, static_cast<uint32_t>(node), hierarchy.xs[node], hierarchy.ys[node]);
+    }
+
+    for (int direction = 0; direction < 2; ++direction) {
+        query.distances[direction].assign(nodeCount, 0.0f);
+        query.parents[direction].assign(nodeCount, 0);
+        query.reachedIn[direction].assign(nodeCount, 0);
+        query.heaps[direction].clear();
+        query.heaps[direction].reserve(hierarchy.edgeCount + 1);
+    }
+
+    // Levels rise along both halves of a path in the hierarchy, and unpacking a
+    // shortcut leaves at most one pair pending per level below it
+    const uint32_t levelCount = nodeCount > 0 ? *std::max_element(hierarchy.levels, hierarchy.levels + nodeCount) + 1 : 0;
+    query.chain.clear();
+    query.chain.reserve(2 * static_cast<size_t>(levelCount) + 1);
+    query.unpack.clear();
+    query.unpack.reserve(4 * static_cast<size_t>(levelCount) + 2);
+    query.path.clear();
+    query.path.reserve(nodeCount);
+    query.query = 0;
+}
+
+int32_t snapToHierarchy(const HierarchyQuery &query, const float x, const float y) {
+    return findNearestInGrid(query.nodes, x, y, query.snapRadius);
+}
+
+bool findHierarchyPath(HierarchyQuery &query, const uint32_t source, const uint32_t target) {
+    TRACE_SCOPE("findHierarchyPath", "loop");
+    const ContractionHierarchy &hierarchy = *query.hierarchy;
+    query.path.clear();
+    query.chain.clear();
+    query.pathLength = 0.0f;
+    query.settled = 0;
+    if (source >= hierarchy.nodeCount || target >= hierarchy.nodeCount) {
+        return false;
+    }
+
+    if (++query.query == 0) {
+        for (int direction = 0; direction < 2; ++direction) {
+            std::fill(query.reachedIn[direction].begin(), query.reachedIn[direction].end(), 0);
+        }
+        query.query = 1;
+    }
+    const uint32_t stamp = query.query;
+
+    const uint32_t ends[2] = {source, target};
+    for (int direction = 0; direction < 2; ++direction) {
+        query.heaps[direction].clear();
+        query.distances[direction][ends[direction]] = 0.0f;
+        query.parents[direction][ends[direction]] = ends[direction];
+        query.reachedIn[direction][ends[direction]] = stamp;
+        query.heaps[direction].push_back({0.0f, ends[direction]});
+    }
+
+    float best = INFINITE_DISTANCE;
+    uint32_t meeting = 0;
+    while (!query.heaps[0].empty() || !query.heaps[1].empty()) {
+        // The direction with the closer open node goes next
+        const int direction = query.heaps[1].empty() ||
+                              (!query.heaps[0].empty() &&
+                               query.heaps[0].front().estimate <= query.heaps[1].front().estimate) ? 0 : 1;
+        std::vector<RoadHeapEntry> &heap = query.heaps[direction];
+        std::vector<float> &distances = query.distances[direction];
+
+        std::pop_heap(heap.begin(), heap.end(), laterEntry);
+        const RoadHeapEntry entry = heap.back();
+        heap.pop_back();
+        if (entry.estimate > distances[entry.node]) {
+            continue;
+        }
+        if (entry.estimate >= best) {
+            heap.clear();
+            continue;
+        }
+        ++query.settled;
+
+        const int other = 1 - direction;
+        if (query.reachedIn[other][entry.node] == stamp) {
+            const float through = entry.estimate + query.distances[other][entry.node];
+            if (through < best) {
+                best = through;
+                meeting = entry.node;
+            }
+        }
+
+        for (uint32_t edge = hierarchy.firstEdge[entry.node]; edge < hierarchy.firstEdge[entry.node + 1]; ++edge) {
+            const uint32_t next = hierarchy.targets[edge];
+            const float candidate = entry.estimate + hierarchy.weights[edge];
+            if (query.reachedIn[direction][next] == stamp && candidate >= distances[next]) {
+                continue;
+            }
+            distances[next] = candidate;
+            query.parents[direction][next] = entry.node;
+            query.reachedIn[direction][next] = stamp;
+            heap.push_back({candidate, next});
+            std::push_heap(heap.begin(), heap.end(), laterEntry);
+        }
+    }
+    if (best == INFINITE_DISTANCE) {
+        return false;
+    }
+
+    // Source up to the meeting node, then down to the target
+    for (uint32_t node = meeting; node != source; node = query.parents[0][node]) {
+        query.chain.push_back(node);
+    }
+    query.chain.push_back(source);
+    std::reverse(query.chain.begin(), query.chain.end());
+    for (uint32_t node = meeting; node != target;) {
+        node = query.parents[1][node];
+        query.chain.push_back(node);
+    }
+
+    query.path.push_back(source);
+    for (size_t i = 0; i + 1 < query.chain.size(); ++i) {
+        if (!unpackEdge(query, query.chain[i], query.chain[i + 1])) {
+            query.path.clear();
+            return false;
+        }
+    }
+    query.pathLength = best;
+    return true;
+}
@@ -0,0 +1,138 @@
+#include "../Header/Display.h"
+#include "../Header/Trace.h"
+
+#include <thread>
+
+bool createWindowDisplay(Display &display, InputQueue &inputQueue) {
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWmonitor *monitor = glfwGetPrimaryMonitor();
+    if (!monitor) {
+        return false;
+    }
+    const GLFWvidmode *mode = glfwGetVideoMode(monitor);
+
+    glfwWindowHint(GLFW_RED_BITS, mode->redBits);
+    glfwWindowHint(GLFW_GREEN_BITS, mode->greenBits);
+    glfwWindowHint(GLFW_BLUE_BITS, mode->blueBits);
+    glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
+    glfwWindowHint(GLFW_STENCIL_BITS, 8); // Polygon fills
+
+    display.window = glfwCreateWindow(mode->width, mode->height, "Kretanje po mapi", monitor, nullptr);
+    if (!display.window) {
+        return false;
+    }
+
+    glfwMakeContextCurrent(display.window);
+    installInputCallbacks(display.window, inputQueue);
+    return true;
+}
+
+bool createHeadlessDisplay(Display &display, const int width, const int height) {
+    return createHeadlessContext(display.headless, width, height);
+}
+
+void destroyDisplay(Display &display) {
+    if (display.window) {
+        glfwDestroyWindow(display.window);
+        display.window = nullptr;
+    } else {
+        destroyHeadlessContext(display.headless);
+    }
+}
+
+GLADloadproc getDisplayLoader(const Display &display) {
+    if (display.window) {
+        return reinterpret_cast<GLADloadproc>(glfwGetProcAddress);
+    }
+    return getHeadlessProcAddress;
+}
+
+void setupDisplayFramebuffer(Display &display) {
+    if (!display.window) {
+        createHeadlessFramebuffer(display.headless);
+    }
+}
+
+double getDisplayTime(const Display &display) {
+    if (display.window) {
+        return glfwGetTime();
+    }
+    if (display.fixedTimeStep > 0.0) {
+        return display.virtualTime;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - display.startTime;
+    return elapsed.count();
+}
+
+bool shouldCloseDisplay(const Display &display) {
+    if (display.window) {
+        return glfwWindowShouldClose(display.window);
+    }
+    return display.closeRequested;
+}
+
+void requestDisplayClose(Display &display) {
+    display.closeRequested = true;
+    if (display.window) {
+        glfwSetWindowShouldClose(display.window, GLFW_TRUE);
+    }
+}
+
+void getDisplaySize(const Display &display, int &screenWidth, int &screenHeight,
+                    int &framebufferWidth, int &framebufferHeight) {
+    if (display.window) {
+        glfwGetWindowSize(display.window, &screenWidth, &screenHeight);
+        glfwGetFramebufferSize(display.window, &framebufferWidth, &framebufferHeight);
+        return;
+    }
+
+    screenWidth = framebufferWidth = display.headless.width;
+    screenHeight = framebufferHeight = display.headless.height;
+}
+
+unsigned int getDisplayFramebuffer(const Display &display) {
+    return display.window ? 0 : display.headless.framebuffer;
+}
+
+void getDisplayCursor(const Display &display, const InputState &input, double &x, double &y) {
+    if (display.window) {
+        glfwGetCursorPos(display.window, &x, &y);
+        return;
+    }
+
+    x = input.cursorX;
+    y = input.cursorY;
+}
+
+void presentDisplay(Display &display) {
+    if (display.window) {
+        {
+            TRACE_SCOPE("swap", "loop");
+            glfwSwapBuffers(display.window);
+        }
+        TRACE_SCOPE("poll", "loop");
+        glfwPollEvents();
+        return;
+    }
+
+    // Nothing to show, but submit the frame so GPU timings and fences keep moving
+    TRACE_SCOPE("swap", "loop");
+    glFlush();
+    display.virtualTime += display.fixedTimeStep;
+}
+
+void waitDisplay(const Display &display, const double seconds) {
+    if (seconds <= 0.0 || display.fixedTimeStep > 0.0) {
+        return;
+    }
+
+    if (display.window) {
+        glfwWaitEventsTimeout(seconds);
+    } else {
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    }
+}
@@ -0,0 +1,79 @@
+#include "../Header/FrameArena.h"
+
+#include <cstdint>
+#include <new>
+
+namespace {
+    // Overflow blocks start with the link to the next block, the payload follows
+    constexpr size_t OVERFLOW_HEADER = alignof(std::max_align_t);
+
+    size_t alignUp(const size_t value, const size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    void releaseOverflowBlocks(FrameArena &arena) {
+        void *block = arena.overflowBlocks;
+        while (block) {
+            void *next = *static_cast<void **>(block);
+            ::operator delete(block);
+            block = next;
+        }
+        arena.overflowBlocks = nullptr;
+        arena.overflowBytes = 0;
+    }
+
+    void *allocateOverflow(FrameArena &arena, const size_t size, const size_t alignment) {
+        // Over-allocate so the payload can be aligned beyond max_align_t as well
+        const size_t blockSize = OVERFLOW_HEADER + size + alignment;
+        auto *block = static_cast<unsigned char *>(::operator new(blockSize));
+        *reinterpret_cast<void **>(block) = arena.overflowBlocks;
+        arena.overflowBlocks = block;
+        arena.overflowBytes += size + alignment;
+
+        const auto payload = alignUp(reinterpret_cast<uintptr_t>(block + OVERFLOW_HEADER), alignment);
+        return reinterpret_cast<void *>(payload);
+    }
+}
+
+void createFrameArena(FrameArena &arena, const size_t capacity) {
+    arena.memory = static_cast<unsigned char *>(::operator new(capacity));
+    arena.capacity = capacity;
+    arena.offset = 0;
+}
+
+void destroyFrameArena(FrameArena &arena) {
+    releaseOverflowBlocks(arena);
+    ::operator delete(arena.memory);
+    arena.memory = nullptr;
+    arena.capacity = 0;
+    arena.offset = 0;
+}
+
+void resetFrameArena(FrameArena &arena) {
+    const size_t used = arena.offset + arena.overflowBytes;
+    if (used > arena.highWater) {
+        arena.highWater = used;
+    }
+
+    // The last frame did not fit, grow once instead of overflowing every frame from now on
+    if (arena.overflowBytes > 0) {
+        releaseOverflowBlocks(arena);
+        ::operator delete(arena.memory);
+        arena.capacity = alignUp(arena.highWater + arena.highWater / 2, 4096);
+        arena.memory = static_cast<unsigned char *>(::operator new(arena.capacity));
+    }
+
+    arena.offset = 0;
+}
+
+void *allocateFromArena(FrameArena &arena, const size_t size, const size_t alignment) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(arena.memory);
+    const size_t start = alignUp(base + arena.offset, alignment) - base;
+
+    if (start + size > arena.capacity) {
+        return allocateOverflow(arena, size, alignment);
+    }
+
+    arena.offset = start + size;
+    return arena.memory + start;
+}
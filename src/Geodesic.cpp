@@ -0,0 +1,207 @@
+#include "../Header/Geodesic.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Header/PointKernels.h"
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double RADIANS = PI / 180.0;
+
+    // WGS 84 ellipsoid
+    constexpr double WGS84_A = 6378137.0;
+    constexpr double WGS84_F = 1.0 / 298.257223563;
+    constexpr double WGS84_B = WGS84_A * (1.0 - WGS84_F);
+
+    constexpr int VINCENTY_ITERATIONS = 200;
+    constexpr double VINCENTY_TOLERANCE = 1e-12;
+
+    // Points converted per batch, on the stack
+    constexpr size_t CHUNK = 256;
+
+    // Great circle distance from the chord between two unit vectors
+    double chordToDistance(const double chord) {
+        return 2.0 * MEAN_EARTH_RADIUS * std::asin(std::min(1.0, chord / 2.0));
+    }
+
+    void computeHaversineChunk(const double *longitudes, const double *latitudes, const size_t count,
+                               double *lengths) {
+        double xs[CHUNK + 1] = {}, ys[CHUNK + 1] = {}, zs[CHUNK + 1] = {};
+        for (size_t i = 0; i < count; ++i) {
+            const double longitude = longitudes[i] * RADIANS;
+            const double latitude = latitudes[i] * RADIANS;
+            const double cosLatitude = std::cos(latitude);
+            xs[i] = cosLatitude * std::cos(longitude);
+            ys[i] = cosLatitude * std::sin(longitude);
+            zs[i] = std::sin(latitude);
+        }
+
+        computeChordLengths(xs, ys, zs, count, lengths);
+        for (size_t i = 0; i + 1 < count; ++i) {
+            lengths[i] = chordToDistance(lengths[i]);
+        }
+    }
+}
+
+// ============================================================================
+// POINT PAIRS
+// ============================================================================
+double haversineDistance(const double longitude1, const double latitude1, const double longitude2,
+                         const double latitude2) {
+    const double sinLatitude = std::sin((latitude2 - latitude1) * RADIANS / 2.0);
+    const double sinLongitude = std::sin((longitude2 - longitude1) * RADIANS / 2.0);
+    const double h = sinLatitude * sinLatitude +
+                     std::cos(latitude1 * RADIANS) * std::cos(latitude2 * RADIANS) * sinLongitude * sinLongitude;
+    return 2.0 * MEAN_EARTH_RADIUS * std::asin(std::min(1.0, std::sqrt(h)));
+}
+
+double vincentyDistance(const double longitude1, const double latitude1, const double longitude2,
+                        const double latitude2) {
+    const double l = (longitude2 - longitude1) * RADIANS;
+    const double u1 = std::atan((1.0 - WGS84_F) * std::tan(latitude1 * RADIANS));
+    const double u2 = std::atan((1.0 - WGS84_F) * std::tan(latitude2 * RADIANS));
+    const double sinU1 = std::sin(u1), cosU1 = std::cos(u1);
+    const double sinU2 = std::sin(u2), cosU2 = std::cos(u2);
+
+    double lambda = l;
+    double sinSigma = 0.0, cosSigma = 0.0, sigma = 0.0, cosSquaredAlpha = 0.0, cos2SigmaM = 0.0;
+    bool converged = false;
+
+    for (int iteration = 0; iteration < VINCENTY_ITERATIONS; ++iteration) {
+        const double sinLambda = std::sin(lambda);
+        const double cosLambda = std::cos(lambda);
+        const double crossTerm = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+        sinSigma = std::sqrt(cosU2 * sinLambda * cosU2 * sinLambda + crossTerm * crossTerm);
+        if (sinSigma == 0.0) {
+            return 0.0; // Coincident points
+        }
+
+        cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+        sigma = std::atan2(sinSigma, cosSigma);
+        const double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+        cosSquaredAlpha = 1.0 - sinAlpha * sinAlpha;
+        // Both points on the equator leave cos^2 alpha at zero
+        cos2SigmaM = cosSquaredAlpha != 0.0 ? cosSigma - 2.0 * sinU1 * sinU2 / cosSquaredAlpha : 0.0;
+
+        const double c = WGS84_F / 16.0 * cosSquaredAlpha * (4.0 + WGS84_F * (4.0 - 3.0 * cosSquaredAlpha));
+        const double previous = lambda;
+        lambda = l + (1.0 - c) * WGS84_F * sinAlpha *
+                 (sigma + c * sinSigma * (cos2SigmaM + c * cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM)));
+
+        if (std::abs(lambda - previous) < VINCENTY_TOLERANCE) {
+            converged = true;
+            break;
+        }
+    }
+
+    if (!converged) {
+        return haversineDistance(longitude1, latitude1, longitude2, latitude2);
+    }
+
+    const double uSquared = cosSquaredAlpha * (WGS84_A * WGS84_A - WGS84_B * WGS84_B) / (WGS84_B * WGS84_B);
+    const double a = 1.0 + uSquared / 16384.0 * (4096.0 + uSquared * (-768.0 + uSquared * (320.0 - 175.0 * uSquared)));
+    const double b = uSquared / 1024.0 * (256.0 + uSquared * (-128.0 + uSquared * (74.0 - 47.0 * uSquared)));
+    const double deltaSigma = b * sinSigma * (cos2SigmaM + b / 4.0 *
+                                  (cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM) -
+                                   b / 6.0 * cos2SigmaM * (-3.0 + 4.0 * sinSigma * sinSigma) *
+                                   (-3.0 + 4.0 * cos2SigmaM * cos2SigmaM)));
+    return WGS84_B * a * (sigma - deltaSigma);
+}
+
+double geodesicDistance(const GeodesicMethod method, const double longitude1, const double latitude1,
+                        const double longitude2, const double latitude2) {
+    if (method == GeodesicMethod::Vincenty) {
+        return vincentyDistance(longitude1, latitude1, longitude2, latitude2);
+    }
+    return haversineDistance(longitude1, latitude1, longitude2, latitude2);
+}
+
+// ============================================================================
+// COMPENSATED SUMS
+// ============================================================================
+void addDistance(DistanceSum &total, const double distance) {
+    const double sum = total.sum + distance;
+    // Keep the low-order bits of whichever operand lost them
+    if (std::abs(total.sum) >= std::abs(distance)) {
+        total.compensation += (total.sum - sum) + distance;
+    } else {
+        total.compensation += (distance - sum) + total.sum;
+    }
+    total.sum = sum;
+}
+
+double getDistance(const DistanceSum &total) {
+    return total.sum + total.compensation;
+}
+
+// ============================================================================
+// POLYLINES
+// ============================================================================
+void computeGeodesicLengths(const GeodesicMethod method, const double *longitudes, const double *latitudes,
+                            const size_t count, double *lengths) {
+    if (method == GeodesicMethod::Vincenty) {
+        for (size_t i = 0; i + 1 < count; ++i) {
+            lengths[i] = vincentyDistance(longitudes[i], latitudes[i], longitudes[i + 1], latitudes[i + 1]);
+        }
+        return;
+    }
+
+    // Chunks overlap by one point so every segment is covered once
+    for (size_t first = 0; first + 1 < count; first += CHUNK) {
+        const size_t points = std::min(CHUNK + 1, count - first);
+        computeHaversineChunk(longitudes + first, latitudes + first, points, lengths + first);
+    }
+}
+
+double sumGeodesicLengths(const GeodesicMethod method, const double *longitudes, const double *latitudes,
+                          const size_t count) {
+    double lengths[CHUNK];
+    DistanceSum total;
+    for (size_t first = 0; first + 1 < count; first += CHUNK) {
+        const size_t points = std::min(CHUNK + 1, count - first);
+        computeGeodesicLengths(method, longitudes + first, latitudes + first, points, lengths);
+        for (size_t i = 0; i + 1 < points; ++i) {
+            addDistance(total, lengths[i]);
+        }
+    }
+    return getDistance(total);
+}
+
+double measureMapPolyline(const void *context, const float *xs, const float *ys, const size_t count) {
+    const auto &geodesic = *static_cast<const MapGeodesic *>(context);
+    const Georeference *georeference = geodesic.georeference;
+    if (!georeference || georeference->projection != MapProjection::WebMercator) {
+        return sumSegmentLengths(xs, ys, count);
+    }
+
+    double longitudes[CHUNK + 1], latitudes[CHUNK + 1], lengths[CHUNK];
+    DistanceSum total;
+    for (size_t first = 0; first + 1 < count; first += CHUNK) {
+        const size_t points = std::min(CHUNK + 1, count - first);
+        metresToGeographic(*georeference, xs + first, ys + first, points, longitudes, latitudes);
+        computeGeodesicLengths(geodesic.method, longitudes, latitudes, points, lengths);
+        for (size_t i = 0; i + 1 < points; ++i) {
+            addDistance(total, lengths[i]);
+        }
+    }
+    return getDistance(total);
+}
+
+double measureMapStep(const MapGeodesic &geodesic, const double mapX1, const double mapY1, const double mapX2,
+                      const double mapY2) {
+    const Georeference &georeference = *geodesic.georeference;
+    if (georeference.projection != MapProjection::WebMercator) {
+        double dx, dy;
+        applyAffineToVector(georeference.mapToMetres, mapX2 - mapX1, mapY2 - mapY1, dx, dy);
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    const AffineTransform mapToWorld = composeAffine(georeference.pixelToWorld, georeference.mapToPixel);
+    double x1, y1, x2, y2;
+    applyAffine(mapToWorld, mapX1, mapY1, x1, y1);
+    applyAffine(mapToWorld, mapX2, mapY2, x2, y2);
+    worldToGeographic(georeference, x1, y1, x1, y1);
+    worldToGeographic(georeference, x2, y2, x2, y2);
+    return geodesicDistance(geodesic.method, x1, y1, x2, y2);
+}
@@ -0,0 +1,204 @@
+#include "../Header/Georeference.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include "../Header/Trace.h"
+
+namespace {
+    constexpr double EARTH_RADIUS = 6378137.0; // WGS 84 semi-major axis, the Web Mercator sphere
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double DEGREES = 180.0 / PI;
+    constexpr double RADIANS = PI / 180.0;
+
+    // Scales world units to ground metres around the map centre
+    double metresPerWorldUnit(const Georeference &geo) {
+        if (geo.projection == MapProjection::WebMercator) {
+            const double latitude = 2.0 * std::atan(std::exp(geo.centreY / EARTH_RADIUS)) - PI / 2.0;
+            return std::cos(latitude);
+        }
+        return 1.0;
+    }
+
+    void updateDerivedTransforms(Georeference &geo) {
+        const double width = geo.imageWidth;
+        const double height = geo.imageHeight;
+
+        // Pixel centres, so map -1 and 1 land on the outer edges of the border pixels
+        geo.mapToPixel = {width / 2.0, 0.0, width / 2.0 - 0.5, 0.0, -height / 2.0, height / 2.0 - 0.5};
+        geo.pixelToMap = invertAffine(geo.mapToPixel);
+        geo.worldToPixel = invertAffine(geo.pixelToWorld);
+
+        const AffineTransform mapToWorld = composeAffine(geo.pixelToWorld, geo.mapToPixel);
+        geo.centreX = mapToWorld.c;
+        geo.centreY = mapToWorld.f;
+
+        const double scale = metresPerWorldUnit(geo);
+        const AffineTransform worldToMetres = {scale, 0.0, -scale * geo.centreX, 0.0, scale, -scale * geo.centreY};
+        geo.mapToMetres = composeAffine(worldToMetres, mapToWorld);
+        geo.metresToMap = invertAffine(geo.mapToMetres);
+    }
+}
+
+// ============================================================================
+// AFFINE TRANSFORMS
+// ============================================================================
+AffineTransform composeAffine(const AffineTransform &outer, const AffineTransform &inner) {
+    return {
+        outer.a * inner.a + outer.b * inner.d,
+        outer.a * inner.b + outer.b * inner.e,
+        outer.a * inner.c + outer.b * inner.f + outer.c,
+        outer.d * inner.a + outer.e * inner.d,
+        outer.d * inner.b + outer.e * inner.e,
+        outer.d * inner.c + outer.e * inner.f + outer.f
+    };
+}
+
+AffineTransform invertAffine(const AffineTransform &t) {
+    const double determinant = t.a * t.e - t.b * t.d;
+    if (determinant == 0.0) {
+        return {};
+    }
+
+    const double a = t.e / determinant;
+    const double b = -t.b / determinant;
+    const double d = -t.d / determinant;
+    const double e = t.a / determinant;
+    return {a, b, -(a * t.c + b * t.f), d, e, -(d * t.c + e * t.f)};
+}
+
+PointTransform toPointTransform(const AffineTransform &t) {
+    return {
+        static_cast<float>(t.a), static_cast<float>(t.b), static_cast<float>(t.c),
+        static_cast<float>(t.d), static_cast<float>(t.e), static_cast<float>(t.f)
+    };
+}
+
+void applyAffine(const AffineTransform &t, const double x, const double y, double &outX, double &outY) {
+    outX = t.a * x + t.b * y + t.c;
+    outY = t.d * x + t.e * y + t.f;
+}
+
+void applyAffineToVector(const AffineTransform &t, const double x, const double y, double &outX, double &outY) {
+    outX = t.a * x + t.b * y;
+    outY = t.d * x + t.e * y;
+}
+
+AffineTransform ndcToMapTransform(const float mapPosX, const float mapPosY, const float mapScale) {
+    // The unit quad spans [-0.5, 0.5], so the map covers mapPos +- mapScale / 2
+    const double scale = 2.0 / mapScale;
+    return {scale, 0.0, -scale * mapPosX, 0.0, scale, -scale * mapPosY};
+}
+
+// ============================================================================
+// WORLD FILE
+// ============================================================================
+bool loadGeoreference(Georeference &geo, const char *worldFilePath, const int imageWidth, const int imageHeight,
+                      const MapProjection projection) {
+    TRACE_SCOPE_DETAIL("loadGeoreference", "load", worldFilePath);
+    geo.imageWidth = imageWidth > 0 ? imageWidth : 1;
+    geo.imageHeight = imageHeight > 0 ? imageHeight : 1;
+
+    // Line order of a world file: x size, y rotation, x rotation, y size, then the upper left pixel centre
+    std::ifstream file(worldFilePath);
+    AffineTransform pixelToWorld;
+    file >> pixelToWorld.a >> pixelToWorld.d >> pixelToWorld.b >> pixelToWorld.e >> pixelToWorld.c >> pixelToWorld.f;
+
+    geo.loaded = static_cast<bool>(file) && pixelToWorld.a * pixelToWorld.e - pixelToWorld.b * pixelToWorld.d != 0.0;
+    if (!geo.loaded) {
+        std::cout << "Greska pri citanju fajla sa putanje \"" << worldFilePath << "\"!" << std::endl;
+        geo.projection = MapProjection::LocalMetric;
+        geo.pixelToWorld = {1.0, 0.0, 0.0, 0.0, -1.0, 0.0};
+    } else {
+        geo.projection = projection;
+        geo.pixelToWorld = pixelToWorld;
+    }
+
+    updateDerivedTransforms(geo);
+    return geo.loaded;
+}
+
+// ============================================================================
+// BATCH TRANSFORMS
+// ============================================================================
+void mapToMetres(const Georeference &geo, const float *xs, const float *ys, const size_t count, float *outXs,
+                 float *outYs) {
+    transformPoints(xs, ys, count, toPointTransform(geo.mapToMetres), outXs, outYs);
+}
+
+void metresToMap(const Georeference &geo, const float *xs, const float *ys, const size_t count, float *outXs,
+                 float *outYs) {
+    transformPoints(xs, ys, count, toPointTransform(geo.metresToMap), outXs, outYs);
+}
+
+void mapToPixels(const Georeference &geo, const float *xs, const float *ys, const size_t count, float *outXs,
+                 float *outYs) {
+    transformPoints(xs, ys, count, toPointTransform(geo.mapToPixel), outXs, outYs);
+}
+
+void pixelsToMap(const Georeference &geo, const float *xs, const float *ys, const size_t count, float *outXs,
+                 float *outYs) {
+    transformPoints(xs, ys, count, toPointTransform(geo.pixelToMap), outXs, outYs);
+}
+
+void metresToWorld(const Georeference &geo, const float *xs, const float *ys, const size_t count, double *outXs,
+                   double *outYs) {
+    const double unitsPerMetre = 1.0 / metresPerWorldUnit(geo);
+    for (size_t i = 0; i < count; ++i) {
+        outXs[i] = geo.centreX + xs[i] * unitsPerMetre;
+        outYs[i] = geo.centreY + ys[i] * unitsPerMetre;
+    }
+}
+
+bool worldToGeographic(const Georeference &geo, const double x, const double y, double &longitude,
+                       double &latitude) {
+    if (geo.projection != MapProjection::WebMercator) {
+        return false;
+    }
+
+    longitude = x / EARTH_RADIUS * DEGREES;
+    latitude = (2.0 * std::atan(std::exp(y / EARTH_RADIUS)) - PI / 2.0) * DEGREES;
+    return true;
+}
+
+bool metresToGeographic(const Georeference &geo, const float *xs, const float *ys, const size_t count,
+                        double *longitudes, double *latitudes) {
+    if (geo.projection != MapProjection::WebMercator) {
+        return false;
+    }
+
+    metresToWorld(geo, xs, ys, count, longitudes, latitudes);
+    for (size_t i = 0; i < count; ++i) {
+        worldToGeographic(geo, longitudes[i], latitudes[i], longitudes[i], latitudes[i]);
+    }
+    return true;
+}
+
+bool geographicToWorld(const Georeference &geo, const double longitude, const double latitude, double &x,
+                       double &y) {
+    if (geo.projection != MapProjection::WebMercator) {
+        return false;
+    }
+
+    x = longitude * RADIANS * EARTH_RADIUS;
+    y = std::log(std::tan(PI / 4.0 + latitude * RADIANS / 2.0)) * EARTH_RADIUS;
+    return true;
+}
+
+bool geographicToMetres(const Georeference &geo, const double *longitudes, const double *latitudes,
+                        const size_t count, float *outXs, float *outYs) {
+    if (geo.projection != MapProjection::WebMercator) {
+        return false;
+    }
+
+    // Offsets from the centre are taken in double, only the metres are narrowed to float
+    const double scale = metresPerWorldUnit(geo);
+    for (size_t i = 0; i < count; ++i) {
+        double x, y;
+        geographicToWorld(geo, longitudes[i], latitudes[i], x, y);
+        outXs[i] = static_cast<float>((x - geo.centreX) * scale);
+        outYs[i] = static_cast<float>((y - geo.centreY) * scale);
+    }
+    return true;
+}
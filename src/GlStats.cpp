@@ -0,0 +1,445 @@
+#include "../Header/GlStats.h"
+
+#include <glad/glad.h>
+
+// ============================================================================
+// COUNTERS
+// ============================================================================
+namespace {
+    // GL calls only come from the thread owning the context, the counters need no atomics
+    GlFrameStats accumulated;
+    bool installed = false;
+    thread_local GlSubsystem currentSubsystem = GlSubsystem::Other;
+
+    void addCount(const GlCounter counter, const uint64_t amount = 1) {
+        accumulated.counts[static_cast<int>(currentSubsystem)][static_cast<int>(counter)] += amount;
+    }
+
+    void countUpload(const GlCounter counter, const uint64_t bytes) {
+        addCount(counter);
+        addCount(GlCounter::UploadBytes, bytes);
+    }
+
+    // Size of one pixel of client data, enough for the formats this project uploads
+    uint64_t getPixelSize(const GLenum format, const GLenum type) {
+        switch (type) {
+            case GL_UNSIGNED_INT_24_8:
+            case GL_UNSIGNED_INT_8_8_8_8:
+            case GL_UNSIGNED_INT_8_8_8_8_REV:
+                return 4;
+            default:
+                break;
+        }
+
+        uint64_t components = 4;
+        switch (format) {
+            case GL_RED:
+            case GL_DEPTH_COMPONENT:
+            case GL_STENCIL_INDEX:
+                components = 1;
+                break;
+            case GL_RG:
+                components = 2;
+                break;
+            case GL_RGB:
+            case GL_BGR:
+                components = 3;
+                break;
+            default:
+                break;
+        }
+
+        switch (type) {
+            case GL_UNSIGNED_SHORT:
+            case GL_SHORT:
+            case GL_HALF_FLOAT:
+                return components * 2;
+            case GL_UNSIGNED_INT:
+            case GL_INT:
+            case GL_FLOAT:
+                return components * 4;
+            default:
+                return components;
+        }
+    }
+}
+
+const char *getGlCounterName(const GlCounter counter) {
+    switch (counter) {
+        case GlCounter::DrawCalls: return "drawCalls";
+        case GlCounter::Binds: return "binds";
+        case GlCounter::StateChanges: return "stateChanges";
+        case GlCounter::UniformUploads: return "uniformUploads";
+        case GlCounter::BufferUploads: return "bufferUploads";
+        case GlCounter::TextureUploads: return "textureUploads";
+        case GlCounter::UploadBytes: return "uploadBytes";
+        default: return "unknown";
+    }
+}
+
+const char *getGlSubsystemName(const GlSubsystem subsystem) {
+    switch (subsystem) {
+        case GlSubsystem::Other: return "other";
+        case GlSubsystem::Map: return "map";
+        case GlSubsystem::Overlay: return "overlay";
+        case GlSubsystem::Resolve: return "resolve";
+        case GlSubsystem::Hud: return "hud";
+        case GlSubsystem::Badge: return "badge";
+        case GlSubsystem::Profiler: return "profiler";
+        case GlSubsystem::LateLatch: return "lateLatch";
+        case GlSubsystem::Loading: return "loading";
+        default: return "unknown";
+    }
+}
+
+uint64_t GlFrameStats::total(const GlCounter counter) const {
+    uint64_t sum = 0;
+    for (const auto &subsystem: counts) {
+        sum += subsystem[static_cast<int>(counter)];
+    }
+    return sum;
+}
+
+void collectGlFrameStats(GlFrameStats &frame) {
+    frame = accumulated;
+    accumulated = GlFrameStats{};
+}
+
+void recordGlMappedUpload(const uint64_t bytes) {
+    if (installed) {
+        countUpload(GlCounter::BufferUploads, bytes);
+    }
+}
+
+GlSubsystem setGlSubsystem(const GlSubsystem subsystem) {
+    const GlSubsystem previous = currentSubsystem;
+    currentSubsystem = subsystem;
+    return previous;
+}
+
+bool isGlStatsInstalled() {
+    return installed;
+}
+
+// ============================================================================
+// WRAPPERS
+// ============================================================================
+namespace {
+    struct OriginalFunctions {
+        PFNGLDRAWARRAYSPROC drawArrays;
+        PFNGLDRAWELEMENTSPROC drawElements;
+        PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced;
+        PFNGLDRAWELEMENTSINSTANCEDPROC drawElementsInstanced;
+        PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC drawElementsInstancedBaseInstance;
+        PFNGLMULTIDRAWARRAYSINDIRECTPROC multiDrawArraysIndirect;
+        PFNGLMULTIDRAWELEMENTSINDIRECTPROC multiDrawElementsIndirect;
+
+        PFNGLUSEPROGRAMPROC useProgram;
+        PFNGLBINDVERTEXARRAYPROC bindVertexArray;
+        PFNGLBINDBUFFERPROC bindBuffer;
+        PFNGLBINDBUFFERBASEPROC bindBufferBase;
+        PFNGLBINDBUFFERRANGEPROC bindBufferRange;
+        PFNGLBINDTEXTUREPROC bindTexture;
+        PFNGLBINDFRAMEBUFFERPROC bindFramebuffer;
+        PFNGLBINDRENDERBUFFERPROC bindRenderbuffer;
+
+        PFNGLENABLEPROC enable;
+        PFNGLDISABLEPROC disable;
+        PFNGLBLENDFUNCPROC blendFunc;
+        PFNGLSTENCILFUNCPROC stencilFunc;
+        PFNGLSTENCILOPPROC stencilOp;
+        PFNGLSTENCILMASKPROC stencilMask;
+        PFNGLCOLORMASKPROC colorMask;
+        PFNGLVIEWPORTPROC viewport;
+        PFNGLACTIVETEXTUREPROC activeTexture;
+
+        PFNGLUNIFORM1IPROC uniform1i;
+        PFNGLUNIFORM1FPROC uniform1f;
+        PFNGLUNIFORM2FPROC uniform2f;
+        PFNGLUNIFORM3FPROC uniform3f;
+        PFNGLUNIFORM4FPROC uniform4f;
+        PFNGLUNIFORM2FVPROC uniform2fv;
+        PFNGLUNIFORMMATRIX4FVPROC uniformMatrix4fv;
+
+        PFNGLBUFFERDATAPROC bufferData;
+        PFNGLBUFFERSUBDATAPROC bufferSubData;
+        PFNGLBUFFERSTORAGEPROC bufferStorage;
+        PFNGLTEXIMAGE2DPROC texImage2D;
+        PFNGLTEXSUBIMAGE2DPROC texSubImage2D;
+    } original;
+
+    // --- Draws ---
+    void APIENTRY countDrawArrays(GLenum mode, GLint first, GLsizei count) {
+        addCount(GlCounter::DrawCalls);
+        original.drawArrays(mode, first, count);
+    }
+
+    void APIENTRY countDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+        addCount(GlCounter::DrawCalls);
+        original.drawElements(mode, count, type, indices);
+    }
+
+    void APIENTRY countDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+        addCount(GlCounter::DrawCalls);
+        original.drawArraysInstanced(mode, first, count, instances);
+    }
+
+    void APIENTRY countDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+                                             GLsizei instances) {
+        addCount(GlCounter::DrawCalls);
+        original.drawElementsInstanced(mode, count, type, indices, instances);
+    }
+
+    void APIENTRY countDrawElementsInstancedBaseInstance(GLenum mode, GLsizei count, GLenum type, const void *indices,
+                                                         GLsizei instances, GLuint baseInstance) {
+        addCount(GlCounter::DrawCalls);
+        original.drawElementsInstancedBaseInstance(mode, count, type, indices, instances, baseInstance);
+    }
+
+    void APIENTRY countMultiDrawArraysIndirect(GLenum mode, const void *indirect, GLsizei drawCount, GLsizei stride) {
+        addCount(GlCounter::DrawCalls, static_cast<uint64_t>(drawCount));
+        original.multiDrawArraysIndirect(mode, indirect, drawCount, stride);
+    }
+
+    void APIENTRY countMultiDrawElementsIndirect(GLenum mode, GLenum type, const void *indirect, GLsizei drawCount,
+                                                 GLsizei stride) {
+        addCount(GlCounter::DrawCalls, static_cast<uint64_t>(drawCount));
+        original.multiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    }
+
+    // --- Binds ---
+    void APIENTRY countUseProgram(GLuint program) {
+        addCount(GlCounter::Binds);
+        original.useProgram(program);
+    }
+
+    void APIENTRY countBindVertexArray(GLuint array) {
+        addCount(GlCounter::Binds);
+        original.bindVertexArray(array);
+    }
+
+    void APIENTRY countBindBuffer(GLenum target, GLuint buffer) {
+        addCount(GlCounter::Binds);
+        original.bindBuffer(target, buffer);
+    }
+
+    void APIENTRY countBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        addCount(GlCounter::Binds);
+        original.bindBufferBase(target, index, buffer);
+    }
+
+    void APIENTRY countBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        addCount(GlCounter::Binds);
+        original.bindBufferRange(target, index, buffer, offset, size);
+    }
+
+    void APIENTRY countBindTexture(GLenum target, GLuint texture) {
+        addCount(GlCounter::Binds);
+        original.bindTexture(target, texture);
+    }
+
+    void APIENTRY countBindFramebuffer(GLenum target, GLuint framebuffer) {
+        addCount(GlCounter::Binds);
+        original.bindFramebuffer(target, framebuffer);
+    }
+
+    void APIENTRY countBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+        addCount(GlCounter::Binds);
+        original.bindRenderbuffer(target, renderbuffer);
+    }
+
+    // --- State ---
+    void APIENTRY countEnable(GLenum cap) {
+        addCount(GlCounter::StateChanges);
+        original.enable(cap);
+    }
+
+    void APIENTRY countDisable(GLenum cap) {
+        addCount(GlCounter::StateChanges);
+        original.disable(cap);
+    }
+
+    void APIENTRY countBlendFunc(GLenum source, GLenum destination) {
+        addCount(GlCounter::StateChanges);
+        original.blendFunc(source, destination);
+    }
+
+    void APIENTRY countStencilFunc(GLenum func, GLint ref, GLuint mask) {
+        addCount(GlCounter::StateChanges);
+        original.stencilFunc(func, ref, mask);
+    }
+
+    void APIENTRY countStencilOp(GLenum fail, GLenum depthFail, GLenum depthPass) {
+        addCount(GlCounter::StateChanges);
+        original.stencilOp(fail, depthFail, depthPass);
+    }
+
+    void APIENTRY countStencilMask(GLuint mask) {
+        addCount(GlCounter::StateChanges);
+        original.stencilMask(mask);
+    }
+
+    void APIENTRY countColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+        addCount(GlCounter::StateChanges);
+        original.colorMask(red, green, blue, alpha);
+    }
+
+    void APIENTRY countViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        addCount(GlCounter::StateChanges);
+        original.viewport(x, y, width, height);
+    }
+
+    void APIENTRY countActiveTexture(GLenum texture) {
+        addCount(GlCounter::StateChanges);
+        original.activeTexture(texture);
+    }
+
+    // --- Uniforms ---
+    void APIENTRY countUniform1i(GLint location, GLint v0) {
+        addCount(GlCounter::UniformUploads);
+        original.uniform1i(location, v0);
+    }
+
+    void APIENTRY countUniform1f(GLint location, GLfloat v0) {
+        addCount(GlCounter::UniformUploads);
+        original.uniform1f(location, v0);
+    }
+
+    void APIENTRY countUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+        addCount(GlCounter::UniformUploads);
+        original.uniform2f(location, v0, v1);
+    }
+
+    void APIENTRY countUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+        addCount(GlCounter::UniformUploads);
+        original.uniform3f(location, v0, v1, v2);
+    }
+
+    void APIENTRY countUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+        addCount(GlCounter::UniformUploads);
+        original.uniform4f(location, v0, v1, v2, v3);
+    }
+
+    void APIENTRY countUniform2fv(GLint location, GLsizei count, const GLfloat *value) {
+        addCount(GlCounter::UniformUploads);
+        original.uniform2fv(location, count, value);
+    }
+
+    void APIENTRY countUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+        addCount(GlCounter::UniformUploads);
+        original.uniformMatrix4fv(location, count, transpose, value);
+    }
+
+    // --- Uploads, allocations without data count as calls but move no bytes ---
+    void APIENTRY countBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+        countUpload(GlCounter::BufferUploads, data ? static_cast<uint64_t>(size) : 0);
+        original.bufferData(target, size, data, usage);
+    }
+
+    void APIENTRY countBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+        countUpload(GlCounter::BufferUploads, static_cast<uint64_t>(size));
+        original.bufferSubData(target, offset, size, data);
+    }
+
+    void APIENTRY countBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) {
+        countUpload(GlCounter::BufferUploads, data ? static_cast<uint64_t>(size) : 0);
+        original.bufferStorage(target, size, data, flags);
+    }
+
+    void APIENTRY countTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                                  GLint border, GLenum format, GLenum type, const void *pixels) {
+        const uint64_t bytes = pixels ? static_cast<uint64_t>(width) * height * getPixelSize(format, type) : 0;
+        countUpload(GlCounter::TextureUploads, bytes);
+        original.texImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+    }
+
+    void APIENTRY countTexSubImage2D(GLenum target, GLint level, GLint offsetX, GLint offsetY, GLsizei width,
+                                     GLsizei height, GLenum format, GLenum type, const void *pixels) {
+        countUpload(GlCounter::TextureUploads, static_cast<uint64_t>(width) * height * getPixelSize(format, type));
+        original.texSubImage2D(target, level, offsetX, offsetY, width, height, format, type, pixels);
+    }
+}
+
+void installGlStats() {
+    if (installed) {
+        return;
+    }
+    installed = true;
+
+    original.drawArrays = glad_glDrawArrays;
+    original.drawElements = glad_glDrawElements;
+    original.drawArraysInstanced = glad_glDrawArraysInstanced;
+    original.drawElementsInstanced = glad_glDrawElementsInstanced;
+    original.drawElementsInstancedBaseInstance = glad_glDrawElementsInstancedBaseInstance;
+    original.multiDrawArraysIndirect = glad_glMultiDrawArraysIndirect;
+    original.multiDrawElementsIndirect = glad_glMultiDrawElementsIndirect;
+    glad_glDrawArrays = countDrawArrays;
+    glad_glDrawElements = countDrawElements;
+    glad_glDrawArraysInstanced = countDrawArraysInstanced;
+    glad_glDrawElementsInstanced = countDrawElementsInstanced;
+    glad_glDrawElementsInstancedBaseInstance = countDrawElementsInstancedBaseInstance;
+    glad_glMultiDrawArraysIndirect = countMultiDrawArraysIndirect;
+    glad_glMultiDrawElementsIndirect = countMultiDrawElementsIndirect;
+
+    original.useProgram = glad_glUseProgram;
+    original.bindVertexArray = glad_glBindVertexArray;
+    original.bindBuffer = glad_glBindBuffer;
+    original.bindBufferBase = glad_glBindBufferBase;
+    original.bindBufferRange = glad_glBindBufferRange;
+    original.bindTexture = glad_glBindTexture;
+    original.bindFramebuffer = glad_glBindFramebuffer;
+    original.bindRenderbuffer = glad_glBindRenderbuffer;
+    glad_glUseProgram = countUseProgram;
+    glad_glBindVertexArray = countBindVertexArray;
+    glad_glBindBuffer = countBindBuffer;
+    glad_glBindBufferBase = countBindBufferBase;
+    glad_glBindBufferRange = countBindBufferRange;
+    glad_glBindTexture = countBindTexture;
+    glad_glBindFramebuffer = countBindFramebuffer;
+    glad_glBindRenderbuffer = countBindRenderbuffer;
+
+    original.enable = glad_glEnable;
+    original.disable = glad_glDisable;
+    original.blendFunc = glad_glBlendFunc;
+    original.stencilFunc = glad_glStencilFunc;
+    original.stencilOp = glad_glStencilOp;
+    original.stencilMask = glad_glStencilMask;
+    original.colorMask = glad_glColorMask;
+    original.viewport = glad_glViewport;
+    original.activeTexture = glad_glActiveTexture;
+    glad_glEnable = countEnable;
+    glad_glDisable = countDisable;
+    glad_glBlendFunc = countBlendFunc;
+    glad_glStencilFunc = countStencilFunc;
+    glad_glStencilOp = countStencilOp;
+    glad_glStencilMask = countStencilMask;
+    glad_glColorMask = countColorMask;
+    glad_glViewport = countViewport;
+    glad_glActiveTexture = countActiveTexture;
+
+    original.uniform1i = glad_glUniform1i;
+    original.uniform1f = glad_glUniform1f;
+    original.uniform2f = glad_glUniform2f;
+    original.uniform3f = glad_glUniform3f;
+    original.uniform4f = glad_glUniform4f;
+    original.uniform2fv = glad_glUniform2fv;
+    original.uniformMatrix4fv = glad_glUniformMatrix4fv;
+    glad_glUniform1i = countUniform1i;
+    glad_glUniform1f = countUniform1f;
+    glad_glUniform2f = countUniform2f;
+    glad_glUniform3f = countUniform3f;
+    glad_glUniform4f = countUniform4f;
+    glad_glUniform2fv = countUniform2fv;
+    glad_glUniformMatrix4fv = countUniformMatrix4fv;
+
+    original.bufferData = glad_glBufferData;
+    original.bufferSubData = glad_glBufferSubData;
+    original.bufferStorage = glad_glBufferStorage;
+    original.texImage2D = glad_glTexImage2D;
+    original.texSubImage2D = glad_glTexSubImage2D;
+    glad_glBufferData = countBufferData;
+    glad_glBufferSubData = countBufferSubData;
+    glad_glBufferStorage = countBufferStorage;
+    glad_glTexImage2D = countTexImage2D;
+    glad_glTexSubImage2D = countTexSubImage2D;
+}
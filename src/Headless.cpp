@@ -0,0 +1,169 @@
+#include "../Header/Headless.h"
+
+#include <glad/glad.h>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef KOSTUR_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace {
+    EGLDisplay openDisplay() {
+        // Surfaceless platform needs neither a display server nor a GPU
+        const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+                return display;
+            }
+        }
+
+        EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+            return display;
+        }
+        return EGL_NO_DISPLAY;
+    }
+
+    EGLContext createCoreContext(EGLDisplay display, EGLConfig config) {
+        // 4.6 where available, llvmpipe currently stops at 4.5
+        for (const EGLint minor: {6, 5}) {
+            const EGLint attributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, 4,
+                EGL_CONTEXT_MINOR_VERSION, minor,
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE
+            };
+            EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, attributes);
+            if (context != EGL_NO_CONTEXT) {
+                return context;
+            }
+        }
+        return EGL_NO_CONTEXT;
+    }
+}
+
+bool createHeadlessContext(HeadlessContext &headless, const int width, const int height) {
+    headless.width = width;
+    headless.height = height;
+
+    EGLDisplay display = openDisplay();
+    if (display == EGL_NO_DISPLAY || !eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "EGL ekran nije dostupan." << std::endl;
+        return false;
+    }
+
+    constexpr EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+    EGLContext context = createCoreContext(display, configCount > 0 ? config : nullptr);
+    if (context == EGL_NO_CONTEXT) {
+        std::cout << "EGL kontekst nije uspeo da se kreira." << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+
+    // Fall back to a tiny pbuffer when the context cannot be made current without a surface
+    EGLSurface surface = EGL_NO_SURFACE;
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) && configCount > 0) {
+        constexpr EGLint pbufferAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+        if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+            std::cout << "EGL kontekst nije uspeo da se aktivira." << std::endl;
+            eglDestroyContext(display, context);
+            eglTerminate(display);
+            return false;
+        }
+    }
+
+    headless.display = display;
+    headless.context = context;
+    headless.surface = surface;
+    return true;
+}
+
+void *getHeadlessProcAddress(const char *name) {
+    return reinterpret_cast<void *>(eglGetProcAddress(name));
+}
+
+void destroyHeadlessContext(HeadlessContext &headless) {
+    if (!headless.display) {
+        return;
+    }
+
+    glDeleteFramebuffers(1, &headless.framebuffer);
+    glDeleteRenderbuffers(1, &headless.colorRenderbuffer);
+    glDeleteRenderbuffers(1, &headless.stencilRenderbuffer);
+
+    eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (headless.surface) {
+        eglDestroySurface(headless.display, headless.surface);
+    }
+    eglDestroyContext(headless.display, headless.context);
+    eglTerminate(headless.display);
+    headless = HeadlessContext{};
+}
+#else
+bool createHeadlessContext(HeadlessContext &, int, int) {
+    std::cout << "Headless rezim nije podrzan na ovoj platformi (potreban je EGL)." << std::endl;
+    return false;
+}
+
+void *getHeadlessProcAddress(const char *) {
+    return nullptr;
+}
+
+void destroyHeadlessContext(HeadlessContext &) {
+}
+#endif
+
+void createHeadlessFramebuffer(HeadlessContext &headless) {
+    glGenRenderbuffers(1, &headless.colorRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless.colorRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, headless.width, headless.height);
+    glGenRenderbuffers(1, &headless.stencilRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless.stencilRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, headless.width, headless.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &headless.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, headless.framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless.colorRenderbuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                              headless.stencilRenderbuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Headless framebuffer nije kompletan." << std::endl;
+    }
+}
+
+bool saveHeadlessFrame(const HeadlessContext &headless, const char *filePath) {
+    std::vector<unsigned char> pixels(static_cast<size_t>(headless.width) * headless.height * 3);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, headless.framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, headless.width, headless.height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "Greska pri pisanju fajla sa putanje \"" << filePath << "\"!" << std::endl;
+        return false;
+    }
+
+    // PPM rows go top to bottom, GL rows bottom to top
+    file << "P6\n" << headless.width << " " << headless.height << "\n255\n";
+    const size_t rowSize = static_cast<size_t>(headless.width) * 3;
+    for (int row = headless.height - 1; row >= 0; --row) {
+        file.write(reinterpret_cast<const char *>(pixels.data() + row * rowSize), static_cast<std::streamsize>(rowSize));
+    }
+    return true;
+}
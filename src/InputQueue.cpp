@@ -0,0 +1,140 @@
+#include "../Header/InputQueue.h"
+
+// ============================================================================
+// QUEUE
+// ============================================================================
+bool InputQueue::publish(const InputEvent &event, const size_t limit) {
+    const size_t currentTail = tail.load(std::memory_order_relaxed);
+    const size_t queued = (currentTail + CAPACITY - head.load(std::memory_order_acquire)) % CAPACITY;
+    if (queued >= limit) {
+        return false;
+    }
+
+    events[currentTail] = event;
+    tail.store((currentTail + 1) % CAPACITY, std::memory_order_release);
+    return true;
+}
+
+bool InputQueue::push(const InputEvent &event) {
+    if (event.type == InputEventType::CursorPos) {
+        pendingMove = event;
+        hasPendingMove = true;
+        flush();
+        return true;
+    }
+
+    // The held move goes first to keep the order. Without room for both it is
+    // skipped, the event carries the cursor position anyway.
+    if (hasPendingMove) {
+        publish(pendingMove, CAPACITY - 2);
+        hasPendingMove = false;
+    }
+
+    // Queue full even with the reserved slots, drop the event rather than block the producer
+    if (!publish(event, CAPACITY - 1)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void InputQueue::flush() {
+    if (hasPendingMove && publish(pendingMove, CAPACITY - 1 - RESERVED)) {
+        hasPendingMove = false;
+    }
+}
+
+bool InputQueue::pop(InputEvent &event) {
+    const size_t currentHead = head.load(std::memory_order_relaxed);
+    if (currentHead == tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    event = events[currentHead];
+    head.store((currentHead + 1) % CAPACITY, std::memory_order_release);
+    return true;
+}
+
+size_t InputQueue::takeDroppedCount() {
+    return dropped.exchange(0, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// STATE
+// ============================================================================
+void applyInputEvent(InputState &state, const InputEvent &event) {
+    state.cursorX = event.x;
+    state.cursorY = event.y;
+
+    switch (event.type) {
+        case InputEventType::Key:
+            // A press with Ctrl held is a shortcut such as Ctrl+S, not a held key
+            if (event.code >= 0 && event.code <= GLFW_KEY_LAST) {
+                if (event.action == GLFW_RELEASE) {
+                    state.keys[event.code] = false;
+                } else if ((event.mods & GLFW_MOD_CONTROL) == 0) {
+                    state.keys[event.code] = true;
+                }
+            }
+            break;
+        case InputEventType::MouseButton:
+            if (event.code >= 0 && event.code <= GLFW_MOUSE_BUTTON_LAST) {
+                state.buttons[event.code] = event.action != GLFW_RELEASE;
+            }
+            break;
+        case InputEventType::CursorPos:
+            break;
+    }
+}
+
+bool isPressEvent(const InputEvent &event, const InputEventType type, const int code) {
+    return event.type == type && event.code == code && event.action == GLFW_PRESS;
+}
+
+bool isShortcutEvent(const InputEvent &event, const int key, const int mods) {
+    return isPressEvent(event, InputEventType::Key, key) && (event.mods & mods) == mods;
+}
+
+// ============================================================================
+// GLFW CALLBACKS
+// ============================================================================
+static void pushEvent(GLFWwindow *window, const InputEventType type, const int code, const int action,
+                      const int mods, const double x, const double y) {
+    auto *queue = static_cast<InputQueue *>(glfwGetWindowUserPointer(window));
+    if (!queue) {
+        return;
+    }
+
+    InputEvent event{};
+    event.type = type;
+    event.code = code;
+    event.action = action;
+    event.mods = mods;
+    event.x = x;
+    event.y = y;
+    event.time = glfwGetTime();
+    queue->push(event);
+}
+
+static void inputKeyCallback(GLFWwindow *window, const int key, int, const int action, const int mods) {
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    pushEvent(window, InputEventType::Key, key, action, mods, x, y);
+}
+
+static void inputMouseButtonCallback(GLFWwindow *window, const int button, const int action, const int mods) {
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    pushEvent(window, InputEventType::MouseButton, button, action, mods, x, y);
+}
+
+static void inputCursorPosCallback(GLFWwindow *window, const double x, const double y) {
+    pushEvent(window, InputEventType::CursorPos, 0, 0, 0, x, y);
+}
+
+void installInputCallbacks(GLFWwindow *window, InputQueue &queue) {
+    glfwSetWindowUserPointer(window, &queue);
+    glfwSetKeyCallback(window, inputKeyCallback);
+    glfwSetMouseButtonCallback(window, inputMouseButtonCallback);
+    glfwSetCursorPosCallback(window, inputCursorPosCallback);
+}
@@ -0,0 +1,78 @@
+#include "../Header/LateLatch.h"
+#include "../Header/GlStats.h"
+
+#include <cstring>
+
+namespace {
+    // std140 layout of the LateLatch uniform block
+    struct LateLatchBlock {
+        float cursor[4];
+    };
+
+    void writeCursor(const LateLatch &latch, const double cursorX, const double cursorY,
+                     const int screenWidth, const int screenHeight) {
+        LateLatchBlock block{};
+        block.cursor[0] = static_cast<float>(cursorX) / screenWidth * 2.0f - 1.0f;
+        block.cursor[1] = 1.0f - static_cast<float>(cursorY) / screenHeight * 2.0f;
+
+        // The mapping is coherent, so the store is visible to commands the GPU has not executed yet
+        std::memcpy(latch.mapped + latch.slot * latch.slotStride, &block, sizeof(block));
+        recordGlMappedUpload(sizeof(block));
+    }
+}
+
+void createLateLatch(LateLatch &latch) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    latch.slotStride = (static_cast<GLsizeiptr>(sizeof(LateLatchBlock)) + alignment - 1) / alignment * alignment;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr size = latch.slotStride * LateLatch::SLOT_COUNT;
+
+    glGenBuffers(1, &latch.buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, latch.buffer);
+    glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+    latch.mapped = static_cast<unsigned char *>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    std::memset(latch.mapped, 0, static_cast<size_t>(size));
+}
+
+void destroyLateLatch(LateLatch &latch) {
+    for (GLsync &fence: latch.fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, latch.buffer);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glDeleteBuffers(1, &latch.buffer);
+    latch.mapped = nullptr;
+}
+
+void beginLateLatchFrame(LateLatch &latch, const double cursorX, const double cursorY,
+                         const int screenWidth, const int screenHeight) {
+    GlSubsystemScope glScope(GlSubsystem::LateLatch);
+    latch.slot = (latch.slot + 1) % LateLatch::SLOT_COUNT;
+
+    // With three slots in flight this is normally already signaled
+    if (GLsync &fence = latch.fences[latch.slot]) {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    writeCursor(latch, cursorX, cursorY, screenWidth, screenHeight);
+    glBindBufferRange(GL_UNIFORM_BUFFER, LateLatch::BINDING, latch.buffer,
+                      latch.slot * latch.slotStride, sizeof(LateLatchBlock));
+}
+
+void latchCursor(LateLatch &latch, const double cursorX, const double cursorY,
+                 const int screenWidth, const int screenHeight) {
+    GlSubsystemScope glScope(GlSubsystem::LateLatch);
+    writeCursor(latch, cursorX, cursorY, screenWidth, screenHeight);
+    latch.fences[latch.slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,167 @@
+#include "../Header/LzCompression.h"
+
+#include <cstring>
+
+namespace {
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr size_t LAST_LITERALS = 5; // Matches stop short of the end, so prefixes are read in bounds
+    constexpr int HASH_BITS = 12;
+
+    static_assert(LZ_MAX_INPUT <= 65536, "positions are kept in 16 bits");
+
+    uint32_t readPrefix(const uint8_t *p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t hashPrefix(const uint32_t prefix) {
+        return (prefix * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // Lengths that do not fit the token nibble continue in bytes of up to 255
+    uint8_t *writeLength(uint8_t *out, size_t length) {
+        length -= 15;
+        while (length >= 255) {
+            *out++ = 255;
+            length -= 255;
+        }
+        *out++ = static_cast<uint8_t>(length);
+        return out;
+    }
+
+    bool readLength(const uint8_t *&in, const uint8_t *end, const size_t limit, size_t &length) {
+        uint8_t byte;
+        do {
+            if (in == end || length > limit) {
+                return false;
+            }
+            byte = *in++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    uint8_t *writeLiterals(uint8_t *out, const uint8_t *literals, const size_t literalLength) {
+        if (literalLength >= 15) {
+            out = writeLength(out, literalLength);
+        }
+        std::memcpy(out, literals, literalLength);
+        return out + literalLength;
+    }
+
+    uint8_t *writeSequence(uint8_t *out, const uint8_t *literals, const size_t literalLength, const size_t offset,
+                           const size_t matchLength) {
+        const size_t matchCode = matchLength - MIN_MATCH;
+        *out++ = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4 | (matchCode < 15 ? matchCode : 15));
+        out = writeLiterals(out, literals, literalLength);
+        *out++ = static_cast<uint8_t>(offset);
+        *out++ = static_cast<uint8_t>(offset >> 8);
+        if (matchCode >= 15) {
+            out = writeLength(out, matchCode);
+        }
+        return out;
+    }
+}
+
+size_t compressLz(const uint8_t *input, const size_t size, uint8_t *output) {
+    uint8_t *out = output;
+    size_t anchor = 0; // Start of the literals not yet written
+
+    if (size >= MIN_MATCH + LAST_LITERALS) {
+        uint16_t table[1 << HASH_BITS] = {};
+        const size_t limit = size - LAST_LITERALS;
+        size_t position = 0;
+
+        while (position + MIN_MATCH <= limit) {
+            const uint32_t prefix = readPrefix(input + position);
+            const uint32_t hash = hashPrefix(prefix);
+            const size_t candidate = table[hash];
+            table[hash] = static_cast<uint16_t>(position);
+
+            if (candidate >= position || position - candidate > MAX_OFFSET || readPrefix(input + candidate) != prefix) {
+                // Skip faster through data that keeps missing
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            size_t start = position;
+            size_t from = candidate;
+            size_t length = MIN_MATCH;
+            while (position + length < limit && input[from + length] == input[position + length]) {
+                ++length;
+            }
+            while (start > anchor && from > 0 && input[start - 1] == input[from - 1]) {
+                --start;
+                --from;
+                ++length;
+            }
+
+            out = writeSequence(out, input + anchor, start - anchor, start - from, length);
+            position = start + length;
+            anchor = position;
+            if (position + MIN_MATCH <= limit) {
+                table[hashPrefix(readPrefix(input + position - 2))] = static_cast<uint16_t>(position - 2);
+            }
+        }
+    }
+
+    // The last sequence is literals only, possibly none
+    const size_t literalLength = size - anchor;
+    *out++ = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4);
+    out = writeLiterals(out, input + anchor, literalLength);
+    return static_cast<size_t>(out - output);
+}
+
+bool decompressLz(const uint8_t *input, const size_t size, uint8_t *output, const size_t outputSize) {
+    const uint8_t *in = input;
+    const uint8_t *end = input + size;
+    uint8_t *out = output;
+    const uint8_t *outEnd = output + outputSize;
+
+    while (in < end) {
+        const uint8_t token = *in++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(in, end, outputSize, literalLength)) {
+            return false;
+        }
+        if (literalLength > static_cast<size_t>(end - in) || literalLength > static_cast<size_t>(outEnd - out)) {
+            return false;
+        }
+        std::memcpy(out, in, literalLength);
+        in += literalLength;
+        out += literalLength;
+        if (in == end) {
+            break;
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        const size_t offset = static_cast<size_t>(in[0]) | static_cast<size_t>(in[1]) << 8;
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(in, end, outputSize, matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(out - output) ||
+            matchLength > static_cast<size_t>(outEnd - out)) {
+            return false;
+        }
+
+        // Overlapping matches repeat the last offset bytes, they are copied forwards one at a time
+        const uint8_t *match = out - offset;
+        if (offset >= matchLength) {
+            std::memcpy(out, match, matchLength);
+        } else {
+            for (size_t i = 0; i < matchLength; ++i) {
+                out[i] = match[i];
+            }
+        }
+        out += matchLength;
+    }
+    return out == outEnd;
+}
@@ -1,11 +1,37 @@
 ﻿#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string>
 #include <thread>
 #include <vector>
 #include <algorithm>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "../Header/AllocationCounter.h"
+#include "../Header/Benchmark.h"
+#include "../Header/ContractionHierarchy.h"
+#include "../Header/Display.h"
+#include "../Header/FrameArena.h"
+#include "../Header/Geodesic.h"
+#include "../Header/Georeference.h"
+#include "../Header/GlStats.h"
+#include "../Header/InputQueue.h"
+#include "../Header/LateLatch.h"
+#include "../Header/Options.h"
+#include "../Header/Profiler.h"
+#include "../Header/RoadRouter.h"
+#include "../Header/RouteBuffer.h"
+#include "../Header/RouteFile.h"
+#include "../Header/RouteHistory.h"
+#include "../Header/RouteStore.h"
+#include "../Header/SceneTarget.h"
+#include "../Header/SegmentGrid.h"
+#include "../Header/SpatialGrid.h"
+#include "../Header/TrackImport.h"
+#include "../Header/Trace.h"
 #include "../Header/Util.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -23,14 +49,6 @@ struct TextureData {
     int height;
 };
 
-struct Point {
-    float x, y;
-
-    bool operator==(const Point &other) const {
-        return std::abs(x - other.x) < 0.001f && std::abs(y - other.y) < 0.001f;
-    }
-};
-
 struct DigitTextures {
     TextureData digits[10];
     TextureData dot;
@@ -39,18 +57,81 @@ struct DigitTextures {
 struct WalkingState {
     float mapPosX;
     float mapPosY;
-    float totalDistance;
+    DistanceSum totalDistance;
+};
+
+// A named route with its own indexes, history and vertex buffer
+struct MeasuringLayer {
+    std::string name;
+    float color[3] = {1.0f, 1.0f, 1.0f};
+    bool visible = true; // H hides the active layer, hidden layers are not drawn, clicked or undone
+
+    RouteStore route; // In metres, point ids are handles into grid, recycled after removal
+    double totalMeasuredDistance = 0.0; // Metres
+
+    SpatialGrid grid; // Point ids by position, covers the map in measuring-mode NDC
+    SegmentGrid segments; // Segments keyed by the id of their start point, same space as grid
+    std::vector<uint32_t> freeIds;
+    uint32_t nextId = 0;
+
+    RouteHistory history; // Clicks, undone with Ctrl+Z and redone with Ctrl+Y
+
+    RouteBuffer buffer; // Refreshed only while the layer is visible and on screen
+
+    // Of the route in metres, grown by every added point. Removing a point on the edge
+    // marks it stale and the next cull test rescans the route.
+    PointBounds bounds = emptyBounds();
+    bool boundsStale = false;
+    bool onScreen = false; // Result of this frame's cull test
+};
+
+// Routed path from the end of the active route to the cursor, the points a click would append
+struct RoutePreview {
+    RouteStore route; // In metres, starting at the route's end
+    RouteBuffer buffer;
+    bool found = false;
+
+    // What the path was found for, it is searched again only when one of them changes
+    const MeasuringLayer *layer = nullptr;
+    float endX = 0.0f, endY = 0.0f;
+    int32_t target = -1;
 };
 
 struct MeasuringState {
-    std::vector<Point> points;
-    float totalMeasuredDistance = 0.0f;
+    // Reserved up front so that adding a point does not reallocate mid-frame
+    static constexpr size_t RESERVED_POINTS = 16384;
+
+    // Clicks closer than this to an existing point remove it
+    static constexpr float HIT_RADIUS = 0.03f;
+
+    // Clicks closer than this to a segment, and not on a point, insert a point into it
+    static constexpr float SEGMENT_HIT_RADIUS = 0.015f;
+
+    // Edits that can be undone, older ones are forgotten
+    static constexpr size_t HISTORY_EDITS = 4096;
+
+    // Reserved up front so that adding a layer never moves the others
+    static constexpr size_t MAX_LAYERS = 32;
+
+    // Map image pixels, routed clicks farther than this from any street are appended straight
+    static constexpr float ROAD_SNAP_RADIUS = 40.0f;
+
+    // A routed path visits each street node at most once, the shipped map has fewer than this
+    static constexpr size_t RESERVED_PREVIEW_POINTS = 16384;
+
+    std::vector<MeasuringLayer> layers; // Never empty
+    size_t activeLayer = 0; // Clicks, undo and route files act on this one
+
+    bool areaMode = false; // P closes the active route into a filled polygon and the HUD shows its area
+    bool roadRouting = false; // G makes appended points follow the streets from the end of the route
+    RoutePreview preview;     // Follows the cursor while road routing is on
 };
 
 // ============================================================================
 // TEXTURE LOADING
 // ============================================================================
 TextureData loadTexture(const char *filePath) {
+    TRACE_SCOPE_DETAIL("loadTexture", "load", filePath);
     TextureData data{};
     data.textureID = loadImageToTexture(filePath);
 
@@ -138,72 +219,248 @@ void renderPin(const unsigned int shaderProgram, const unsigned int VAO, const u
     renderImage(shaderProgram, VAO, textureID, 0.0f, 0.0f, pinScale, pinScale);
 }
 
-void renderNumber(const unsigned int shaderProgram, const unsigned int VAO,
-                  const DigitTextures &dt, const float number, const float x, const float y, const float scale) {
-    const std::string s = std::to_string(number);
+// ============================================================================
+// TRANSIENT DRAW LISTS
+// ============================================================================
+// Quads collected in the frame arena and submitted together, so the program,
+// vertex array and color state are set once per list instead of once per quad
+struct QuadDraw {
+    glm::mat4 model;
+    unsigned int textureID; // 0 draws a solid color
+    float r, g, b;
+};
+
+using QuadList = ArenaVector<QuadDraw>;
+
+void appendImageQuad(QuadList &quads, const unsigned int textureID,
+                     const float x, const float y, const float scaleX, const float scaleY) {
+    auto model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(x, y, 0.0f));
+    model = glm::scale(model, glm::vec3(scaleX, scaleY, 1.0f));
+    quads.push_back({model, textureID, 1.0f, 1.0f, 1.0f});
+}
+
+void appendDigits(QuadList &quads, const DigitTextures &dt, const char *text,
+                  const float x, const float y, const float scale) {
     float offsetX = 0.0f;
 
-    for (const char c: s) {
-        if (c >= '0' && c <= '9') {
-            const int digit = c - '0';
-            renderImage(shaderProgram, VAO, dt.digits[digit].textureID, x + offsetX, y, scale, scale);
+    for (const char *c = text; *c; ++c) {
+        if (*c >= '0' && *c <= '9') {
+            const int digit = *c - '0';
+            appendImageQuad(quads, dt.digits[digit].textureID, x + offsetX, y, scale, scale);
             offsetX += scale * 0.6f;
-        } else if (c == '.') {
-            renderImage(shaderProgram, VAO, dt.dot.textureID, x + offsetX, y, scale, scale);
+        } else if (*c == '.') {
+            appendImageQuad(quads, dt.dot.textureID, x + offsetX, y, scale, scale);
             offsetX += scale * 0.6f;
         }
     }
 }
 
-void renderLine(const unsigned int shaderProgram, const unsigned int VAO,
-                float x1, float y1, float x2, float y2, float thickness = 0.005f) {
+void submitQuads(const unsigned int shaderProgram, const unsigned int VAO, const QuadList &quads) {
+    if (quads.empty()) {
+        return;
+    }
+
     glUseProgram(shaderProgram);
+    const int modelLoc = glGetUniformLocation(shaderProgram, "model");
+    const int colorLoc = glGetUniformLocation(shaderProgram, "customColor");
+    const int useColorLoc = glGetUniformLocation(shaderProgram, "useCustomColor");
+
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0);
+    glBindVertexArray(VAO);
 
-    float dx = x2 - x1;
-    float dy = y2 - y1;
-    float length = std::sqrt(dx * dx + dy * dy);
-    float angle = std::atan2(dy, dx);
+    // Only uniforms and bindings that change between consecutive quads are sent
+    unsigned int boundTexture = 0;
+    int useColor = -1;
+    float color[3] = {-1.0f, -1.0f, -1.0f};
 
-    float midX = (x1 + x2) / 2.0f;
-    float midY = (y1 + y2) / 2.0f;
+    for (const QuadDraw &quad: quads) {
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &quad.model[0][0]);
+
+        const int wantsColor = quad.textureID == 0 ? 1 : 0;
+        if (wantsColor != useColor) {
+            glUniform1i(useColorLoc, wantsColor);
+            useColor = wantsColor;
+        }
+
+        if (wantsColor) {
+            if (quad.r != color[0] || quad.g != color[1] || quad.b != color[2]) {
+                glUniform3f(colorLoc, quad.r, quad.g, quad.b);
+                color[0] = quad.r;
+                color[1] = quad.g;
+                color[2] = quad.b;
+            }
+        } else if (quad.textureID != boundTexture) {
+            glBindTexture(GL_TEXTURE_2D, quad.textureID);
+            boundTexture = quad.textureID;
+        }
+
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+    }
+
+    glBindVertexArray(0);
+    if (useColor != 0) {
+        glUniform1i(useColorLoc, 0);
+    }
+}
+
+void renderNumber(const unsigned int shaderProgram, const unsigned int VAO, FrameArena &arena,
+                  const DigitTextures &dt, const double number, const float x, const float y, const float scale) {
+    // Same formatting as std::to_string, written into the frame arena
+    constexpr size_t textSize = 64;
+    auto *text = static_cast<char *>(allocateFromArena(arena, textSize, 1));
+    const int length = std::snprintf(text, textSize, "%f", number);
+
+    QuadList quads{ArenaAllocator<QuadDraw>(arena)};
+    quads.reserve(static_cast<size_t>(std::clamp(length, 0, static_cast<int>(textSize))));
+    appendDigits(quads, dt, text, x, y, scale);
+    submitQuads(shaderProgram, VAO, quads);
+}
+
+void renderCount(const unsigned int shaderProgram, const unsigned int VAO, FrameArena &arena,
+                 const DigitTextures &dt, const uint64_t count, const float x, const float y, const float scale) {
+    constexpr size_t textSize = 24;
+    auto *text = static_cast<char *>(allocateFromArena(arena, textSize, 1));
+    const int length = std::snprintf(text, textSize, "%llu", static_cast<unsigned long long>(count));
+
+    QuadList quads{ArenaAllocator<QuadDraw>(arena)};
+    quads.reserve(static_cast<size_t>(std::clamp(length, 0, static_cast<int>(textSize))));
+    appendDigits(quads, dt, text, x, y, scale);
+    submitQuads(shaderProgram, VAO, quads);
+}
+
+void renderRect(const unsigned int shaderProgram, const unsigned int VAO,
+                float x, float y, float width, float height, float r, float g, float b) {
+    glUseProgram(shaderProgram);
 
     auto model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(midX, midY, 0.0f));
-    model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::scale(model, glm::vec3(length, thickness, 1.0f));
+    model = glm::translate(model, glm::vec3(x + width / 2.0f, y, 0.0f));
+    model = glm::scale(model, glm::vec3(width, height, 1.0f));
 
-    const int modelLoc = glGetUniformLocation(shaderProgram, "model");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &model[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &model[0][0]);
+    glUniform3f(glGetUniformLocation(shaderProgram, "customColor"), r, g, b);
+    glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 1);
+
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+    glBindVertexArray(0);
+
+    glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 0);
+}
+
+void renderLatchedCursorPoint(const unsigned int shaderProgram, const unsigned int VAO, float size = 0.02f) {
+    glUseProgram(shaderProgram);
+
+    const auto model = glm::scale(glm::mat4(1.0f), glm::vec3(size, size, 1.0f));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &model[0][0]);
 
     glUniform3f(glGetUniformLocation(shaderProgram, "customColor"), 1.0f, 1.0f, 1.0f);
     glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 1);
+    glUniform1i(glGetUniformLocation(shaderProgram, "latchMode"), 1);
 
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
     glBindVertexArray(0);
 
+    glUniform1i(glGetUniformLocation(shaderProgram, "latchMode"), 0);
     glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 0);
 }
 
-void renderPoint(const unsigned int shaderProgram, const unsigned int VAO,
-                 float x, float y, float size = 0.02f) {
+void renderLatchedCursorLine(const unsigned int shaderProgram, const unsigned int VAO,
+                             float anchorX, float anchorY, float thickness = 0.005f) {
     glUseProgram(shaderProgram);
 
+    glUniform2f(glGetUniformLocation(shaderProgram, "anchor"), anchorX, anchorY);
+    glUniform1f(glGetUniformLocation(shaderProgram, "thickness"), thickness);
+    glUniform3f(glGetUniformLocation(shaderProgram, "customColor"), 1.0f, 1.0f, 1.0f);
+    glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 1);
+    glUniform1i(glGetUniformLocation(shaderProgram, "latchMode"), 2);
+
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+    glBindVertexArray(0);
+
+    glUniform1i(glGetUniformLocation(shaderProgram, "latchMode"), 0);
+    glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 0);
+}
+
+glm::mat4 affineToMatrix(const AffineTransform &transform) {
+    // Column major, the affine's translation goes in the last column
     auto model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(x, y, 0.0f));
-    model = glm::scale(model, glm::vec3(size, size, 1.0f));
+    model[0][0] = static_cast<float>(transform.a);
+    model[0][1] = static_cast<float>(transform.d);
+    model[1][0] = static_cast<float>(transform.b);
+    model[1][1] = static_cast<float>(transform.e);
+    model[3][0] = static_cast<float>(transform.c);
+    model[3][1] = static_cast<float>(transform.f);
+    return model;
+}
 
-    const int modelLoc = glGetUniformLocation(shaderProgram, "model");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &model[0][0]);
+// Segments and markers are instanced from the route buffer, model takes its vertices to NDC
+void renderRoute(const unsigned int shaderProgram, const RouteBuffer &routeBuffer, const AffineTransform &routeToNdc,
+                 const float color[3], float markerSize = 0.02f, float thickness = 0.005f) {
+    glUseProgram(shaderProgram);
 
-    glUniform3f(glGetUniformLocation(shaderProgram, "customColor"), 1.0f, 1.0f, 1.0f);
+    const glm::mat4 model = affineToMatrix(routeToNdc);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &model[0][0]);
+    glUniform3f(glGetUniformLocation(shaderProgram, "customColor"), color[0], color[1], color[2]);
+    glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 1);
+
+    const int thicknessLoc = glGetUniformLocation(shaderProgram, "thickness");
+    const int latchModeLoc = glGetUniformLocation(shaderProgram, "latchMode");
+    glUniform1f(thicknessLoc, thickness);
+    glUniform1i(latchModeLoc, 3);
+    drawRouteSegments(routeBuffer);
+
+    glUniform1f(thicknessLoc, markerSize);
+    glUniform1i(latchModeLoc, 4);
+    drawRouteMarkers(routeBuffer);
+    glBindVertexArray(0);
+
+    glUniform1i(latchModeLoc, 0);
+    glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 0);
+}
+
+// Stencil then cover: the fan inverts the stencil under each of its triangles, which leaves
+// the pixels inside the closed route odd whatever its shape, then one screen quad colors
+// those and clears the stencil behind it
+void renderRouteFill(const unsigned int shaderProgram, const unsigned int VAO, const RouteBuffer &routeBuffer,
+                     const AffineTransform &routeToNdc) {
+    if (routeBuffer.lineCount < 3) {
+        return;
+    }
+
+    glUseProgram(shaderProgram);
+    const int modelLoc = glGetUniformLocation(shaderProgram, "model");
+    const glm::mat4 routeModel = affineToMatrix(routeToNdc);
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &routeModel[0][0]);
+
+    glEnable(GL_STENCIL_TEST);
+    glStencilMask(0x01);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glStencilFunc(GL_ALWAYS, 0, 0x01);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+    drawRouteFan(routeBuffer);
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glStencilFunc(GL_NOTEQUAL, 0, 0x01);
+    glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
+
+    const auto cover = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 2.0f, 1.0f));
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &cover[0][0]);
+    glUniform3f(glGetUniformLocation(shaderProgram, "customColor"), 0.2f, 0.6f, 1.0f);
+    glUniform1f(glGetUniformLocation(shaderProgram, "customAlpha"), 0.35f);
     glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 1);
 
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
     glBindVertexArray(0);
 
+    glUniform1f(glGetUniformLocation(shaderProgram, "customAlpha"), 1.0f);
     glUniform1i(glGetUniformLocation(shaderProgram, "useCustomColor"), 0);
+    glDisable(GL_STENCIL_TEST);
+    glStencilMask(0xff);
 }
 
 // ============================================================================
@@ -224,101 +481,519 @@ bool isMouseOverIndicator(const double mouseX, const double mouseY, const int sc
            ndcY >= (posY - quadHeightNDC) && ndcY <= (posY + quadHeightNDC);
 }
 
-void keyCallback(GLFWwindow *window, const int key, int scancode, const int action, int mods) {
-    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, GLFW_TRUE);
-    }
+bool isMeasuringClickEvent(const InputEvent &event) {
+    return isPressEvent(event, InputEventType::MouseButton, GLFW_MOUSE_BUTTON_LEFT);
 }
 
 // ============================================================================
 // MEASURING MODE HELPER FUNCTIONS
 // ============================================================================
-void handleMeasuringModeClick(MeasuringState &measuringState, double mouseX, double mouseY,
-                              int screenWidth, int screenHeight, float mapScale, float fullscreenScale) {
+uint32_t acquirePointId(MeasuringLayer &layer) {
+    if (layer.freeIds.empty()) {
+        return layer.nextId++;
+    }
+
+    const uint32_t id = layer.freeIds.back();
+    layer.freeIds.pop_back();
+    return id;
+}
+
+// Indexes the segment from vertex index to the next one, replacing the one its start had
+void linkMeasuringSegment(MeasuringLayer &layer, const size_t index) {
+    if (index + 1 >= layer.route.size) {
+        return;
+    }
+
+    const uint32_t start = getRoutePoint(layer.route, index).id;
+    const uint32_t end = getRoutePoint(layer.route, index + 1).id;
+    const SpatialGrid &grid = layer.grid;
+    insertSegment(layer.segments, start, grid.xs[start], grid.ys[start], grid.xs[end], grid.ys[end]);
+}
+
+// The route keeps metres, the grids map space
+void insertMeasuringPoint(MeasuringLayer &layer, size_t index, const float metresX, const float metresY,
+                          const Georeference &georeference) {
+    index = std::min(index, layer.route.size);
+    const uint32_t id = acquirePointId(layer);
+    float mapX, mapY;
+    metresToMap(georeference, &metresX, &metresY, 1, &mapX, &mapY);
+    insertRoutePoint(layer.route, index, {metresX, metresY, id});
+    insertIntoGrid(layer.grid, id, mapX, mapY);
+    expandBounds(&metresX, &metresY, 1, layer.bounds);
+
+    // The segment the point splits becomes the two on either side of it
+    if (index > 0) {
+        linkMeasuringSegment(layer, index - 1);
+    }
+    linkMeasuringSegment(layer, index);
+}
+
+Point removeMeasuringPoint(MeasuringLayer &layer, const size_t index) {
+    const Point removed = removeRoutePoint(layer.route, index);
+    removeFromGrid(layer.grid, removed.id);
+    removeSegment(layer.segments, removed.id);
+    layer.freeIds.push_back(removed.id);
+    if (removed.x <= layer.bounds.minX || removed.x >= layer.bounds.maxX ||
+        removed.y <= layer.bounds.minY || removed.y >= layer.bounds.maxY) {
+        layer.boundsStale = true;
+    }
+
+    // The neighbours are joined by one segment, or the previous point is the new end
+    if (index > 0) {
+        if (index < layer.route.size) {
+            linkMeasuringSegment(layer, index - 1);
+        } else {
+            removeSegment(layer.segments, getRoutePoint(layer.route, index - 1).id);
+        }
+    }
+    return removed;
+}
+
+void applyRouteEdit(MeasuringLayer &layer, const RouteEdit &edit, const Georeference &georeference) {
+    if (edit.type == RouteEditType::Insert) {
+        insertMeasuringPoint(layer, edit.index, edit.x, edit.y, georeference);
+    } else {
+        removeMeasuringPoint(layer, edit.index);
+    }
+}
+
+// Graph nodes nearest the end of the route and a point in map space, -1 when off the
+// streets. The end is also returned in graph pixels.
+void snapRoadEnds(const MeasuringLayer &layer, const HierarchyQuery &query, const float mapX, const float mapY,
+                  const Georeference &georeference, int32_t &source, int32_t &target, float &endX, float &endY) {
+    const ContractionHierarchy &hierarchy = *query.hierarchy;
+    const Point last = getRoutePoint(layer.route, layer.route.size - 1);
+    float endMapX, endMapY, x, y;
+    metresToMap(georeference, &last.x, &last.y, 1, &endMapX, &endMapY);
+    mapToRoadPixels(hierarchy.width, hierarchy.height, endMapX, endMapY, endX, endY);
+    mapToRoadPixels(hierarchy.width, hierarchy.height, mapX, mapY, x, y);
+    source = snapToHierarchy(query, endX, endY);
+    target = snapToHierarchy(query, x, y);
+}
+
+void roadNodeToMetres(const ContractionHierarchy &hierarchy, const uint32_t node, const Georeference &georeference,
+                      float &metresX, float &metresY) {
+    float mapX, mapY;
+    roadPixelsToMap(hierarchy.width, hierarchy.height, hierarchy.xs[node], hierarchy.ys[node], mapX, mapY);
+    mapToMetres(georeference, &mapX, &mapY, 1, &metresX, &metresY);
+}
+
+// A route already ending on the first node of its path, as after an earlier routed
+// click, does not repeat it
+bool isRouteEndOnNode(const ContractionHierarchy &hierarchy, const uint32_t node, const float endX, const float endY) {
+    return std::hypot(hierarchy.xs[node] - endX, hierarchy.ys[node] - endY) < 0.5f;
+}
+
+// Appends the streets from the end of the route to a point in map space, false when
+// either end is off the graph or no street connects them. Every point after the first
+// is chained to the one before, so the whole path is undone at once.
+bool appendRoadPath(MeasuringLayer &layer, HierarchyQuery &query, const float mapX, const float mapY,
+                    const Georeference &georeference) {
+    if (layer.route.size == 0) {
+        return false;
+    }
+    int32_t source, target;
+    float endX, endY;
+    snapRoadEnds(layer, query, mapX, mapY, georeference, source, target, endX, endY);
+    if (source < 0 || target < 0 || source == target ||
+        !findHierarchyPath(query, static_cast<uint32_t>(source), static_cast<uint32_t>(target))) {
+        return false;
+    }
+
+    const ContractionHierarchy &hierarchy = *query.hierarchy;
+    bool chained = false;
+    for (const uint32_t node: query.path) {
+        if (!chained && isRouteEndOnNode(hierarchy, node, endX, endY)) {
+            continue;
+        }
+        float metresX, metresY;
+        roadNodeToMetres(hierarchy, node, georeference, metresX, metresY);
+        const RouteEdit edit{RouteEditType::Insert, static_cast<uint32_t>(layer.route.size), metresX, metresY, chained};
+        applyRouteEdit(layer, edit, georeference);
+        recordRouteEdit(layer.history, edit);
+        chained = true;
+    }
+    return true;
+}
+
+// Shift+click always appends, even on a point or next to a segment. With a road query,
+// appends follow the streets and fall back to a straight segment where there is no path.
+void handleMeasuringModeClick(MeasuringLayer &layer, HierarchyQuery *roadQuery, double mouseX, double mouseY,
+                              bool forceAppend, int screenWidth, int screenHeight, const Georeference &georeference) {
     float ndcX = static_cast<float>(mouseX) / screenWidth * 2.0f - 1.0f;
     float ndcY = 1.0f - static_cast<float>(mouseY) / screenHeight * 2.0f;
 
-    bool clickedOnExistingPoint = false;
-    size_t clickedIndex = 0;
+    // Only the grid cells around the click are searched, the nearest point in range wins
+    const int32_t clickedId = forceAppend ? -1 : findNearestInGrid(layer.grid, ndcX, ndcY, MeasuringState::HIT_RADIUS);
+
+    RouteEdit edit{};
+    size_t index;
+    if (clickedId >= 0 && findRoutePoint(layer.route, static_cast<uint32_t>(clickedId), index)) {
+        // Remove the clicked point
+        const Point removed = getRoutePoint(layer.route, index);
+        edit = {RouteEditType::Remove, static_cast<uint32_t>(index), removed.x, removed.y};
+    } else {
+        // Near a segment the point goes between its ends, elsewhere after the last point
+        size_t insertAt = layer.route.size;
+        const int32_t segmentId = forceAppend ? -1 : findNearestSegment(layer.segments, ndcX, ndcY,
+                                                                         MeasuringState::SEGMENT_HIT_RADIUS);
+        if (segmentId >= 0 && findRoutePoint(layer.route, static_cast<uint32_t>(segmentId), index)) {
+            insertAt = index + 1;
+        }
+        if (roadQuery && insertAt == layer.route.size && appendRoadPath(layer, *roadQuery, ndcX, ndcY, georeference)) {
+            layer.totalMeasuredDistance = getRouteLength(layer.route);
+            return;
+        }
+
+        // Measuring mode NDC is map space, the route itself is kept in metres
+        float metresX, metresY;
+        mapToMetres(georeference, &ndcX, &ndcY, 1, &metresX, &metresY);
+        edit = {RouteEditType::Insert, static_cast<uint32_t>(insertAt), metresX, metresY};
+    }
+    applyRouteEdit(layer, edit, georeference);
+    recordRouteEdit(layer.history, edit);
 
-    for (size_t i = 0; i < measuringState.points.size(); ++i) {
-        const Point &p = measuringState.points[i];
-        float dist = std::sqrt((p.x - ndcX) * (p.x - ndcX) + (p.y - ndcY) * (p.y - ndcY));
+    // The store keeps segment lengths in a Fenwick tree, the total is a prefix sum rather than a rescan
+    layer.totalMeasuredDistance = getRouteLength(layer.route);
+}
 
-        if (dist < 0.03f) {
-            clickedOnExistingPoint = true;
-            clickedIndex = i;
+// Undo applies the opposite of the last edit, redo the edit itself. Either touches
+// one point per edit, lengths and the buffer follow through the store like any other
+// edit. Chained edits go together with the edit they follow.
+void undoMeasuringEdit(MeasuringLayer &layer, const Georeference &georeference) {
+    RouteEdit edit{};
+    bool undone = false;
+    while (popUndoEdit(layer.history, edit)) {
+        edit.type = edit.type == RouteEditType::Insert ? RouteEditType::Remove : RouteEditType::Insert;
+        applyRouteEdit(layer, edit, georeference);
+        undone = true;
+        if (!edit.chained) {
             break;
         }
     }
+    if (undone) {
+        layer.totalMeasuredDistance = getRouteLength(layer.route);
+    }
+}
 
-    if (clickedOnExistingPoint) {
-        // Recalculate total distance from scratch to avoid accumulation errors
-        measuringState.totalMeasuredDistance = 0.0f;
+void redoMeasuringEdit(MeasuringLayer &layer, const Georeference &georeference) {
+    RouteEdit edit{};
+    if (popRedoEdit(layer.history, edit)) {
+        applyRouteEdit(layer, edit, georeference);
+        while (peekRedoEdit(layer.history, edit) && edit.chained) {
+            popRedoEdit(layer.history, edit);
+            applyRouteEdit(layer, edit, georeference);
+        }
+        layer.totalMeasuredDistance = getRouteLength(layer.route);
+    }
+}
 
-        // Remove the clicked point
-        measuringState.points.erase(measuringState.points.begin() + clickedIndex);
+// ============================================================================
+// TRACK IMPORT
+// ============================================================================
+struct TrackImportTarget {
+    MeasuringLayer *layer;
+    const Georeference *georeference;
+    std::vector<uint32_t> ids;
+    std::vector<float> mapXs, mapYs;
+};
 
-        // Recalculate total distance for remaining points
-        for (size_t i = 1; i < measuringState.points.size(); ++i) {
-            const Point &prev = measuringState.points[i - 1];
-            const Point &curr = measuringState.points[i];
+void appendImportedPoints(void *context, const float *xs, const float *ys, const size_t count) {
+    auto &target = *static_cast<TrackImportTarget *>(context);
+    MeasuringLayer &layer = *target.layer;
+
+    target.ids.resize(count);
+    target.mapXs.resize(count);
+    target.mapYs.resize(count);
+    metresToMap(*target.georeference, xs, ys, count, target.mapXs.data(), target.mapYs.data());
+    for (size_t i = 0; i < count; ++i) {
+        target.ids[i] = acquirePointId(layer);
+        insertIntoGrid(layer.grid, target.ids[i], target.mapXs[i], target.mapYs[i]);
+    }
 
-            float ndcDistance = std::sqrt(
-                (prev.x - curr.x) * (prev.x - curr.x) +
-                (prev.y - curr.y) * (prev.y - curr.y)
-            );
+    // Segments of the batch, and the one joining it to the route so far
+    if (layer.route.size > 0) {
+        const uint32_t last = getRoutePoint(layer.route, layer.route.size - 1).id;
+        insertSegment(layer.segments, last, layer.grid.xs[last], layer.grid.ys[last],
+                      target.mapXs[0], target.mapYs[0]);
+    }
+    for (size_t i = 0; i + 1 < count; ++i) {
+        insertSegment(layer.segments, target.ids[i], target.mapXs[i], target.mapYs[i],
+                      target.mapXs[i + 1], target.mapYs[i + 1]);
+    }
+    appendRoutePoints(layer.route, xs, ys, target.ids.data(), count);
+    expandBounds(xs, ys, count, layer.bounds);
+}
 
-            float convertedDistance = ndcDistance * (mapScale / fullscreenScale);
-            measuringState.totalMeasuredDistance += convertedDistance;
-        }
-    } else {
-        measuringState.points.push_back({ndcX, ndcY});
+// Appends a recorded track to the measured route
+void importMeasuringTrack(MeasuringLayer &layer, const char *path, const Georeference &georeference) {
+    TrackImportTarget target{&layer, &georeference, {}, {}, {}};
+    TrackImportStats stats;
+    if (!importTrack(path, georeference, appendImportedPoints, &target, stats)) {
+        return;
+    }
+    // Imports are not logged, earlier edits are not undone past them
+    clearRouteHistory(layer.history);
+
+    layer.totalMeasuredDistance = getRouteLength(layer.route);
+    std::cout << "Ucitano " << stats.points << " tacaka iz \"" << path << "\" za " << stats.seconds << " s";
+    if (stats.skipped > 0) {
+        std::cout << ", preskoceno " << stats.skipped << " neispravnih zapisa";
+    }
+    std::cout << "." << std::endl;
+}
+
+// ============================================================================
+// ROUTE FILES
+// ============================================================================
+void resetMeasuringRoute(MeasuringLayer &layer) {
+    clearRouteStore(layer.route);
+    clearSpatialGrid(layer.grid);
+    clearSegmentGrid(layer.segments);
+    layer.freeIds.clear();
+    layer.nextId = 0;
+    layer.totalMeasuredDistance = 0.0;
+    clearRouteHistory(layer.history);
+    layer.bounds = emptyBounds();
+    layer.boundsStale = false;
+}
+
+void saveMeasuringRoute(const MeasuringLayer &layer, const char *path, const Georeference &georeference,
+                        const bool compress) {
+    RouteFileStats stats;
+    if (saveRouteFile(path, layer.route, georeference, compress, stats)) {
+        std::cout << "Sacuvano " << stats.points << " tacaka u \"" << path << "\" (" << stats.bytes << " B) za "
+                  << stats.seconds << " s." << std::endl;
+    }
+}
+
+// Replaces the measured route with the one saved in the file
+void loadMeasuringRoute(MeasuringLayer &layer, const char *path, const Georeference &georeference) {
+    RouteFile file;
+    if (!openRouteFile(file, path, georeference)) {
+        return;
+    }
+
+    // Decoded blocks go through the same path as imported tracks
+    resetMeasuringRoute(layer);
+    TrackImportTarget target{&layer, &georeference, {}, {}, {}};
+    RouteFileStats stats;
+    const bool complete = readRouteFile(file, appendImportedPoints, &target, stats);
+    closeRouteFile(file);
+
+    layer.totalMeasuredDistance = getRouteLength(layer.route);
+    if (!complete) {
+        std::cout << "Trasa \"" << path << "\" je ostecena, ucitano je prvih " << stats.points << " tacaka."
+                  << std::endl;
+        return;
+    }
+    std::cout << "Ucitano " << stats.points << " tacaka iz \"" << path << "\" za " << stats.seconds << " s."
+              << std::endl;
+}
 
-        if (measuringState.points.size() > 1) {
-            const Point &prev = measuringState.points[measuringState.points.size() - 2];
-            const Point &curr = measuringState.points.back();
+// ============================================================================
+// MEASUREMENT LAYERS
+// ============================================================================
+// Later layers reuse the colors of the first ones
+constexpr float LAYER_COLORS[][3] = {
+    {1.0f, 1.0f, 1.0f},
+    {1.0f, 0.8f, 0.2f},
+    {0.3f, 0.9f, 0.4f},
+    {1.0f, 0.4f, 0.4f},
+    {0.4f, 0.7f, 1.0f},
+    {0.8f, 0.5f, 1.0f}
+};
+
+MeasuringLayer &getActiveLayer(MeasuringState &measuringState) {
+    return measuringState.layers[measuringState.activeLayer];
+}
+
+const MeasuringLayer &getActiveLayer(const MeasuringState &measuringState) {
+    return measuringState.layers[measuringState.activeLayer];
+}
+
+void reportActiveLayer(const MeasuringState &measuringState) {
+    const MeasuringLayer &layer = getActiveLayer(measuringState);
+    std::cout << "Aktivan sloj \"" << layer.name << "\" (" << measuringState.activeLayer + 1 << "/"
+              << measuringState.layers.size() << ")" << (layer.visible ? "" : ", sakriven") << "." << std::endl;
+}
+
+// Appends an empty layer and makes it active. The route buffer shares the unit quad
+// of setupBuffers, lengths are measured through the geodesic, which must outlive it.
+void addMeasuringLayer(MeasuringState &measuringState, const MapGeodesic &geodesic, const unsigned int quadBuffer,
+                       const unsigned int quadIndices) {
+    if (measuringState.layers.size() >= MeasuringState::MAX_LAYERS) {
+        std::cout << "Dostignut je najveci broj slojeva (" << MeasuringState::MAX_LAYERS << ")." << std::endl;
+        return;
+    }
+
+    const size_t number = measuringState.layers.size();
+    MeasuringLayer &layer = measuringState.layers.emplace_back();
+    layer.name = "Sloj " + std::to_string(number + 1);
+    const float *color = LAYER_COLORS[number % std::size(LAYER_COLORS)];
+    std::copy(color, color + 3, layer.color);
+
+    createRouteStore(layer.route, MeasuringState::RESERVED_POINTS);
+    setRouteLengthFunction(layer.route, measureMapPolyline, &geodesic);
+    layer.freeIds.reserve(MeasuringState::RESERVED_POINTS);
+    createRouteHistory(layer.history, MeasuringState::HISTORY_EDITS);
+    createSpatialGrid(layer.grid, -1.0f, -1.0f, 1.0f, 1.0f, MeasuringState::HIT_RADIUS,
+                      MeasuringState::RESERVED_POINTS);
+    createSegmentGrid(layer.segments, -1.0f, -1.0f, 1.0f, 1.0f, MeasuringState::HIT_RADIUS,
+                      MeasuringState::RESERVED_POINTS);
+    createRouteBuffer(layer.buffer, quadBuffer, quadIndices, MeasuringState::RESERVED_POINTS,
+                      MeasuringState::RESERVED_POINTS);
+
+    measuringState.activeLayer = number;
+}
+
+void destroyMeasuringLayers(MeasuringState &measuringState) {
+    for (MeasuringLayer &layer: measuringState.layers) {
+        destroyRouteBuffer(layer.buffer);
+    }
+    measuringState.layers.clear();
+}
+
+void cycleMeasuringLayer(MeasuringState &measuringState) {
+    measuringState.activeLayer = (measuringState.activeLayer + 1) % measuringState.layers.size();
+    reportActiveLayer(measuringState);
+}
+
+void toggleMeasuringLayer(MeasuringState &measuringState) {
+    MeasuringLayer &layer = getActiveLayer(measuringState);
+    layer.visible = !layer.visible;
+    reportActiveLayer(measuringState);
+}
+
+// Whether any of the layer can land in the measuring view, map space [-1, 1] grown by
+// margin for markers and line width. Only the corners of its bounds are transformed.
+bool isLayerOnScreen(MeasuringLayer &layer, const Georeference &georeference, const double margin) {
+    if (!layer.visible || layer.route.size == 0) {
+        return false;
+    }
+    if (layer.boundsStale) {
+        layer.bounds = getRouteBounds(layer.route);
+        layer.boundsStale = false;
+    }
 
-            float ndcDistance = std::sqrt(
-                (prev.x - curr.x) * (prev.x - curr.x) +
-                (prev.y - curr.y) * (prev.y - curr.y)
-            );
+    constexpr double infinity = std::numeric_limits<double>::infinity();
+    double minX = infinity, minY = infinity, maxX = -infinity, maxY = -infinity;
+    for (int corner = 0; corner < 4; ++corner) {
+        double x, y;
+        applyAffine(georeference.metresToMap, corner & 1 ? layer.bounds.maxX : layer.bounds.minX,
+                    corner & 2 ? layer.bounds.maxY : layer.bounds.minY, x, y);
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+    return maxX >= -1.0 - margin && minX <= 1.0 + margin && maxY >= -1.0 - margin && minY <= 1.0 + margin;
+}
 
-            float convertedDistance = ndcDistance * (mapScale / fullscreenScale);
-            measuringState.totalMeasuredDistance += convertedDistance;
+// Culls every layer by its bounds and brings the buffers of the ones left up to date,
+// so hidden and off-screen layers cost no per-vertex work
+void updateMeasuringLayers(MeasuringState &measuringState, const Georeference &georeference, const float tolerance,
+                           const double margin) {
+    for (MeasuringLayer &layer: measuringState.layers) {
+        layer.onScreen = isLayerOnScreen(layer, georeference, margin);
+        if (layer.onScreen) {
+            updateRouteBuffer(layer.buffer, layer.route, tolerance);
         }
     }
 }
 
 // ============================================================================
-// MODE SWITCHING
+// ROAD ROUTING
 // ============================================================================
-bool shouldSwitchMode(GLFWwindow *window, bool isWalkingMode, double currentTime,
-                      double &lastSwitchTime, int screenWidth, int screenHeight,
-                      const TextureData &walkingIndicator, const TextureData &measuringIndicator) {
-    bool switchRequested = false;
+// Maps the hierarchy written by KosturContract. A missing file, or one traced from a
+// different map, leaves routing unavailable rather than being rebuilt here.
+bool loadRoadHierarchy(const char *path, const int mapWidth, const int mapHeight, ContractionHierarchy &hierarchy) {
+    if (loadContractionHierarchy(path, hierarchy) && hierarchy.width == mapWidth && hierarchy.height == mapHeight) {
+        return true;
+    }
+    closeContractionHierarchy(hierarchy);
+    std::cout << "Rutiranje po ulicama nije dostupno, napravite \"" << path
+              << "\" alatima KosturRoadGraph i KosturContract." << std::endl;
+    return false;
+}
 
-    // Check keyboard switch
-    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && currentTime - lastSwitchTime > 0.2) {
-        switchRequested = true;
+// The hierarchy is mapped the first time routing is turned on, so runs that never
+// route never touch it. Without one routing stays off.
+void toggleRoadRouting(MeasuringState &measuringState, ContractionHierarchy &hierarchy, HierarchyQuery &query,
+                       const char *hierarchyPath, const int mapWidth, const int mapHeight) {
+    if (!measuringState.roadRouting && !query.hierarchy) {
+        if (!loadRoadHierarchy(hierarchyPath, mapWidth, mapHeight, hierarchy)) {
+            return;
+        }
+        createHierarchyQuery(query, hierarchy, MeasuringState::ROAD_SNAP_RADIUS);
     }
+    measuringState.roadRouting = !measuringState.roadRouting;
+    std::cout << "Rutiranje po ulicama " << (measuringState.roadRouting ? "ukljuceno" : "iskljuceno") << "."
+              << std::endl;
+}
 
-    // Check mouse click on indicator
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && currentTime - lastSwitchTime > 0.2) {
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
+void createRoutePreview(RoutePreview &preview, const MapGeodesic &geodesic, const unsigned int quadBuffer,
+                        const unsigned int quadIndices) {
+    createRouteStore(preview.route, MeasuringState::RESERVED_PREVIEW_POINTS);
+    setRouteLengthFunction(preview.route, measureMapPolyline, &geodesic);
+    createRouteBuffer(preview.buffer, quadBuffer, quadIndices, MeasuringState::RESERVED_PREVIEW_POINTS, 0);
+}
 
-        const TextureData &currentIndicator = isWalkingMode ? walkingIndicator : measuringIndicator;
-        if (isMouseOverIndicator(mouseX, mouseY, screenWidth, screenHeight, currentIndicator)) {
-            switchRequested = true;
+// Searches the hierarchy again only when the route's end or the street under the
+// cursor changed, a query takes microseconds but most frames change neither
+void updateRoutePreview(RoutePreview &preview, const MeasuringLayer &layer, HierarchyQuery &query,
+                        const float mapX, const float mapY, const Georeference &georeference, const float tolerance) {
+    int32_t source = -1, target = -1;
+    float endX = 0.0f, endY = 0.0f;
+    if (layer.visible && layer.route.size > 0) {
+        snapRoadEnds(layer, query, mapX, mapY, georeference, source, target, endX, endY);
+    }
+    if (&layer != preview.layer || endX != preview.endX || endY != preview.endY || target != preview.target) {
+        preview.layer = &layer;
+        preview.endX = endX;
+        preview.endY = endY;
+        preview.target = target;
+
+        clearRouteStore(preview.route);
+        preview.found = source >= 0 && target >= 0 && source != target &&
+                        findHierarchyPath(query, static_cast<uint32_t>(source), static_cast<uint32_t>(target));
+        if (preview.found) {
+            const ContractionHierarchy &hierarchy = *query.hierarchy;
+            appendRoutePoint(preview.route, getRoutePoint(layer.route, layer.route.size - 1));
+            for (const uint32_t node: query.path) {
+                if (preview.route.size == 1 && isRouteEndOnNode(hierarchy, node, endX, endY)) {
+                    continue;
+                }
+                Point point{0.0f, 0.0f, static_cast<uint32_t>(preview.route.size)};
+                roadNodeToMetres(hierarchy, node, georeference, point.x, point.y);
+                appendRoutePoint(preview.route, point);
+            }
         }
     }
+    updateRouteBuffer(preview.buffer, preview.route, tolerance);
+}
+
+// ============================================================================
+// MODE SWITCHING
+// ============================================================================
+bool isModeSwitchEvent(const InputEvent &event, bool isWalkingMode, int screenWidth, int screenHeight,
+                       const TextureData &walkingIndicator, const TextureData &measuringIndicator) {
+    // Keyboard switch, key repeats are ignored so holding R switches only once
+    if (isPressEvent(event, InputEventType::Key, GLFW_KEY_R)) {
+        return true;
+    }
 
-    return switchRequested;
+    // Mouse click on indicator, using the cursor position at the moment of the click
+    if (isPressEvent(event, InputEventType::MouseButton, GLFW_MOUSE_BUTTON_LEFT)) {
+        const TextureData &currentIndicator = isWalkingMode ? walkingIndicator : measuringIndicator;
+        return isMouseOverIndicator(event.x, event.y, screenWidth, screenHeight, currentIndicator);
+    }
+
+    return false;
 }
 
 void performModeSwitch(bool &isWalkingMode, WalkingState &walkingState, MeasuringState &measuringState,
-                       float &mapPosX, float &mapPosY, float &totalDistanceWalked) {
+                       float &mapPosX, float &mapPosY, DistanceSum &totalDistanceWalked) {
     if (isWalkingMode) {
         walkingState.mapPosX = mapPosX;
         walkingState.mapPosY = mapPosY;
@@ -336,68 +1011,211 @@ void performModeSwitch(bool &isWalkingMode, WalkingState &walkingState, Measurin
 }
 
 // ============================================================================
-// RENDER MODES
+// SIMULATION
 // ============================================================================
-void renderWalkingMode(const unsigned int shaderProgram, const unsigned int VAO,
-                       const TextureData &bgImage, const TextureData &pinImage,
-                       const TextureData &modeIndicator, const DigitTextures &digitTextures,
-                       float &mapPosX, float &mapPosY, float &totalDistanceWalked,
-                       GLFWwindow *window, int screenWidth, int screenHeight,
-                       float mapSpeed, double targetFPS, float mapScale) {
-    // Handle movement
+// mapPosToPin gives the map space point under the pin for a map position
+void advanceWalking(const InputState &input, const double deltaTime, const float mapSpeed,
+                    const AffineTransform &mapPosToPin, const MapGeodesic &geodesic,
+                    float &mapPosX, float &mapPosY, DistanceSum &totalDistanceWalked) {
+    if (deltaTime <= 0.0) {
+        return;
+    }
+
+    const float step = mapSpeed * static_cast<float>(deltaTime);
     float moveX = 0.0f;
     float moveY = 0.0f;
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) moveY = -mapSpeed / targetFPS;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) moveY = mapSpeed / targetFPS;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) moveX = mapSpeed / targetFPS;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) moveX = -mapSpeed / targetFPS;
+    if (input.keys[GLFW_KEY_W]) moveY = -step;
+    if (input.keys[GLFW_KEY_S]) moveY = step;
+    if (input.keys[GLFW_KEY_A]) moveX = step;
+    if (input.keys[GLFW_KEY_D]) moveX = -step;
+
+    if (moveX == 0.0f && moveY == 0.0f) {
+        return;
+    }
 
+    double fromX, fromY, toX, toY;
+    applyAffine(mapPosToPin, mapPosX, mapPosY, fromX, fromY);
     mapPosX += moveX;
     mapPosY += moveY;
-    totalDistanceWalked += std::sqrt(moveX * moveX + moveY * moveY);
+    applyAffine(mapPosToPin, mapPosX, mapPosY, toX, toY);
+
+    // Steps are a few metres each, a compensated sum keeps long walks from drifting
+    addDistance(totalDistanceWalked, measureMapStep(geodesic, fromX, fromY, toX, toY));
+}
 
-    // Render scene
+// ============================================================================
+// RENDER MODES
+// ============================================================================
+// Map and overlay passes may go to the scaled scene target. HUD passes always
+// draw at native resolution on top of the scene.
+void renderWalkingMap(const unsigned int shaderProgram, const unsigned int VAO, const TextureData &bgImage,
+                      float mapPosX, float mapPosY, float mapScale) {
     renderImage(shaderProgram, VAO, bgImage.textureID, mapPosX, mapPosY, mapScale, mapScale);
+}
+
+void renderWalkingOverlay(const unsigned int shaderProgram, const unsigned int VAO, const TextureData &pinImage) {
     renderPin(shaderProgram, VAO, pinImage.textureID);
+}
+
+void renderWalkingHud(const unsigned int shaderProgram, const unsigned int VAO, FrameArena &arena,
+                      const TextureData &modeIndicator, const DigitTextures &digitTextures,
+                      double totalDistanceWalked, int screenWidth, int screenHeight) {
     renderModeIndicator(shaderProgram, VAO, modeIndicator, screenWidth, screenHeight);
-    renderNumber(shaderProgram, VAO, digitTextures, totalDistanceWalked, -0.95f, 0.9f, 0.05f);
+    renderNumber(shaderProgram, VAO, arena, digitTextures, totalDistanceWalked, -0.95f, 0.9f, 0.05f);
 }
 
-void renderMeasuringMode(const unsigned int shaderProgram, const unsigned int VAO,
-                         const TextureData &bgImage, const TextureData &modeIndicator,
-                         const DigitTextures &digitTextures, MeasuringState &measuringState,
-                         GLFWwindow *window, int screenWidth, int screenHeight,
-                         float fullscreenScale, float mapScale, bool &leftMousePressed) {
-    // Render fullscreen map
+void renderMeasuringMap(const unsigned int shaderProgram, const unsigned int VAO, const TextureData &bgImage,
+                        float fullscreenScale) {
     renderImage(shaderProgram, VAO, bgImage.textureID, 0.0f, 0.0f, fullscreenScale, fullscreenScale);
-    renderModeIndicator(shaderProgram, VAO, modeIndicator, screenWidth, screenHeight);
+}
 
-    // Render points and lines
-    for (size_t i = 0; i < measuringState.points.size(); ++i) {
-        const Point &p = measuringState.points[i];
-        renderPoint(shaderProgram, VAO, p.x, p.y);
+constexpr float PREVIEW_COLOR[3] = {0.2f, 0.6f, 1.0f};
 
-        if (i > 0) {
-            const Point &prev = measuringState.points[i - 1];
-            renderLine(shaderProgram, VAO, prev.x, prev.y, p.x, p.y);
+// Layers that passed this frame's cull test, the active one last so it is drawn on top
+void renderMeasuringOverlay(const unsigned int shaderProgram, const unsigned int VAO,
+                            const MeasuringState &measuringState, const Georeference &georeference) {
+    const MeasuringLayer &active = getActiveLayer(measuringState);
+
+    // The buffers hold metres, map space is NDC in this mode
+    for (const MeasuringLayer &layer: measuringState.layers) {
+        if (layer.onScreen && &layer != &active) {
+            renderRoute(shaderProgram, layer.buffer, georeference.metresToMap, layer.color, 0.012f);
         }
     }
+    if (active.onScreen) {
+        if (measuringState.areaMode) {
+            renderRouteFill(shaderProgram, VAO, active.buffer, georeference.metresToMap);
+        }
+        renderRoute(shaderProgram, active.buffer, georeference.metresToMap, active.color);
+    }
+
+    // A routed path to the cursor replaces the rubber band while one is found
+    const RoutePreview &preview = measuringState.preview;
+    const bool previewShown = measuringState.roadRouting && preview.found && &active == preview.layer;
+    if (previewShown) {
+        renderRoute(shaderProgram, preview.buffer, georeference.metresToMap, PREVIEW_COLOR, 0.0f);
+    }
+
+    // Hover marker and rubber band follow the cursor latched right before submission
+    const RouteStore &route = active.route;
+    if (active.visible && route.size > 0 && !previewShown) {
+        const Point last = getRoutePoint(route, route.size - 1);
+        double lastX, lastY;
+        applyAffine(georeference.metresToMap, last.x, last.y, lastX, lastY);
+        renderLatchedCursorLine(shaderProgram, VAO, static_cast<float>(lastX), static_cast<float>(lastY));
+    }
+    renderLatchedCursorPoint(shaderProgram, VAO);
+}
 
-    renderNumber(shaderProgram, VAO, digitTextures, measuringState.totalMeasuredDistance, -0.95f, 0.9f, 0.05f);
+void renderMeasuringHud(const unsigned int shaderProgram, const unsigned int VAO, FrameArena &arena,
+                        const TextureData &modeIndicator, const DigitTextures &digitTextures,
+                        const MeasuringState &measuringState, double cursorX, double cursorY,
+                        int screenWidth, int screenHeight) {
+    renderModeIndicator(shaderProgram, VAO, modeIndicator, screenWidth, screenHeight);
 
-    // Handle mouse input
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !leftMousePressed) {
-        leftMousePressed = true;
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
+    // Square metres of the active route closed in area mode, its length otherwise
+    const MeasuringLayer &layer = getActiveLayer(measuringState);
+    const double measured = measuringState.areaMode ? std::abs(getRouteSignedArea(layer.route))
+                                                    : layer.totalMeasuredDistance;
+    renderNumber(shaderProgram, VAO, arena, digitTextures, measured, -0.95f, 0.9f, 0.05f);
+    if (!layer.visible) {
+        return;
+    }
 
-        handleMeasuringModeClick(measuringState, mouseX, mouseY, screenWidth, screenHeight,
-                                 mapScale, fullscreenScale);
+    // The length a routed click would add, updated as the cursor moves
+    const RoutePreview &preview = measuringState.preview;
+    if (measuringState.roadRouting && preview.found && &layer == preview.layer) {
+        renderNumber(shaderProgram, VAO, arena, digitTextures, getRouteLength(preview.route), -0.95f, 0.7f, 0.05f);
     }
 
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
-        leftMousePressed = false;
+    // Hovering a point shows the distance from the start of the route to it, below the total
+    const float ndcX = static_cast<float>(cursorX) / screenWidth * 2.0f - 1.0f;
+    const float ndcY = 1.0f - static_cast<float>(cursorY) / screenHeight * 2.0f;
+    const int32_t hoveredId = findNearestInGrid(layer.grid, ndcX, ndcY, MeasuringState::HIT_RADIUS);
+    size_t index;
+    if (hoveredId >= 0 && findRoutePoint(layer.route, static_cast<uint32_t>(hoveredId), index)) {
+        renderNumber(shaderProgram, VAO, arena, digitTextures, getRouteDistanceTo(layer.route, index),
+                     -0.95f, 0.8f, 0.05f);
+    }
+}
+
+// ============================================================================
+// PROFILER OVERLAY
+// ============================================================================
+// One row per pass in the top right corner: color swatch, GPU ms, CPU ms, with the
+// frame total at the bottom and a stacked bar of the GPU time against the frame budget
+// Columns: GPU ms, CPU ms, and with GL stats installed draw calls, binds and uniform uploads of the pass
+void renderProfilerOverlay(const unsigned int shaderProgram, const unsigned int VAO, FrameArena &arena,
+                           const DigitTextures &digitTextures, const Profiler &profiler, double budgetMs,
+                           const GlFrameStats *glStats) {
+    GlSubsystemScope glScope(GlSubsystem::Profiler);
+
+    constexpr float passColors[PROFILE_PASS_COUNT][3] = {
+        {0.2f, 0.6f, 1.0f}, // Map
+        {1.0f, 0.8f, 0.2f}, // Overlay
+        {0.7f, 0.4f, 1.0f}, // Resolve
+        {0.3f, 0.9f, 0.4f}, // Hud
+        {1.0f, 0.4f, 0.4f}  // Badge
+    };
+    constexpr GlSubsystem passSubsystems[PROFILE_PASS_COUNT] = {
+        GlSubsystem::Map, GlSubsystem::Overlay, GlSubsystem::Resolve, GlSubsystem::Hud, GlSubsystem::Badge
+    };
+    constexpr GlCounter glColumns[] = {GlCounter::DrawCalls, GlCounter::Binds, GlCounter::UniformUploads};
+    const float left = glStats ? 0.0f : 0.45f;
+    const float panelWidth = glStats ? 1.0f : 0.58f;
+    constexpr float top = 0.92f;
+    constexpr float rowHeight = 0.07f;
+    constexpr float digitScale = 0.035f;
+
+    // Light backdrop, the digit textures are dark
+    renderRect(shaderProgram, VAO, left - 0.03f, top - rowHeight * 3.5f, panelWidth, rowHeight * 8.5f,
+               0.95f, 0.95f, 0.95f);
+
+    for (int pass = 0; pass < PROFILE_PASS_COUNT; ++pass) {
+        const float y = top - rowHeight * pass;
+        const float *color = passColors[pass];
+        renderRect(shaderProgram, VAO, left, y, 0.03f, 0.04f, color[0], color[1], color[2]);
+        renderNumber(shaderProgram, VAO, arena, digitTextures, static_cast<float>(profiler.gpuMs[pass]),
+                     left + 0.07f, y, digitScale);
+        renderNumber(shaderProgram, VAO, arena, digitTextures, static_cast<float>(profiler.cpuMs[pass]),
+                     left + 0.32f, y, digitScale);
+
+        if (glStats) {
+            for (int column = 0; column < 3; ++column) {
+                renderCount(shaderProgram, VAO, arena, digitTextures,
+                            glStats->get(passSubsystems[pass], glColumns[column]),
+                            left + 0.57f + 0.15f * column, y, digitScale);
+            }
+        }
+    }
+
+    const float totalY = top - rowHeight * PROFILE_PASS_COUNT;
+    renderRect(shaderProgram, VAO, left, totalY, 0.03f, 0.04f, 1.0f, 1.0f, 1.0f);
+    renderNumber(shaderProgram, VAO, arena, digitTextures, static_cast<float>(profiler.gpuTotalMs),
+                 left + 0.07f, totalY, digitScale);
+    renderNumber(shaderProgram, VAO, arena, digitTextures, static_cast<float>(profiler.cpuTotalMs),
+                 left + 0.32f, totalY, digitScale);
+    if (glStats) {
+        for (int column = 0; column < 3; ++column) {
+            renderCount(shaderProgram, VAO, arena, digitTextures, glStats->total(glColumns[column]),
+                        left + 0.57f + 0.15f * column, totalY, digitScale);
+        }
+    }
+
+    // Full bar width is the frame budget
+    constexpr float barWidth = 0.5f;
+    const float barY = totalY - rowHeight;
+    float barX = left;
+    renderRect(shaderProgram, VAO, left, barY, barWidth, 0.03f, 0.6f, 0.6f, 0.6f);
+    for (int pass = 0; pass < PROFILE_PASS_COUNT; ++pass) {
+        const float width = std::min(static_cast<float>(profiler.gpuMs[pass] / budgetMs) * barWidth,
+                                     left + barWidth - barX);
+        if (width > 0.0f) {
+            const float *color = passColors[pass];
+            renderRect(shaderProgram, VAO, barX, barY, width, 0.03f, color[0], color[1], color[2]);
+            barX += width;
+        }
     }
 }
 
@@ -450,48 +1268,72 @@ void cleanupResources(unsigned int VAO, unsigned int VBO, unsigned int EBO, unsi
     glDeleteTextures(1, &walkingIndicator.textureID);
     glDeleteTextures(1, &measuringIndicator.textureID);
 
-    glfwDestroyCursor(cursor);
+    if (cursor) {
+        glfwDestroyCursor(cursor);
+    }
 }
 
 // ============================================================================
 // MAIN FUNCTION
 // ============================================================================
-int main() {
-    // Initialize GLFW and create window
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+int main(int argc, char **argv) {
+    const AppOptions options = parseOptions(argc, argv);
+    if (options.tracePath) {
+        startTrace();
+        setTraceThreadName("main");
+    }
 
-    GLFWmonitor *monitor = glfwGetPrimaryMonitor();
-    const GLFWvidmode *mode = glfwGetVideoMode(monitor);
+    // Create the window, or an offscreen context when running headless
+    Display display;
+    InputQueue inputQueue;
 
-    glfwWindowHint(GLFW_RED_BITS, mode->redBits);
-    glfwWindowHint(GLFW_GREEN_BITS, mode->greenBits);
-    glfwWindowHint(GLFW_BLUE_BITS, mode->blueBits);
-    glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
+    if (options.headless) {
+        if (!createHeadlessDisplay(display, options.headlessWidth, options.headlessHeight)) {
+            return endProgram("Headless kontekst nije uspeo da se kreira.");
+        }
+    } else {
+        if (!createWindowDisplay(display, inputQueue)) {
+            return endProgram("Prozor nije uspeo da se kreira.");
+        }
 
-    GLFWwindow *window = glfwCreateWindow(mode->width, mode->height, "Kretanje po mapi", monitor, nullptr);
-    if (!window) {
-        return endProgram("Prozor nije uspeo da se kreira.");
+        cursor = loadImageToCursor("../resources/cursors/compass.png");
+        glfwSetCursor(display.window, cursor);
     }
 
-    glfwMakeContextCurrent(window);
-    glfwSetKeyCallback(window, keyCallback);
-
-    cursor = loadImageToCursor("../resources/cursors/compass.png");
-    glfwSetCursor(window, cursor);
-
-    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    if (!gladLoadGLLoader(getDisplayLoader(display))) {
         return endProgram("GLAD nije uspeo da se inicijalizuje.");
     }
+    setupDisplayFramebuffer(display);
+
+    // Scripted benchmark run
+    BenchmarkRunner benchmark;
+    const bool isBenchmark = options.benchmarkPath != nullptr;
+    if (isBenchmark) {
+        if (!loadScenario(benchmark, options.benchmarkPath)) {
+            return endProgram("Benchmark scenario nije uspeo da se ucita.");
+        }
+        benchmark.warmupFrames = options.warmupFrames;
+        benchmark.assertNoAllocations = options.assertNoAllocations;
+    }
+    if (isBenchmark || options.glStats) {
+        installGlStats();
+    }
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Load textures
+    setGlSubsystem(GlSubsystem::Loading);
     const TextureData cornerImage = loadTexture("../resources/textures/student_info.png");
     const TextureData bgImage = loadTexture("../resources/textures/map.jpg");
+    Georeference georeference;
+    loadGeoreference(georeference, "../resources/textures/map.jgw", bgImage.width, bgImage.height,
+                     MapProjection::WebMercator);
+
+    // Streets for routed measuring, mapped when G first turns routing on
+    const char *roadHierarchyPath = options.hierarchyPath ? options.hierarchyPath : "../resources/textures/map.ch";
+    ContractionHierarchy roadHierarchy;
+    HierarchyQuery roadQuery;
     const TextureData pinImage = loadTexture("../resources/textures/pin.png");
     const TextureData walkingModeIndicator = loadTexture("../resources/textures/walking.png");
     const TextureData measuringModeIndicator = loadTexture("../resources/textures/ruler.png");
@@ -503,15 +1345,47 @@ int main() {
     unsigned int VBO, VAO, EBO;
     setupBuffers(VAO, VBO, EBO);
 
+    LateLatch lateLatch;
+    createLateLatch(lateLatch);
+
+    Profiler profiler;
+    createProfiler(profiler);
+    SceneTarget sceneTarget;
+    setGlSubsystem(GlSubsystem::Other);
+
+    // Previous frame's GL call counts, the first "frame" is everything issued while loading
+    GlFrameStats glFrameStats;
+    collectGlFrameStats(glFrameStats);
+
     // Game state
-    int screenWidth, screenHeight;
+    int screenWidth, screenHeight;           // Window coordinates, used for cursor and HUD layout
+    int framebufferWidth, framebufferHeight; // Pixels, differ from the window size on HiDPI displays
     float mapPosX = 0.0f;
     float mapPosY = 0.0f;
     bool isWalkingMode = true;
-    float totalDistanceWalked = 0.0f;
+    DistanceSum totalDistanceWalked;
+
+    // Ground distances follow the WGS 84 ellipsoid when the map has a geographic world file
+    const MapGeodesic mapGeodesic{&georeference, GeodesicMethod::Vincenty};
 
     WalkingState walkingState{};
     MeasuringState measuringState;
+    measuringState.layers.reserve(MeasuringState::MAX_LAYERS);
+    addMeasuringLayer(measuringState, mapGeodesic, VBO, EBO);
+    createRoutePreview(measuringState.preview, mapGeodesic, VBO, EBO);
+
+    // The route file is read first, a track given as well is appended to it
+    const char *routePath = options.routePath ? options.routePath : "route.krt";
+    if (options.routePath) {
+        loadMeasuringRoute(getActiveLayer(measuringState), routePath, georeference);
+    }
+    if (options.trackPath) {
+        importMeasuringTrack(getActiveLayer(measuringState), options.trackPath, georeference);
+    }
+
+    // Transient per-frame data, HUD text and the profiler overlay
+    FrameArena frameArena;
+    createFrameArena(frameArena, 256 << 10);
 
     // Timing constants
     constexpr double TARGET_FPS = 75.0;
@@ -519,57 +1393,258 @@ int main() {
     constexpr float MAP_SPEED = 0.4f;
     constexpr float MAP_SCALE = 8.0f;
     constexpr float FULLSCREEN_SCALE = 2.0f;
+    constexpr double ROUTE_TOLERANCE_PIXELS = 0.5; // Route detail smaller than this is not drawn
+    constexpr double ROUTE_CULL_MARGIN = 0.05;     // Map space, covers markers sticking out of the bounds
+
+    // The pin stays at the screen centre, so the map point under it is NDC 0 seen through the walking view
+    const AffineTransform mapPosToPin = {-2.0 / MAP_SCALE, 0.0, 0.0, 0.0, -2.0 / MAP_SCALE, 0.0};
+
+    if (isBenchmark) {
+        display.fixedTimeStep = FRAME_TIME;
+    }
+
+    ResolutionPolicy resolutionPolicy;
+    resolutionPolicy.budgetMs = options.frameBudgetMs > 0.0 ? options.frameBudgetMs : FRAME_TIME * 1000.0;
 
     // Input state
-    static bool leftMousePressed = false;
-    double lastSwitchTime = 0.0;
+    InputState inputState;
+    double simulationTime = getDisplayTime(display);
+    double cursorX, cursorY;
+    long long frameCount = 0;
+
+    // Start counting allocations from the first frame, not from program start
+    AllocationStats frameAllocations;
+    collectAllocations(frameAllocations);
 
     // Main loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!shouldCloseDisplay(display)) {
+        TRACE_SCOPE("frame", "loop");
+        resetFrameArena(frameArena);
         auto frameStart = std::chrono::high_resolution_clock::now();
 
-        glfwGetWindowSize(window, &screenWidth, &screenHeight);
-        glClear(GL_COLOR_BUFFER_BIT);
+        getDisplaySize(display, screenWidth, screenHeight, framebufferWidth, framebufferHeight);
+
+        if (isBenchmark) {
+            AllocationScopeGuard allocationScope(AllocationScope::Benchmark);
+            if (!advanceScenario(benchmark, inputQueue, getDisplayTime(display), screenWidth, screenHeight)) {
+                requestDisplayClose(display);
+            }
+        }
+        getDisplayCursor(display, inputState, cursorX, cursorY);
+        beginLateLatchFrame(lateLatch, cursorX, cursorY, screenWidth, screenHeight);
+
+        // Consume input events in arrival order, advancing the simulation up to each event's timestamp
+        beginTraceSlice("input", "loop");
+        setAllocationScope(AllocationScope::Input);
+        // GLFW calls back on this thread, so it can flush as the producer
+        inputQueue.flush();
+        InputEvent event{};
+        while (inputQueue.pop(event)) {
+            if (isWalkingMode) {
+                advanceWalking(inputState, event.time - simulationTime, MAP_SPEED, mapPosToPin, mapGeodesic,
+                               mapPosX, mapPosY, totalDistanceWalked);
+            }
+            simulationTime = std::max(simulationTime, event.time);
+            applyInputEvent(inputState, event);
+
+            if (isPressEvent(event, InputEventType::Key, GLFW_KEY_ESCAPE)) {
+                requestDisplayClose(display);
+            } else if (isPressEvent(event, InputEventType::Key, GLFW_KEY_F3)) {
+                profiler.overlayVisible = !profiler.overlayVisible;
+            } else if (isShortcutEvent(event, GLFW_KEY_S, GLFW_MOD_CONTROL)) {
+                saveMeasuringRoute(getActiveLayer(measuringState), routePath, georeference, options.compressRoute);
+            } else if (isShortcutEvent(event, GLFW_KEY_O, GLFW_MOD_CONTROL)) {
+                loadMeasuringRoute(getActiveLayer(measuringState), routePath, georeference);
+            } else if (!isWalkingMode && getActiveLayer(measuringState).visible &&
+                       (isShortcutEvent(event, GLFW_KEY_Y, GLFW_MOD_CONTROL) ||
+                        isShortcutEvent(event, GLFW_KEY_Z, GLFW_MOD_CONTROL | GLFW_MOD_SHIFT))) {
+                redoMeasuringEdit(getActiveLayer(measuringState), georeference);
+            } else if (!isWalkingMode && getActiveLayer(measuringState).visible &&
+                       isShortcutEvent(event, GLFW_KEY_Z, GLFW_MOD_CONTROL)) {
+                undoMeasuringEdit(getActiveLayer(measuringState), georeference);
+            } else if (!isWalkingMode && isPressEvent(event, InputEventType::Key, GLFW_KEY_P)) {
+                measuringState.areaMode = !measuringState.areaMode;
+            } else if (!isWalkingMode && isPressEvent(event, InputEventType::Key, GLFW_KEY_G)) {
+                toggleRoadRouting(measuringState, roadHierarchy, roadQuery, roadHierarchyPath,
+                                  bgImage.width, bgImage.height);
+            } else if (!isWalkingMode && isPressEvent(event, InputEventType::Key, GLFW_KEY_N)) {
+                addMeasuringLayer(measuringState, mapGeodesic, VBO, EBO);
+                reportActiveLayer(measuringState);
+            } else if (!isWalkingMode && isPressEvent(event, InputEventType::Key, GLFW_KEY_L)) {
+                cycleMeasuringLayer(measuringState);
+            } else if (!isWalkingMode && isPressEvent(event, InputEventType::Key, GLFW_KEY_H)) {
+                toggleMeasuringLayer(measuringState);
+            } else if (isModeSwitchEvent(event, isWalkingMode, screenWidth, screenHeight,
+                                         walkingModeIndicator, measuringModeIndicator)) {
+                TRACE_SCOPE("mode switch", "loop");
+                performModeSwitch(isWalkingMode, walkingState, measuringState,
+                                  mapPosX, mapPosY, totalDistanceWalked);
+            } else if (!isWalkingMode && getActiveLayer(measuringState).visible && isMeasuringClickEvent(event)) {
+                handleMeasuringModeClick(getActiveLayer(measuringState), measuringState.roadRouting ? &roadQuery : nullptr,
+                                         event.x, event.y, (event.mods & GLFW_MOD_SHIFT) != 0,
+                                         screenWidth, screenHeight, georeference);
+            }
+        }
+        if (const size_t dropped = inputQueue.takeDroppedCount()) {
+            std::cout << "Red ulaznih dogadjaja je bio pun, odbaceno " << dropped << " dogadjaja." << std::endl;
+        }
+
+        const double currentTime = getDisplayTime(display);
+        if (isWalkingMode) {
+            advanceWalking(inputState, currentTime - simulationTime, MAP_SPEED, mapPosToPin, mapGeodesic,
+                           mapPosX, mapPosY, totalDistanceWalked);
+        }
+        simulationTime = std::max(simulationTime, currentTime);
+        endTraceSlice("input", "loop");
+
+        beginTraceSlice("render", "loop");
+        setAllocationScope(AllocationScope::Render);
+        beginProfilerFrame(profiler);
+
+        // Render current mode, the scene optionally at a reduced resolution
+        beginProfilerPass(profiler, ProfilePass::Map);
+        if (options.dynamicResolution) {
+            bindSceneTarget(sceneTarget, framebufferWidth, framebufferHeight);
+        } else {
+            glBindFramebuffer(GL_FRAMEBUFFER, getDisplayFramebuffer(display));
+            glViewport(0, 0, framebufferWidth, framebufferHeight);
+            glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        }
+
+        if (isWalkingMode) {
+            renderWalkingMap(shaderProgram, VAO, bgImage, mapPosX, mapPosY, MAP_SCALE);
+        } else {
+            renderMeasuringMap(shaderProgram, VAO, bgImage, FULLSCREEN_SCALE);
+        }
+        endProfilerPass(profiler);
+
+        beginProfilerPass(profiler, ProfilePass::Overlay);
+        if (isWalkingMode) {
+            renderWalkingOverlay(shaderProgram, VAO, pinImage);
+        } else {
+            // The measuring view spans map space [-1, 1] over the framebuffer
+            const double metresPerPixel = std::max(std::abs(georeference.mapToMetres.a) * 2.0 / framebufferWidth,
+                                                   std::abs(georeference.mapToMetres.e) * 2.0 / framebufferHeight);
+            const auto tolerance = static_cast<float>(ROUTE_TOLERANCE_PIXELS * metresPerPixel);
+            updateMeasuringLayers(measuringState, georeference, tolerance, ROUTE_CULL_MARGIN);
+            if (measuringState.roadRouting) {
+                const float cursorMapX = static_cast<float>(cursorX) / screenWidth * 2.0f - 1.0f;
+                const float cursorMapY = 1.0f - static_cast<float>(cursorY) / screenHeight * 2.0f;
+                updateRoutePreview(measuringState.preview, getActiveLayer(measuringState), roadQuery,
+                                   cursorMapX, cursorMapY, georeference, tolerance);
+            }
+            renderMeasuringOverlay(shaderProgram, VAO, measuringState, georeference);
+        }
+        endProfilerPass(profiler);
 
-        // Handle mode switching
-        double currentTime = glfwGetTime();
-        if (shouldSwitchMode(window, isWalkingMode, currentTime, lastSwitchTime,
-                             screenWidth, screenHeight, walkingModeIndicator, measuringModeIndicator)) {
-            performModeSwitch(isWalkingMode, walkingState, measuringState,
-                              mapPosX, mapPosY, totalDistanceWalked);
-            lastSwitchTime = currentTime;
+        if (options.dynamicResolution) {
+            beginProfilerPass(profiler, ProfilePass::Resolve);
+            resolveSceneTarget(sceneTarget, getDisplayFramebuffer(display), framebufferWidth, framebufferHeight);
+            endProfilerPass(profiler);
         }
 
-        // Render current mode
+        // Render HUD at native resolution
+        beginProfilerPass(profiler, ProfilePass::Hud);
         if (isWalkingMode) {
-            renderWalkingMode(shaderProgram, VAO, bgImage, pinImage, walkingModeIndicator,
-                              digitTextures, mapPosX, mapPosY, totalDistanceWalked,
-                              window, screenWidth, screenHeight, MAP_SPEED, TARGET_FPS, MAP_SCALE);
+            renderWalkingHud(shaderProgram, VAO, frameArena, walkingModeIndicator, digitTextures,
+                             getDistance(totalDistanceWalked), screenWidth, screenHeight);
         } else {
-            renderMeasuringMode(shaderProgram, VAO, bgImage, measuringModeIndicator,
-                                digitTextures, measuringState, window, screenWidth, screenHeight,
-                                FULLSCREEN_SCALE, MAP_SCALE, leftMousePressed);
+            renderMeasuringHud(shaderProgram, VAO, frameArena, measuringModeIndicator, digitTextures,
+                               measuringState, cursorX, cursorY, screenWidth, screenHeight);
         }
+        endProfilerPass(profiler);
 
         // Render UI overlay
+        beginProfilerPass(profiler, ProfilePass::Badge);
         renderImageBottomRight(shaderProgram, VAO, cornerImage, screenWidth, screenHeight);
+        endProfilerPass(profiler);
+
+        endProfilerFrame(profiler);
+        if (collectProfiler(profiler)) {
+            if (options.dynamicResolution) {
+                updateResolutionScale(sceneTarget, resolutionPolicy, profiler.gpuTotalMs);
+            }
+            if (isBenchmark) {
+                recordBenchmarkGpuTime(benchmark, profiler.gpuTotalMs);
+            }
+            traceProfilerResults(profiler);
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // Not profiled itself, so showing the breakdown does not change it
+        if (profiler.overlayVisible) {
+            renderProfilerOverlay(shaderProgram, VAO, frameArena, digitTextures, profiler, resolutionPolicy.budgetMs,
+                                  isGlStatsInstalled() ? &glFrameStats : nullptr);
+        }
+        setAllocationScope(AllocationScope::Frame);
+        endTraceSlice("render", "loop");
+
+        getDisplayCursor(display, inputState, cursorX, cursorY);
+        latchCursor(lateLatch, cursorX, cursorY, screenWidth, screenHeight);
+        presentDisplay(display);
+        collectGlFrameStats(glFrameStats);
+        collectAllocations(frameAllocations);
+
+        if (isBenchmark) {
+            AllocationScopeGuard allocationScope(AllocationScope::Benchmark);
+            const std::chrono::duration<double, std::milli> cpuTime =
+                    std::chrono::high_resolution_clock::now() - frameStart;
+            recordBenchmarkFrame(benchmark, cpuTime.count(), glFrameStats, frameAllocations);
+        }
+
+        if (options.maxFrames > 0 && ++frameCount >= options.maxFrames) {
+            requestDisplayClose(display);
+        }
 
-        // Frame rate limiting
+        // Frame rate limiting, waiting on events instead of sleeping so they are timestamped as they arrive
+        TRACE_SCOPE("sleep", "loop");
         auto frameEnd = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> elapsed = frameEnd - frameStart;
-        if (double sleepTime = FRAME_TIME - elapsed.count(); sleepTime > 0) {
-            std::this_thread::sleep_for(std::chrono::duration<double>(sleepTime));
+        while (elapsed.count() < FRAME_TIME && display.fixedTimeStep <= 0.0) {
+            waitDisplay(display, FRAME_TIME - elapsed.count());
+            elapsed = std::chrono::high_resolution_clock::now() - frameStart;
+        }
+    }
+
+    if (options.headless && options.screenshotPath) {
+        saveHeadlessFrame(display.headless, options.screenshotPath);
+    }
+
+    if (options.tracePath) {
+        writeTrace(options.tracePath);
+    }
+
+    int exitCode = 0;
+    if (isBenchmark) {
+        benchmark.routePoints = getActiveLayer(measuringState).route.size;
+        writeBenchmarkReport(benchmark, options.reportPath);
+        if (options.baselinePath &&
+            compareWithBaseline(benchmark, options.baselinePath, options.regressionThreshold) != 0) {
+            exitCode = 1;
+        }
+
+        if (options.assertNoAllocations) {
+            if (!isAllocationTrackingEnabled()) {
+                std::cout << "--assert-no-allocations zahteva build sa KOSTUR_TRACK_ALLOCATIONS." << std::endl;
+                exitCode = 1;
+            } else if (benchmark.allocatingFrames > 0) {
+                std::cout << "Alokacije u " << benchmark.allocatingFrames << " frejmova." << std::endl;
+                exitCode = 1;
+            }
         }
     }
 
     // Cleanup
+    destroyFrameArena(frameArena);
+    destroyMeasuringLayers(measuringState);
+    destroyRouteBuffer(measuringState.preview.buffer);
+    closeContractionHierarchy(roadHierarchy);
+    destroySceneTarget(sceneTarget);
+    destroyProfiler(profiler);
+    destroyLateLatch(lateLatch);
     cleanupResources(VAO, VBO, EBO, shaderProgram, cornerImage, bgImage, pinImage,
                      walkingModeIndicator, measuringModeIndicator);
 
-    glfwDestroyWindow(window);
+    destroyDisplay(display);
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
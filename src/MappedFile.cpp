@@ -0,0 +1,100 @@
+#include "../Header/MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    bool reportOpenError(MappedFile &mapped, const char *path) {
+        std::cout << "Greska pri citanju fajla sa putanje \"" << path << "\"!" << std::endl;
+        closeMappedFile(mapped);
+        return false;
+    }
+}
+
+#ifdef _WIN32
+bool openMappedFile(MappedFile &mapped, const char *path) {
+    mapped.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (mapped.file == INVALID_HANDLE_VALUE) {
+        mapped.file = nullptr;
+        return reportOpenError(mapped, path);
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mapped.file, &size)) {
+        return reportOpenError(mapped, path);
+    }
+    mapped.size = static_cast<size_t>(size.QuadPart);
+    if (mapped.size == 0) {
+        return true;
+    }
+
+    mapped.mapping = CreateFileMappingA(mapped.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapped.mapping) {
+        return reportOpenError(mapped, path);
+    }
+    mapped.data = static_cast<const char *>(MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mapped.data) {
+        return reportOpenError(mapped, path);
+    }
+    return true;
+}
+
+void closeMappedFile(MappedFile &mapped) {
+    if (mapped.data) {
+        UnmapViewOfFile(mapped.data);
+    }
+    if (mapped.mapping) {
+        CloseHandle(mapped.mapping);
+    }
+    if (mapped.file) {
+        CloseHandle(mapped.file);
+    }
+    mapped = MappedFile{};
+}
+#else
+bool openMappedFile(MappedFile &mapped, const char *path) {
+    mapped.descriptor = open(path, O_RDONLY);
+    if (mapped.descriptor < 0) {
+        return reportOpenError(mapped, path);
+    }
+
+    struct stat status{};
+    if (fstat(mapped.descriptor, &status) != 0) {
+        return reportOpenError(mapped, path);
+    }
+    mapped.size = static_cast<size_t>(status.st_size);
+    if (mapped.size == 0) {
+        return true;
+    }
+
+    void *data = mmap(nullptr, mapped.size, PROT_READ, MAP_PRIVATE, mapped.descriptor, 0);
+    if (data == MAP_FAILED) {
+        return reportOpenError(mapped, path);
+    }
+    // Parsed front to back, readahead can be aggressive
+    madvise(data, mapped.size, MADV_SEQUENTIAL);
+    mapped.data = static_cast<const char *>(data);
+    return true;
+}
+
+void closeMappedFile(MappedFile &mapped) {
+    if (mapped.data) {
+        munmap(const_cast<char *>(mapped.data), mapped.size);
+    }
+    if (mapped.descriptor >= 0) {
+        close(mapped.descriptor);
+    }
+    mapped = MappedFile{};
+}
+#endif
@@ -0,0 +1,60 @@
+#include "../Header/Options.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+AppOptions parseOptions(const int argc, char **argv) {
+    AppOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--dynamic-resolution") == 0) {
+            options.dynamicResolution = true;
+        } else if (std::strcmp(arg, "--frame-budget") == 0 && hasValue) {
+            options.frameBudgetMs = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--headless") == 0) {
+            options.headless = true;
+            // Optional WIDTHxHEIGHT right after the flag
+            if (hasValue && std::sscanf(argv[i + 1], "%dx%d", &options.headlessWidth, &options.headlessHeight) == 2) {
+                ++i;
+            }
+        } else if (std::strcmp(arg, "--frames") == 0 && hasValue) {
+            options.maxFrames = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--screenshot") == 0 && hasValue) {
+            options.screenshotPath = argv[++i];
+        } else if (std::strcmp(arg, "--benchmark") == 0 && hasValue) {
+            options.benchmarkPath = argv[++i];
+            options.headless = true;
+        } else if (std::strcmp(arg, "--report") == 0 && hasValue) {
+            options.reportPath = argv[++i];
+        } else if (std::strcmp(arg, "--baseline") == 0 && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (std::strcmp(arg, "--threshold") == 0 && hasValue) {
+            options.regressionThreshold = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--warmup") == 0 && hasValue) {
+            options.warmupFrames = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--assert-no-allocations") == 0) {
+            options.assertNoAllocations = true;
+        } else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else if (std::strcmp(arg, "--gl-stats") == 0) {
+            options.glStats = true;
+        } else if (std::strcmp(arg, "--track") == 0 && hasValue) {
+            options.trackPath = argv[++i];
+        } else if (std::strcmp(arg, "--route") == 0 && hasValue) {
+            options.routePath = argv[++i];
+        } else if (std::strcmp(arg, "--compress-route") == 0) {
+            options.compressRoute = true;
+        } else if (std::strcmp(arg, "--hierarchy") == 0 && hasValue) {
+            options.hierarchyPath = argv[++i];
+        } else {
+            std::cout << "Nepoznata opcija: " << arg << std::endl;
+        }
+    }
+
+    return options;
+}
@@ -0,0 +1,556 @@
+#include "../Header/PointKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KOSTUR_SSE2_KERNELS
+#endif
+// GCC and Clang compile the AVX2 versions per function and check the CPU at run time,
+// MSVC only when the whole build targets AVX2
+#if defined(__GNUC__)
+#define KOSTUR_AVX2_KERNELS
+#define KOSTUR_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define KOSTUR_AVX2_KERNELS
+#define KOSTUR_AVX2_TARGET
+#endif
+#endif
+
+namespace {
+    // Segment lengths for accumulateDistances are produced in chunks of this many
+    constexpr size_t DISTANCE_CHUNK = 256;
+
+    // Lane indices are 32-bit, longer arrays are searched in slices
+    constexpr size_t NEAREST_SLICE = size_t(1) << 30;
+
+    struct KernelTable {
+        double (*sumSegmentLengths)(const float *, const float *, size_t);
+        void (*computeSegmentLengths)(const float *, const float *, size_t, float *);
+        int64_t (*findNearestPoint)(const float *, const float *, size_t, float, float, float &);
+        void (*expandBounds)(const float *, const float *, size_t, PointBounds &);
+        void (*transformPoints)(const float *, const float *, size_t, const PointTransform &, float *, float *);
+        void (*computeChordLengths)(const double *, const double *, const double *, size_t, double *);
+    };
+
+    float segmentLength(const float *xs, const float *ys, const size_t i) {
+        const float dx = xs[i + 1] - xs[i];
+        const float dy = ys[i + 1] - ys[i];
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    // ========================================================================
+    // SCALAR
+    // ========================================================================
+    double sumSegmentLengthsScalar(const float *xs, const float *ys, const size_t count) {
+        double sum = 0.0;
+        for (size_t i = 0; i + 1 < count; ++i) {
+            sum += segmentLength(xs, ys, i);
+        }
+        return sum;
+    }
+
+    void computeSegmentLengthsScalar(const float *xs, const float *ys, const size_t count, float *lengths) {
+        for (size_t i = 0; i + 1 < count; ++i) {
+            lengths[i] = segmentLength(xs, ys, i);
+        }
+    }
+
+    int64_t findNearestPointScalar(const float *xs, const float *ys, const size_t count, const float x, const float y,
+                                   float &distanceSquared) {
+        int64_t nearest = -1;
+        distanceSquared = std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < count; ++i) {
+            const float dx = xs[i] - x;
+            const float dy = ys[i] - y;
+            const float distance = dx * dx + dy * dy;
+            if (distance < distanceSquared) {
+                distanceSquared = distance;
+                nearest = static_cast<int64_t>(i);
+            }
+        }
+        return nearest;
+    }
+
+    void expandBoundsScalar(const float *xs, const float *ys, const size_t count, PointBounds &bounds) {
+        for (size_t i = 0; i < count; ++i) {
+            bounds.minX = std::min(bounds.minX, xs[i]);
+            bounds.maxX = std::max(bounds.maxX, xs[i]);
+            bounds.minY = std::min(bounds.minY, ys[i]);
+            bounds.maxY = std::max(bounds.maxY, ys[i]);
+        }
+    }
+
+    void transformPointsScalar(const float *xs, const float *ys, const size_t count, const PointTransform &t,
+                               float *outXs, float *outYs) {
+        for (size_t i = 0; i < count; ++i) {
+            const float x = xs[i];
+            const float y = ys[i];
+            outXs[i] = t.a * x + t.b * y + t.c;
+            outYs[i] = t.d * x + t.e * y + t.f;
+        }
+    }
+
+    void computeChordLengthsScalar(const double *xs, const double *ys, const double *zs, const size_t count,
+                                   double *lengths) {
+        for (size_t i = 0; i + 1 < count; ++i) {
+            const double dx = xs[i + 1] - xs[i];
+            const double dy = ys[i + 1] - ys[i];
+            const double dz = zs[i + 1] - zs[i];
+            lengths[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    }
+
+    constexpr KernelTable SCALAR_KERNELS = {
+        sumSegmentLengthsScalar, computeSegmentLengthsScalar, findNearestPointScalar, expandBoundsScalar,
+        transformPointsScalar, computeChordLengthsScalar
+    };
+
+#if defined(KOSTUR_SSE2_KERNELS) || defined(KOSTUR_AVX2_KERNELS)
+    // Lane results of the vector searches are reduced in index order, so ties resolve like the scalar loop
+    int64_t reduceNearest(const float *laneDistances, const int32_t *laneIndices, const size_t lanes,
+                          float &distanceSquared) {
+        int64_t nearest = -1;
+        distanceSquared = std::numeric_limits<float>::infinity();
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            if (laneIndices[lane] < 0) {
+                continue;
+            }
+            if (laneDistances[lane] < distanceSquared ||
+                (laneDistances[lane] == distanceSquared && laneIndices[lane] < nearest)) {
+                distanceSquared = laneDistances[lane];
+                nearest = laneIndices[lane];
+            }
+        }
+        return nearest;
+    }
+
+    // Splits long arrays into slices the 32-bit lane indices can address
+    template <typename SliceSearch>
+    int64_t findNearestSliced(const float *xs, const float *ys, const size_t count, const float x, const float y,
+                              float &distanceSquared, SliceSearch search) {
+        int64_t nearest = -1;
+        distanceSquared = std::numeric_limits<float>::infinity();
+        for (size_t base = 0; base < count; base += NEAREST_SLICE) {
+            float sliceDistance;
+            const int64_t slice = search(xs + base, ys + base, std::min(NEAREST_SLICE, count - base), x, y,
+                                         sliceDistance);
+            if (slice >= 0 && sliceDistance < distanceSquared) {
+                distanceSquared = sliceDistance;
+                nearest = static_cast<int64_t>(base) + slice;
+            }
+        }
+        return nearest;
+    }
+#endif
+
+    // ========================================================================
+    // SSE2
+    // ========================================================================
+#ifdef KOSTUR_SSE2_KERNELS
+    __m128 segmentLengths4(const float *xs, const float *ys, const size_t i) {
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i + 1), _mm_loadu_ps(xs + i));
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i + 1), _mm_loadu_ps(ys + i));
+        return _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+    }
+
+    double sumSegmentLengthsSse2(const float *xs, const float *ys, const size_t count) {
+        __m128d low = _mm_setzero_pd();
+        __m128d high = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 < count; i += 4) {
+            const __m128 lengths = segmentLengths4(xs, ys, i);
+            low = _mm_add_pd(low, _mm_cvtps_pd(lengths));
+            high = _mm_add_pd(high, _mm_cvtps_pd(_mm_movehl_ps(lengths, lengths)));
+        }
+
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+        double sum = lanes[0] + lanes[1];
+        for (; i + 1 < count; ++i) {
+            sum += segmentLength(xs, ys, i);
+        }
+        return sum;
+    }
+
+    void computeSegmentLengthsSse2(const float *xs, const float *ys, const size_t count, float *lengths) {
+        size_t i = 0;
+        for (; i + 4 < count; i += 4) {
+            _mm_storeu_ps(lengths + i, segmentLengths4(xs, ys, i));
+        }
+        computeSegmentLengthsScalar(xs + i, ys + i, count - i, lengths + i);
+    }
+
+    int64_t findNearestSliceSse2(const float *xs, const float *ys, const size_t count, const float x, const float y,
+                                 float &distanceSquared) {
+        const __m128 px = _mm_set1_ps(x);
+        const __m128 py = _mm_set1_ps(y);
+        __m128 best = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        __m128i bestIndex = _mm_set1_epi32(-1);
+        __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i step = _mm_set1_epi32(4);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), px);
+            const __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), py);
+            const __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+            // No blend in SSE2, select with and/andnot/or
+            const __m128 closer = _mm_cmplt_ps(distance, best);
+            best = _mm_or_ps(_mm_and_ps(closer, distance), _mm_andnot_ps(closer, best));
+            const __m128i closerIndex = _mm_castps_si128(closer);
+            bestIndex = _mm_or_si128(_mm_and_si128(closerIndex, index), _mm_andnot_si128(closerIndex, bestIndex));
+            index = _mm_add_epi32(index, step);
+        }
+
+        float laneDistances[4];
+        int32_t laneIndices[4];
+        _mm_storeu_ps(laneDistances, best);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(laneIndices), bestIndex);
+        int64_t nearest = reduceNearest(laneDistances, laneIndices, 4, distanceSquared);
+
+        float tailDistance;
+        const int64_t tail = findNearestPointScalar(xs + i, ys + i, count - i, x, y, tailDistance);
+        if (tail >= 0 && tailDistance < distanceSquared) {
+            distanceSquared = tailDistance;
+            nearest = static_cast<int64_t>(i) + tail;
+        }
+        return nearest;
+    }
+
+    int64_t findNearestPointSse2(const float *xs, const float *ys, const size_t count, const float x, const float y,
+                                 float &distanceSquared) {
+        return findNearestSliced(xs, ys, count, x, y, distanceSquared, findNearestSliceSse2);
+    }
+
+    void expandBoundsSse2(const float *xs, const float *ys, const size_t count, PointBounds &bounds) {
+        __m128 minX = _mm_set1_ps(bounds.minX);
+        __m128 maxX = _mm_set1_ps(bounds.maxX);
+        __m128 minY = _mm_set1_ps(bounds.minY);
+        __m128 maxY = _mm_set1_ps(bounds.maxY);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 x = _mm_loadu_ps(xs + i);
+            const __m128 y = _mm_loadu_ps(ys + i);
+            minX = _mm_min_ps(minX, x);
+            maxX = _mm_max_ps(maxX, x);
+            minY = _mm_min_ps(minY, y);
+            maxY = _mm_max_ps(maxY, y);
+        }
+
+        float lanes[4][4];
+        _mm_storeu_ps(lanes[0], minX);
+        _mm_storeu_ps(lanes[1], maxX);
+        _mm_storeu_ps(lanes[2], minY);
+        _mm_storeu_ps(lanes[3], maxY);
+        for (int lane = 0; lane < 4; ++lane) {
+            bounds.minX = std::min(bounds.minX, lanes[0][lane]);
+            bounds.maxX = std::max(bounds.maxX, lanes[1][lane]);
+            bounds.minY = std::min(bounds.minY, lanes[2][lane]);
+            bounds.maxY = std::max(bounds.maxY, lanes[3][lane]);
+        }
+        expandBoundsScalar(xs + i, ys + i, count - i, bounds);
+    }
+
+    void transformPointsSse2(const float *xs, const float *ys, const size_t count, const PointTransform &t,
+                             float *outXs, float *outYs) {
+        const __m128 a = _mm_set1_ps(t.a), b = _mm_set1_ps(t.b), c = _mm_set1_ps(t.c);
+        const __m128 d = _mm_set1_ps(t.d), e = _mm_set1_ps(t.e), f = _mm_set1_ps(t.f);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 x = _mm_loadu_ps(xs + i);
+            const __m128 y = _mm_loadu_ps(ys + i);
+            _mm_storeu_ps(outXs + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)), c));
+            _mm_storeu_ps(outYs + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(d, x), _mm_mul_ps(e, y)), f));
+        }
+        transformPointsScalar(xs + i, ys + i, count - i, t, outXs + i, outYs + i);
+    }
+
+    void computeChordLengthsSse2(const double *xs, const double *ys, const double *zs, const size_t count,
+                                 double *lengths) {
+        size_t i = 0;
+        for (; i + 2 < count; i += 2) {
+            const __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + i + 1), _mm_loadu_pd(xs + i));
+            const __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + i + 1), _mm_loadu_pd(ys + i));
+            const __m128d dz = _mm_sub_pd(_mm_loadu_pd(zs + i + 1), _mm_loadu_pd(zs + i));
+            const __m128d squared = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+            _mm_storeu_pd(lengths + i, _mm_sqrt_pd(squared));
+        }
+        computeChordLengthsScalar(xs + i, ys + i, zs + i, count - i, lengths + i);
+    }
+
+    constexpr KernelTable SSE2_KERNELS = {
+        sumSegmentLengthsSse2, computeSegmentLengthsSse2, findNearestPointSse2, expandBoundsSse2,
+        transformPointsSse2, computeChordLengthsSse2
+    };
+#endif
+
+    // ========================================================================
+    // AVX2
+    // ========================================================================
+    // Every kernel clears the upper register halves before its scalar tail. GCC
+    // does not when the tail is a sibling call, and SSE code running with dirty
+    // upper halves, libm included, is several times slower until the next clear.
+#ifdef KOSTUR_AVX2_KERNELS
+    KOSTUR_AVX2_TARGET __m256 segmentLengths8(const float *xs, const float *ys, const size_t i) {
+        const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i + 1), _mm256_loadu_ps(xs + i));
+        const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i + 1), _mm256_loadu_ps(ys + i));
+        return _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+    }
+
+    KOSTUR_AVX2_TARGET double sumSegmentLengthsAvx2(const float *xs, const float *ys, const size_t count) {
+        __m256d low = _mm256_setzero_pd();
+        __m256d high = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 < count; i += 8) {
+            const __m256 lengths = segmentLengths8(xs, ys, i);
+            low = _mm256_add_pd(low, _mm256_cvtps_pd(_mm256_castps256_ps128(lengths)));
+            high = _mm256_add_pd(high, _mm256_cvtps_pd(_mm256_extractf128_ps(lengths, 1)));
+        }
+
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(low, high));
+        _mm256_zeroupper();
+        double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i + 1 < count; ++i) {
+            sum += segmentLength(xs, ys, i);
+        }
+        return sum;
+    }
+
+    KOSTUR_AVX2_TARGET void computeSegmentLengthsAvx2(const float *xs, const float *ys, const size_t count,
+                                                      float *lengths) {
+        size_t i = 0;
+        for (; i + 8 < count; i += 8) {
+            _mm256_storeu_ps(lengths + i, segmentLengths8(xs, ys, i));
+        }
+        _mm256_zeroupper();
+        computeSegmentLengthsScalar(xs + i, ys + i, count - i, lengths + i);
+    }
+
+    KOSTUR_AVX2_TARGET int64_t findNearestSliceAvx2(const float *xs, const float *ys, const size_t count,
+                                                    const float x, const float y, float &distanceSquared) {
+        const __m256 px = _mm256_set1_ps(x);
+        const __m256 py = _mm256_set1_ps(y);
+        __m256 best = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        __m256i bestIndex = _mm256_set1_epi32(-1);
+        __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i step = _mm256_set1_epi32(8);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), px);
+            const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), py);
+            const __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+
+            const __m256 closer = _mm256_cmp_ps(distance, best, _CMP_LT_OQ);
+            best = _mm256_blendv_ps(best, distance, closer);
+            bestIndex = _mm256_blendv_epi8(bestIndex, index, _mm256_castps_si256(closer));
+            index = _mm256_add_epi32(index, step);
+        }
+
+        float laneDistances[8];
+        int32_t laneIndices[8];
+        _mm256_storeu_ps(laneDistances, best);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(laneIndices), bestIndex);
+        _mm256_zeroupper();
+        int64_t nearest = reduceNearest(laneDistances, laneIndices, 8, distanceSquared);
+
+        float tailDistance;
+        const int64_t tail = findNearestPointScalar(xs + i, ys + i, count - i, x, y, tailDistance);
+        if (tail >= 0 && tailDistance < distanceSquared) {
+            distanceSquared = tailDistance;
+            nearest = static_cast<int64_t>(i) + tail;
+        }
+        return nearest;
+    }
+
+    int64_t findNearestPointAvx2(const float *xs, const float *ys, const size_t count, const float x, const float y,
+                                 float &distanceSquared) {
+        return findNearestSliced(xs, ys, count, x, y, distanceSquared, findNearestSliceAvx2);
+    }
+
+    KOSTUR_AVX2_TARGET void expandBoundsAvx2(const float *xs, const float *ys, const size_t count,
+                                             PointBounds &bounds) {
+        __m256 minX = _mm256_set1_ps(bounds.minX);
+        __m256 maxX = _mm256_set1_ps(bounds.maxX);
+        __m256 minY = _mm256_set1_ps(bounds.minY);
+        __m256 maxY = _mm256_set1_ps(bounds.maxY);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 x = _mm256_loadu_ps(xs + i);
+            const __m256 y = _mm256_loadu_ps(ys + i);
+            minX = _mm256_min_ps(minX, x);
+            maxX = _mm256_max_ps(maxX, x);
+            minY = _mm256_min_ps(minY, y);
+            maxY = _mm256_max_ps(maxY, y);
+        }
+
+        float lanes[4][8];
+        _mm256_storeu_ps(lanes[0], minX);
+        _mm256_storeu_ps(lanes[1], maxX);
+        _mm256_storeu_ps(lanes[2], minY);
+        _mm256_storeu_ps(lanes[3], maxY);
+        _mm256_zeroupper();
+        for (int lane = 0; lane < 8; ++lane) {
+            bounds.minX = std::min(bounds.minX, lanes[0][lane]);
+            bounds.maxX = std::max(bounds.maxX, lanes[1][lane]);
+            bounds.minY = std::min(bounds.minY, lanes[2][lane]);
+            bounds.maxY = std::max(bounds.maxY, lanes[3][lane]);
+        }
+        expandBoundsScalar(xs + i, ys + i, count - i, bounds);
+    }
+
+    KOSTUR_AVX2_TARGET void transformPointsAvx2(const float *xs, const float *ys, const size_t count,
+                                                const PointTransform &t, float *outXs, float *outYs) {
+        const __m256 a = _mm256_set1_ps(t.a), b = _mm256_set1_ps(t.b), c = _mm256_set1_ps(t.c);
+        const __m256 d = _mm256_set1_ps(t.d), e = _mm256_set1_ps(t.e), f = _mm256_set1_ps(t.f);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 x = _mm256_loadu_ps(xs + i);
+            const __m256 y = _mm256_loadu_ps(ys + i);
+            _mm256_storeu_ps(outXs + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, x), _mm256_mul_ps(b, y)), c));
+            _mm256_storeu_ps(outYs + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d, x), _mm256_mul_ps(e, y)), f));
+        }
+        _mm256_zeroupper();
+        transformPointsScalar(xs + i, ys + i, count - i, t, outXs + i, outYs + i);
+    }
+
+    KOSTUR_AVX2_TARGET void computeChordLengthsAvx2(const double *xs, const double *ys, const double *zs,
+                                                    const size_t count, double *lengths) {
+        size_t i = 0;
+        for (; i + 4 < count; i += 4) {
+            const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i + 1), _mm256_loadu_pd(xs + i));
+            const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i + 1), _mm256_loadu_pd(ys + i));
+            const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(zs + i + 1), _mm256_loadu_pd(zs + i));
+            const __m256d squared = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                                  _mm256_mul_pd(dz, dz));
+            _mm256_storeu_pd(lengths + i, _mm256_sqrt_pd(squared));
+        }
+        _mm256_zeroupper();
+        computeChordLengthsScalar(xs + i, ys + i, zs + i, count - i, lengths + i);
+    }
+
+    constexpr KernelTable AVX2_KERNELS = {
+        sumSegmentLengthsAvx2, computeSegmentLengthsAvx2, findNearestPointAvx2, expandBoundsAvx2,
+        transformPointsAvx2, computeChordLengthsAvx2
+    };
+#endif
+
+    // ========================================================================
+    // DISPATCH
+    // ========================================================================
+    PointKernelLevel detectLevel() {
+#if defined(KOSTUR_AVX2_KERNELS) && defined(__GNUC__)
+        if (__builtin_cpu_supports("avx2")) {
+            return PointKernelLevel::Avx2;
+        }
+#elif defined(KOSTUR_AVX2_KERNELS)
+        return PointKernelLevel::Avx2;
+#endif
+#ifdef KOSTUR_SSE2_KERNELS
+        return PointKernelLevel::Sse2;
+#else
+        return PointKernelLevel::Scalar;
+#endif
+    }
+
+    const KernelTable *tableFor(const PointKernelLevel level) {
+        switch (level) {
+#ifdef KOSTUR_AVX2_KERNELS
+            case PointKernelLevel::Avx2:
+                return &AVX2_KERNELS;
+#endif
+#ifdef KOSTUR_SSE2_KERNELS
+            case PointKernelLevel::Sse2:
+                return &SSE2_KERNELS;
+#endif
+            default:
+                return &SCALAR_KERNELS;
+        }
+    }
+
+    const PointKernelLevel supportedLevel = detectLevel();
+    std::atomic<PointKernelLevel> currentLevel{supportedLevel};
+    std::atomic<const KernelTable *> kernels{tableFor(supportedLevel)};
+}
+
+PointKernelLevel getPointKernelLevel() {
+    return currentLevel.load(std::memory_order_relaxed);
+}
+
+void setPointKernelLevel(const PointKernelLevel level) {
+    const PointKernelLevel clamped = std::min(level, supportedLevel);
+    currentLevel.store(clamped, std::memory_order_relaxed);
+    kernels.store(tableFor(clamped), std::memory_order_relaxed);
+}
+
+const char *getPointKernelName(const PointKernelLevel level) {
+    switch (level) {
+        case PointKernelLevel::Avx2:
+            return "avx2";
+        case PointKernelLevel::Sse2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+double sumSegmentLengths(const float *xs, const float *ys, const size_t count) {
+    return kernels.load(std::memory_order_relaxed)->sumSegmentLengths(xs, ys, count);
+}
+
+void computeSegmentLengths(const float *xs, const float *ys, const size_t count, float *lengths) {
+    kernels.load(std::memory_order_relaxed)->computeSegmentLengths(xs, ys, count, lengths);
+}
+
+double accumulateDistances(const float *xs, const float *ys, const size_t count, double start, double *distances) {
+    if (count == 0) {
+        return start;
+    }
+
+    // Lengths come from the vector kernel a chunk at a time, the running sum itself is serial
+    float lengths[DISTANCE_CHUNK];
+    distances[0] = start;
+    for (size_t first = 0; first + 1 < count; first += DISTANCE_CHUNK) {
+        const size_t points = std::min(DISTANCE_CHUNK + 1, count - first);
+        computeSegmentLengths(xs + first, ys + first, points, lengths);
+        for (size_t i = 0; i + 1 < points; ++i) {
+            start += lengths[i];
+            distances[first + i + 1] = start;
+        }
+    }
+    return start;
+}
+
+int64_t findNearestPoint(const float *xs, const float *ys, const size_t count, const float x, const float y,
+                         float &distanceSquared) {
+    return kernels.load(std::memory_order_relaxed)->findNearestPoint(xs, ys, count, x, y, distanceSquared);
+}
+
+void transformPoints(const float *xs, const float *ys, const size_t count, const PointTransform &transform,
+                     float *outXs, float *outYs) {
+    kernels.load(std::memory_order_relaxed)->transformPoints(xs, ys, count, transform, outXs, outYs);
+}
+
+void computeChordLengths(const double *xs, const double *ys, const double *zs, const size_t count, double *lengths) {
+    kernels.load(std::memory_order_relaxed)->computeChordLengths(xs, ys, zs, count, lengths);
+}
+
+PointBounds emptyBounds() {
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+    return {infinity, infinity, -infinity, -infinity};
+}
+
+void expandBounds(const float *xs, const float *ys, const size_t count, PointBounds &bounds) {
+    kernels.load(std::memory_order_relaxed)->expandBounds(xs, ys, count, bounds);
+}
@@ -0,0 +1,168 @@
+#include "../Header/Profiler.h"
+#include "../Header/Trace.h"
+
+namespace {
+    bool isFrameAvailable(const ProfilerFrame &frame) {
+        for (int pass = 0; pass < PROFILE_PASS_COUNT; ++pass) {
+            if (!frame.used[pass]) {
+                continue;
+            }
+
+            GLint available = 0;
+            glGetQueryObjectiv(frame.queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void publishFrame(Profiler &profiler, ProfilerFrame &frame) {
+        profiler.gpuTotalMs = 0.0;
+        profiler.cpuTotalMs = 0.0;
+
+        for (int pass = 0; pass < PROFILE_PASS_COUNT; ++pass) {
+            GLuint64 elapsedNs = 0;
+            if (frame.used[pass]) {
+                glGetQueryObjectui64v(frame.queries[pass], GL_QUERY_RESULT, &elapsedNs);
+            }
+
+            profiler.gpuMs[pass] = static_cast<double>(elapsedNs) / 1.0e6;
+            profiler.cpuMs[pass] = frame.cpuMs[pass];
+            profiler.gpuTotalMs += profiler.gpuMs[pass];
+            profiler.cpuTotalMs += profiler.cpuMs[pass];
+        }
+
+        frame.pending = false;
+        profiler.hasNewResult = true;
+    }
+
+    // Oldest frame first (the one after the most recently submitted), stop at the first
+    // one that is not ready to keep results in order
+    void readAvailableFrames(Profiler &profiler) {
+        for (int i = 1; i <= Profiler::RING_SIZE; ++i) {
+            ProfilerFrame &frame = profiler.frames[(profiler.current + i) % Profiler::RING_SIZE];
+            if (!frame.pending) {
+                continue;
+            }
+            if (!isFrameAvailable(frame)) {
+                break;
+            }
+            publishFrame(profiler, frame);
+        }
+    }
+}
+
+static GlSubsystem getPassSubsystem(const ProfilePass pass) {
+    switch (pass) {
+        case ProfilePass::Map: return GlSubsystem::Map;
+        case ProfilePass::Overlay: return GlSubsystem::Overlay;
+        case ProfilePass::Resolve: return GlSubsystem::Resolve;
+        case ProfilePass::Hud: return GlSubsystem::Hud;
+        case ProfilePass::Badge: return GlSubsystem::Badge;
+        default: return GlSubsystem::Other;
+    }
+}
+
+const char *getProfilePassName(const ProfilePass pass) {
+    switch (pass) {
+        case ProfilePass::Map: return "map";
+        case ProfilePass::Overlay: return "overlay";
+        case ProfilePass::Resolve: return "resolve";
+        case ProfilePass::Hud: return "hud";
+        case ProfilePass::Badge: return "badge";
+        default: return "unknown";
+    }
+}
+
+void createProfiler(Profiler &profiler) {
+    for (ProfilerFrame &frame: profiler.frames) {
+        glGenQueries(PROFILE_PASS_COUNT, frame.queries);
+    }
+}
+
+void destroyProfiler(Profiler &profiler) {
+    for (ProfilerFrame &frame: profiler.frames) {
+        glDeleteQueries(PROFILE_PASS_COUNT, frame.queries);
+    }
+}
+
+void beginProfilerFrame(Profiler &profiler) {
+    readAvailableFrames(profiler);
+    profiler.current = (profiler.current + 1) % Profiler::RING_SIZE;
+
+    ProfilerFrame &frame = profiler.frames[profiler.current];
+    profiler.frameActive = !frame.pending;
+    if (!profiler.frameActive) {
+        return;
+    }
+
+    for (int pass = 0; pass < PROFILE_PASS_COUNT; ++pass) {
+        frame.used[pass] = false;
+        frame.cpuMs[pass] = 0.0;
+    }
+}
+
+void endProfilerFrame(Profiler &profiler) {
+    if (profiler.frameActive) {
+        profiler.frames[profiler.current].pending = true;
+        profiler.frameActive = false;
+    }
+}
+
+void beginProfilerPass(Profiler &profiler, const ProfilePass pass) {
+    beginTraceSlice(getProfilePassName(pass), "render");
+    profiler.tracedPass = static_cast<int>(pass);
+    profiler.previousGlSubsystem = setGlSubsystem(getPassSubsystem(pass));
+
+    if (!profiler.frameActive) {
+        return;
+    }
+
+    const int index = static_cast<int>(pass);
+    ProfilerFrame &frame = profiler.frames[profiler.current];
+    glBeginQuery(GL_TIME_ELAPSED, frame.queries[index]);
+    frame.used[index] = true;
+
+    profiler.activePass = index;
+    profiler.passStart = std::chrono::high_resolution_clock::now();
+}
+
+void endProfilerPass(Profiler &profiler) {
+    if (profiler.tracedPass >= 0) {
+        endTraceSlice(getProfilePassName(static_cast<ProfilePass>(profiler.tracedPass)), "render");
+        profiler.tracedPass = -1;
+        setGlSubsystem(profiler.previousGlSubsystem);
+    }
+
+    if (!profiler.frameActive || profiler.activePass < 0) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+
+    const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::high_resolution_clock::now() - profiler.passStart;
+    profiler.frames[profiler.current].cpuMs[profiler.activePass] += elapsed.count();
+    profiler.activePass = -1;
+}
+
+bool collectProfiler(Profiler &profiler) {
+    readAvailableFrames(profiler);
+
+    const bool updated = profiler.hasNewResult;
+    profiler.hasNewResult = false;
+    return updated;
+}
+
+void traceProfilerResults(const Profiler &profiler) {
+    // Counter tracks are keyed by name, so these must differ from the CPU slice names
+    static const char *const COUNTER_NAMES[PROFILE_PASS_COUNT] = {
+        "gpu map", "gpu overlay", "gpu resolve", "gpu hud", "gpu badge"
+    };
+
+    for (int pass = 0; pass < PROFILE_PASS_COUNT; ++pass) {
+        recordTraceCounter(COUNTER_NAMES[pass], "gpu", profiler.gpuMs[pass]);
+    }
+    recordTraceCounter("gpu frame", "gpu", profiler.gpuTotalMs);
+}
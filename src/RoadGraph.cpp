@@ -0,0 +1,811 @@
+#include "../Header/RoadGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "../Header/MappedFile.h"
+#include "../Header/PointKernels.h"
+#include "stb_image.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KOSTUR_SSE2_KERNELS
+#endif
+// Same per-function AVX2 targeting as PointKernels
+#if defined(__GNUC__)
+#define KOSTUR_AVX2_KERNELS
+#define KOSTUR_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define KOSTUR_AVX2_KERNELS
+#define KOSTUR_AVX2_TARGET
+#endif
+#endif
+
+namespace {
+    constexpr char MAGIC[4] = {'K', 'R', 'G', 'F'};
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t HEADER_SIZE = 32;
+    constexpr size_t MAX_THREADS = 64;
+
+    double secondsSince(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    size_t resolveThreads(const size_t threads) {
+        const size_t count = threads > 0 ? threads : std::thread::hardware_concurrency();
+        return std::clamp<size_t>(count, 1, MAX_THREADS);
+    }
+
+    // Calls work(first, last, worker) for even slices of [0, count), one per thread,
+    // the last slice on the calling thread
+    template<typename Work>
+    void runSlices(const size_t threads, const size_t count, const Work &work) {
+        const size_t slices = std::max<size_t>(1, std::min(threads, count));
+        std::vector<std::thread> workers;
+        workers.reserve(slices - 1);
+        for (size_t slice = 0; slice + 1 < slices; ++slice) {
+            workers.emplace_back([&work, slice, slices, count] {
+                work(count * slice / slices, count * (slice + 1) / slices, slice);
+            });
+        }
+        work(count * (slices - 1) / slices, count, slices - 1);
+        for (std::thread &worker: workers) {
+            worker.join();
+        }
+    }
+
+    // ========================================================================
+    // CLASSIFY
+    // ========================================================================
+    // Ranges as packed RGBA words, alpha always in range
+    void packRange(const RoadColorRange &range, uint32_t &low, uint32_t &high) {
+        low = range.min[0] | range.min[1] << 8 | range.min[2] << 16;
+        high = range.max[0] | range.max[1] << 8 | range.max[2] << 16 | 0xffu << 24;
+    }
+
+    void classifyScalar(const uint8_t *rgba, const size_t count, const RoadColorRange *ranges,
+                        const size_t rangeCount, uint8_t *mask) {
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t *pixel = rgba + i * 4;
+            uint8_t road = 0;
+            for (size_t r = 0; r < rangeCount && !road; ++r) {
+                const RoadColorRange &range = ranges[r];
+                road = pixel[0] >= range.min[0] && pixel[0] <= range.max[0] &&
+                       pixel[1] >= range.min[1] && pixel[1] <= range.max[1] &&
+                       pixel[2] >= range.min[2] && pixel[2] <= range.max[2];
+            }
+            mask[i] = road;
+        }
+    }
+
+#ifdef KOSTUR_SSE2_KERNELS
+    // All four bytes of a lane within the range gives an all ones lane
+    __m128i inRangesSse2(const __m128i pixels, const uint32_t *lows, const uint32_t *highs, const size_t rangeCount) {
+        const __m128i ones = _mm_set1_epi32(-1);
+        __m128i road = _mm_setzero_si128();
+        for (size_t r = 0; r < rangeCount; ++r) {
+            const __m128i low = _mm_set1_epi32(static_cast<int>(lows[r]));
+            const __m128i high = _mm_set1_epi32(static_cast<int>(highs[r]));
+            const __m128i inside = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(pixels, low), pixels),
+                                                 _mm_cmpeq_epi8(_mm_min_epu8(pixels, high), pixels));
+            road = _mm_or_si128(road, _mm_cmpeq_epi32(inside, ones));
+        }
+        return road;
+    }
+
+    void classifySse2(const uint8_t *rgba, const size_t count, const RoadColorRange *ranges, const size_t rangeCount,
+                      uint8_t *mask) {
+        uint32_t lows[8], highs[8];
+        const size_t packed = std::min<size_t>(rangeCount, 8);
+        for (size_t r = 0; r < packed; ++r) {
+            packRange(ranges[r], lows[r], highs[r]);
+        }
+
+        const __m128i one = _mm_set1_epi8(1);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const auto *source = reinterpret_cast<const __m128i *>(rgba + i * 4);
+            const __m128i a = inRangesSse2(_mm_loadu_si128(source), lows, highs, packed);
+            const __m128i b = inRangesSse2(_mm_loadu_si128(source + 1), lows, highs, packed);
+            const __m128i c = inRangesSse2(_mm_loadu_si128(source + 2), lows, highs, packed);
+            const __m128i d = inRangesSse2(_mm_loadu_si128(source + 3), lows, highs, packed);
+            const __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(mask + i), _mm_and_si128(bytes, one));
+        }
+        classifyScalar(rgba + i * 4, count - i, ranges, rangeCount, mask + i);
+    }
+#endif
+
+#ifdef KOSTUR_AVX2_KERNELS
+    KOSTUR_AVX2_TARGET
+    __m256i inRangesAvx2(const __m256i pixels, const uint32_t *lows, const uint32_t *highs, const size_t rangeCount) {
+        const __m256i ones = _mm256_set1_epi32(-1);
+        __m256i road = _mm256_setzero_si256();
+        for (size_t r = 0; r < rangeCount; ++r) {
+            const __m256i low = _mm256_set1_epi32(static_cast<int>(lows[r]));
+            const __m256i high = _mm256_set1_epi32(static_cast<int>(highs[r]));
+            const __m256i inside = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(pixels, low), pixels),
+                                                    _mm256_cmpeq_epi8(_mm256_min_epu8(pixels, high), pixels));
+            road = _mm256_or_si256(road, _mm256_cmpeq_epi32(inside, ones));
+        }
+        return road;
+    }
+
+    KOSTUR_AVX2_TARGET
+    void classifyAvx2(const uint8_t *rgba, const size_t count, const RoadColorRange *ranges, const size_t rangeCount,
+                      uint8_t *mask) {
+        uint32_t lows[8], highs[8];
+        const size_t packed = std::min<size_t>(rangeCount, 8);
+        for (size_t r = 0; r < packed; ++r) {
+            packRange(ranges[r], lows[r], highs[r]);
+        }
+
+        // The packs interleave the 128-bit halves, the permute puts the pixels back in order
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        const __m256i one = _mm256_set1_epi8(1);
+        size_t i = 0;
+        for (; i + 32 <= count; i += 32) {
+            const auto *source = reinterpret_cast<const __m256i *>(rgba + i * 4);
+            const __m256i a = inRangesAvx2(_mm256_loadu_si256(source), lows, highs, packed);
+            const __m256i b = inRangesAvx2(_mm256_loadu_si256(source + 1), lows, highs, packed);
+            const __m256i c = inRangesAvx2(_mm256_loadu_si256(source + 2), lows, highs, packed);
+            const __m256i d = inRangesAvx2(_mm256_loadu_si256(source + 3), lows, highs, packed);
+            const __m256i bytes = _mm256_packs_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(mask + i),
+                                _mm256_and_si256(_mm256_permutevar8x32_epi32(bytes, order), one));
+        }
+        classifyScalar(rgba + i * 4, count - i, ranges, rangeCount, mask + i);
+    }
+#endif
+
+    // ========================================================================
+    // CLOSE
+    // ========================================================================
+    // Max (dilate) or min (erode) over a square window, as a row pass into scratch
+    // and a column pass back into the mask. Windows are clipped at the border.
+    void filterMask(uint8_t *mask, uint8_t *scratch, const int width, const int height, const int radius,
+                    const bool dilate, const size_t threads) {
+        const uint8_t extreme = dilate ? 1 : 0;
+        runSlices(threads, static_cast<size_t>(height), [&](const size_t first, const size_t last, size_t) {
+            for (size_t y = first; y < last; ++y) {
+                const uint8_t *row = mask + y * width;
+                uint8_t *out = scratch + y * width;
+                for (int x = 0; x < width; ++x) {
+                    const uint8_t *begin = row + std::max(0, x - radius);
+                    const uint8_t *end = row + std::min(width, x + radius + 1);
+                    out[x] = std::find(begin, end, extreme) != end ? extreme : !extreme;
+                }
+            }
+        });
+        runSlices(threads, static_cast<size_t>(height), [&](const size_t first, const size_t last, size_t) {
+            for (size_t y = first; y < last; ++y) {
+                const int top = std::max(0, static_cast<int>(y) - radius);
+                const int bottom = std::min(height - 1, static_cast<int>(y) + radius);
+                uint8_t *out = mask + y * width;
+                std::memcpy(out, scratch + static_cast<size_t>(top) * width, width);
+                for (int row = top + 1; row <= bottom; ++row) {
+                    const uint8_t *in = scratch + static_cast<size_t>(row) * width;
+                    for (int x = 0; x < width; ++x) {
+                        out[x] = dilate ? (out[x] | in[x]) : (out[x] & in[x]);
+                    }
+                }
+            }
+        });
+    }
+
+    // ========================================================================
+    // FILL
+    // ========================================================================
+    // Non-road areas of at most maxSize pixels that do not touch the border become
+    // road, 4-connected so that diagonal road pixels still separate them
+    void fillSmallHoles(uint8_t *mask, const int width, const int height, const size_t maxSize) {
+        std::vector<uint8_t> seen(static_cast<size_t>(width) * height, 0);
+        std::vector<uint32_t> stack, area;
+
+        for (size_t seed = 0; seed < seen.size(); ++seed) {
+            if (mask[seed] || seen[seed]) {
+                continue;
+            }
+
+            // Every pixel of the area is visited, only the first maxSize + 1 are kept
+            bool touchesBorder = false;
+            area.clear();
+            stack.assign(1, static_cast<uint32_t>(seed));
+            seen[seed] = 1;
+            while (!stack.empty()) {
+                const uint32_t pixel = stack.back();
+                stack.pop_back();
+                if (area.size() <= maxSize) {
+                    area.push_back(pixel);
+                }
+
+                const int x = static_cast<int>(pixel % width);
+                const int y = static_cast<int>(pixel / width);
+                if (x == 0 || y == 0 || x == width - 1 || y == height - 1) {
+                    touchesBorder = true;
+                    continue;
+                }
+                for (const uint32_t next: {pixel - 1, pixel + 1, pixel - width, pixel + width}) {
+                    if (!mask[next] && !seen[next]) {
+                        seen[next] = 1;
+                        stack.push_back(next);
+                    }
+                }
+            }
+
+            if (!touchesBorder && area.size() <= maxSize) {
+                for (const uint32_t pixel: area) {
+                    mask[pixel] = 1;
+                }
+            }
+        }
+    }
+
+    // ========================================================================
+    // THIN
+    // ========================================================================
+    // Neighbourhood codes have bit k set for neighbour P(k + 2), clockwise from north:
+    // N, NE, E, SE, S, SW, W, NW
+    uint8_t neighbourhood(const uint8_t *mask, const size_t i, const size_t width) {
+        return static_cast<uint8_t>(mask[i - width] | mask[i - width + 1] << 1 | mask[i + 1] << 2 |
+                                    mask[i + width + 1] << 3 | mask[i + width] << 4 | mask[i + width - 1] << 5 |
+                                    mask[i - 1] << 6 | mask[i - width - 1] << 7);
+    }
+
+    // Runs of set neighbours around the ring, the Zhang-Suen A(P1)
+    int countRuns(const unsigned code) {
+        int runs = 0;
+        for (int k = 0; k < 8; ++k) {
+            runs += !(code >> k & 1) && (code >> ((k + 1) & 7) & 1);
+        }
+        return runs;
+    }
+
+    struct ThinningTables {
+        bool deletable[2][256];
+
+        ThinningTables() : deletable{} {
+            for (unsigned code = 0; code < 256; ++code) {
+                const auto p = [code](const int n) { return (code >> (n - 2) & 1) != 0; };
+                int neighbours = 0;
+                for (int k = 0; k < 8; ++k) {
+                    neighbours += code >> k & 1;
+                }
+                if (neighbours < 2 || neighbours > 6 || countRuns(code) != 1) {
+                    continue;
+                }
+                deletable[0][code] = !(p(2) && p(4) && p(6)) && !(p(4) && p(6) && p(8));
+                deletable[1][code] = !(p(2) && p(4) && p(8)) && !(p(2) && p(6) && p(8));
+            }
+        }
+    };
+
+    const ThinningTables thinningTables;
+
+    // ========================================================================
+    // TRACE
+    // ========================================================================
+    constexpr float DIAGONAL_STEP = 1.41421356f;
+    constexpr int RING_DX[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    constexpr int RING_DY[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+    struct RawPath {
+        int32_t start, end; // Clusters
+        size_t first, count; // Pixels in TraceState::pixels
+        float length;
+    };
+
+    struct TraceState {
+        const uint8_t *skeleton;
+        int width, height;
+        std::vector<int32_t> clusterOf; // Per pixel, -1 for path and background pixels
+        std::vector<float> clusterXs, clusterYs;
+        std::vector<uint8_t> visited;
+        std::vector<uint32_t> pixels;
+        std::vector<RawPath> paths;
+    };
+
+    size_t offsetOf(const TraceState &state, const int direction) {
+        return static_cast<size_t>(static_cast<ptrdiff_t>(RING_DY[direction]) * state.width + RING_DX[direction]);
+    }
+
+    float stepLength(const TraceState &state, const size_t from, const size_t to) {
+        const bool diagonal = from % state.width != to % state.width && from / state.width != to / state.width;
+        return diagonal ? DIAGONAL_STEP : 1.0f;
+    }
+
+    // Skeleton pixels with other than two runs of neighbours, grouped 8-connected
+    // into clusters placed at their centroids
+    void findClusters(TraceState &state) {
+        const size_t pixelCount = static_cast<size_t>(state.width) * state.height;
+        state.clusterOf.assign(pixelCount, -1);
+        std::vector<uint8_t> isNode(pixelCount, 0);
+        for (int y = 1; y + 1 < state.height; ++y) {
+            for (int x = 1; x + 1 < state.width; ++x) {
+                const size_t i = static_cast<size_t>(y) * state.width + x;
+                if (state.skeleton[i] && countRuns(neighbourhood(state.skeleton, i, state.width)) != 2) {
+                    isNode[i] = 1;
+                }
+            }
+        }
+
+        std::vector<size_t> stack;
+        for (size_t seed = 0; seed < pixelCount; ++seed) {
+            if (!isNode[seed] || state.clusterOf[seed] >= 0) {
+                continue;
+            }
+
+            const auto cluster = static_cast<int32_t>(state.clusterXs.size());
+            double sumX = 0.0, sumY = 0.0;
+            size_t size = 0;
+            stack.assign(1, seed);
+            state.clusterOf[seed] = cluster;
+            while (!stack.empty()) {
+                const size_t pixel = stack.back();
+                stack.pop_back();
+                sumX += static_cast<double>(pixel % state.width);
+                sumY += static_cast<double>(pixel / state.width);
+                ++size;
+                for (int direction = 0; direction < 8; ++direction) {
+                    const size_t next = pixel + offsetOf(state, direction);
+                    if (isNode[next] && state.clusterOf[next] < 0) {
+                        state.clusterOf[next] = cluster;
+                        stack.push_back(next);
+                    }
+                }
+            }
+            state.clusterXs.push_back(static_cast<float>(sumX / size));
+            state.clusterYs.push_back(static_cast<float>(sumY / size));
+        }
+    }
+
+    // Follows the skeleton from a cluster pixel through cur until the next cluster.
+    // Paths that run into pixels already traced end nowhere and are dropped.
+    void tracePath(TraceState &state, const size_t from, size_t cur) {
+        const int32_t start = state.clusterOf[from];
+        const size_t first = state.pixels.size();
+        size_t previous = from;
+        float length = 0.0f;
+
+        while (true) {
+            state.visited[cur] = 1;
+            state.pixels.push_back(static_cast<uint32_t>(cur));
+            length += stepLength(state, previous, cur);
+
+            // Two runs around a path pixel, the one without the previous pixel leads on
+            const unsigned code = neighbourhood(state.skeleton, cur, state.width);
+            int previousDirection = 0;
+            for (int direction = 0; direction < 8; ++direction) {
+                if (cur + offsetOf(state, direction) == previous) {
+                    previousDirection = direction;
+                }
+            }
+            int runStart = previousDirection;
+            while (code >> ((runStart + 7) & 7) & 1 && ((runStart + 7) & 7) != previousDirection) {
+                runStart = (runStart + 7) & 7;
+            }
+
+            // Scan the ring from past the previous pixel's run, nodes and then 4-neighbours first
+            int nodeDirection = -1, pathDirection = -1;
+            bool inPreviousRun = true;
+            for (int step = 0; step < 8; ++step) {
+                const int direction = (runStart + step) & 7;
+                const bool set = code >> direction & 1;
+                if (!set) {
+                    inPreviousRun = false;
+                    continue;
+                }
+                if (inPreviousRun) {
+                    continue;
+                }
+                const size_t next = cur + offsetOf(state, direction);
+                if (state.clusterOf[next] >= 0) {
+                    if (nodeDirection < 0 || (direction & 1) == 0) {
+                        nodeDirection = direction;
+                    }
+                } else if (pathDirection < 0 || ((direction & 1) == 0 && (pathDirection & 1) != 0)) {
+                    pathDirection = direction;
+                }
+            }
+
+            previous = cur;
+            if (nodeDirection >= 0) {
+                const size_t end = cur + offsetOf(state, nodeDirection);
+                length += stepLength(state, cur, end);
+                state.paths.push_back({start, state.clusterOf[end], first, state.pixels.size() - first, length});
+                return;
+            }
+            if (pathDirection < 0 || state.visited[cur + offsetOf(state, pathDirection)]) {
+                state.pixels.resize(first);
+                return;
+            }
+            cur += offsetOf(state, pathDirection);
+        }
+    }
+
+    // Dead ends shorter than minLength, and short paths joining two dead ends, are
+    // dropped. One pass, a junction left with one path keeps it.
+    size_t pruneSpurs(TraceState &state, const float minLength) {
+        std::vector<uint32_t> degree(state.clusterXs.size(), 0);
+        for (const RawPath &path: state.paths) {
+            ++degree[path.start];
+            ++degree[path.end];
+        }
+
+        const size_t before = state.paths.size();
+        state.paths.erase(std::remove_if(state.paths.begin(), state.paths.end(), [&degree, minLength](const RawPath &p) {
+            return p.length < minLength && (degree[p.start] == 1 || degree[p.end] == 1);
+        }), state.paths.end());
+        return before - state.paths.size();
+    }
+
+    // Marks the points to keep of xs and ys, first and last included
+    void simplifyPath(const std::vector<float> &xs, const std::vector<float> &ys, const float tolerance,
+                      std::vector<uint8_t> &keep, std::vector<std::pair<size_t, size_t>> &stack) {
+        const size_t count = xs.size();
+        keep.assign(count, 0);
+        keep[0] = keep[count - 1] = 1;
+        stack.assign(1, {0, count - 1});
+        while (!stack.empty()) {
+            const auto [first, last] = stack.back();
+            stack.pop_back();
+
+            const float dx = xs[last] - xs[first];
+            const float dy = ys[last] - ys[first];
+            const float length = std::hypot(dx, dy);
+            float farthest = tolerance;
+            size_t split = 0;
+            for (size_t i = first + 1; i < last; ++i) {
+                const float ex = xs[i] - xs[first];
+                const float ey = ys[i] - ys[first];
+                // Closed loops have coinciding ends, the distance is then to the end point
+                const float distance = length > 0.0f ? std::abs(ex * dy - ey * dx) / length : std::hypot(ex, ey);
+                if (distance > farthest) {
+                    farthest = distance;
+                    split = i;
+                }
+            }
+            if (split > 0) {
+                keep[split] = 1;
+                stack.push_back({first, split});
+                stack.push_back({split, last});
+            }
+        }
+    }
+
+    struct GraphEdge {
+        uint32_t from, to;
+        float length;
+    };
+
+    void buildCsr(RoadGraph &graph, const std::vector<GraphEdge> &edges) {
+        const size_t nodeCount = graph.xs.size();
+        graph.firstEdge.assign(nodeCount + 1, 0);
+        for (const GraphEdge &edge: edges) {
+            ++graph.firstEdge[edge.from + 1];
+            ++graph.firstEdge[edge.to + 1];
+        }
+        for (size_t node = 0; node < nodeCount; ++node) {
+            graph.firstEdge[node + 1] += graph.firstEdge[node];
+        }
+
+        graph.targets.resize(edges.size() * 2);
+        graph.lengths.resize(edges.size() * 2);
+        std::vector<uint32_t> fill(graph.firstEdge.begin(), graph.firstEdge.end() - 1);
+        for (const GraphEdge &edge: edges) {
+            graph.targets[fill[edge.from]] = edge.to;
+            graph.lengths[fill[edge.from]++] = edge.length;
+            graph.targets[fill[edge.to]] = edge.from;
+            graph.lengths[fill[edge.to]++] = edge.length;
+        }
+    }
+
+    void traceGraph(const uint8_t *skeleton, const int width, const int height, const RoadGraphOptions &options,
+                    RoadGraph &graph, RoadGraphStats &stats) {
+        TraceState state;
+        state.skeleton = skeleton;
+        state.width = width;
+        state.height = height;
+        state.visited.assign(static_cast<size_t>(width) * height, 0);
+        findClusters(state);
+
+        for (size_t pixel = 0; pixel < state.clusterOf.size(); ++pixel) {
+            if (state.clusterOf[pixel] < 0) {
+                continue;
+            }
+            for (int direction = 0; direction < 8; ++direction) {
+                const size_t next = pixel + offsetOf(state, direction);
+                if (skeleton[next] && state.clusterOf[next] < 0 && !state.visited[next]) {
+                    tracePath(state, pixel, next);
+                }
+            }
+        }
+        stats.prunedSpurs = pruneSpurs(state, options.minSpurLength);
+
+        // Clusters become nodes as paths reach them, path corners are added in between
+        std::vector<uint32_t> nodeOf(state.clusterXs.size(), UINT32_MAX);
+        const auto clusterNode = [&](const int32_t cluster) {
+            if (nodeOf[cluster] == UINT32_MAX) {
+                nodeOf[cluster] = static_cast<uint32_t>(graph.xs.size());
+                graph.xs.push_back(state.clusterXs[cluster]);
+                graph.ys.push_back(state.clusterYs[cluster]);
+            }
+            return nodeOf[cluster];
+        };
+
+        std::vector<GraphEdge> edges;
+        std::vector<float> xs, ys, distances;
+        std::vector<uint8_t> keep;
+        std::vector<std::pair<size_t, size_t>> stack;
+        for (const RawPath &path: state.paths) {
+            xs.assign(1, state.clusterXs[path.start]);
+            ys.assign(1, state.clusterYs[path.start]);
+            for (size_t i = 0; i < path.count; ++i) {
+                const uint32_t pixel = state.pixels[path.first + i];
+                xs.push_back(static_cast<float>(pixel % width));
+                ys.push_back(static_cast<float>(pixel / width));
+            }
+            xs.push_back(state.clusterXs[path.end]);
+            ys.push_back(state.clusterYs[path.end]);
+
+            // Lengths along the pixels, the ends measured to the cluster centroids
+            distances.assign(xs.size(), 0.0f);
+            for (size_t i = 1; i < xs.size(); ++i) {
+                distances[i] = distances[i - 1] + std::hypot(xs[i] - xs[i - 1], ys[i] - ys[i - 1]);
+            }
+            simplifyPath(xs, ys, options.simplifyTolerance, keep, stack);
+
+            uint32_t from = clusterNode(path.start);
+            size_t fromIndex = 0;
+            for (size_t i = 1; i < xs.size(); ++i) {
+                if (!keep[i]) {
+                    continue;
+                }
+                uint32_t to;
+                if (i + 1 == xs.size()) {
+                    to = clusterNode(path.end);
+                } else {
+                    to = static_cast<uint32_t>(graph.xs.size());
+                    graph.xs.push_back(xs[i]);
+                    graph.ys.push_back(ys[i]);
+                }
+                if (to != from) {
+                    edges.push_back({from, to, distances[i] - distances[fromIndex]});
+                }
+                from = to;
+                fromIndex = i;
+            }
+        }
+        buildCsr(graph, edges);
+    }
+
+    uint8_t *putField(uint8_t *p, const uint32_t value) {
+        for (size_t i = 0; i < 4; ++i) {
+            *p++ = static_cast<uint8_t>(value >> (8 * i));
+        }
+        return p;
+    }
+
+    uint32_t getField(const uint8_t *p) {
+        return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+}
+
+void classifyRoadPixels(const uint8_t *rgba, const size_t count, const RoadColorRange *ranges,
+                        const size_t rangeCount, uint8_t *mask) {
+    // The vector kernels hold up to 8 ranges
+    if (rangeCount <= 8) {
+        switch (getPointKernelLevel()) {
+#ifdef KOSTUR_AVX2_KERNELS
+            case PointKernelLevel::Avx2:
+                classifyAvx2(rgba, count, ranges, rangeCount, mask);
+                return;
+#endif
+#ifdef KOSTUR_SSE2_KERNELS
+            case PointKernelLevel::Sse2:
+                classifySse2(rgba, count, ranges, rangeCount, mask);
+                return;
+#endif
+            default:
+                break;
+        }
+    }
+    classifyScalar(rgba, count, ranges, rangeCount, mask);
+}
+
+size_t thinRoadMask(uint8_t *mask, const int width, const int height, const size_t threads) {
+    if (width < 3 || height < 3) {
+        return 0;
+    }
+
+    // The border stays empty, so every tested pixel has all eight neighbours
+    std::memset(mask, 0, width);
+    std::memset(mask + static_cast<size_t>(height - 1) * width, 0, width);
+    for (int y = 0; y < height; ++y) {
+        mask[static_cast<size_t>(y) * width] = 0;
+        mask[static_cast<size_t>(y) * width + width - 1] = 0;
+    }
+
+    // A pixel's verdict in a sub-iteration only changes when its neighbourhood did, so
+    // rows are tested again only after a change next to them in the last two
+    const size_t workerCount = resolveThreads(threads);
+    std::vector<size_t> changedAt(height, 1);
+    std::vector<int> rows;
+    std::vector<std::vector<size_t>> deletions(workerCount);
+    size_t subIteration = 1;
+    size_t iterations = 0;
+
+    while (true) {
+        const int step = static_cast<int>((subIteration - 1) & 1);
+        rows.clear();
+        for (int y = 1; y + 1 < height; ++y) {
+            const size_t latest = std::max({changedAt[y - 1], changedAt[y], changedAt[y + 1]});
+            if (latest + 2 >= subIteration) {
+                rows.push_back(y);
+            }
+        }
+        if (rows.empty()) {
+            break;
+        }
+        if (step == 0) {
+            ++iterations;
+        }
+
+        // Verdicts read the mask as it was at the start of the sub-iteration, deletions follow
+        runSlices(workerCount, rows.size(), [&](const size_t first, const size_t last, const size_t worker) {
+            std::vector<size_t> &deleted = deletions[worker];
+            deleted.clear();
+            for (size_t r = first; r < last; ++r) {
+                const size_t rowStart = static_cast<size_t>(rows[r]) * width;
+                for (size_t i = rowStart + 1; i + 1 < rowStart + width; ++i) {
+                    if (mask[i] && thinningTables.deletable[step][neighbourhood(mask, i, width)]) {
+                        deleted.push_back(i);
+                    }
+                }
+            }
+        });
+
+        for (const std::vector<size_t> &deleted: deletions) {
+            for (const size_t i: deleted) {
+                mask[i] = 0;
+                changedAt[i / width] = subIteration;
+            }
+        }
+        ++subIteration;
+    }
+    return iterations;
+}
+
+void extractRoadGraph(const uint8_t *rgba, const int width, const int height, const RoadGraphOptions &options,
+                      RoadGraph &graph, RoadGraphStats &stats) {
+    stats = RoadGraphStats{};
+    graph = RoadGraph{};
+    graph.width = width;
+    graph.height = height;
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    const size_t threads = resolveThreads(options.threads);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> mask(pixelCount);
+    runSlices(threads, static_cast<size_t>(height), [&](const size_t first, const size_t last, size_t) {
+        classifyRoadPixels(rgba + first * width * 4, (last - first) * width, options.colors.data(),
+                           options.colors.size(), mask.data() + first * width);
+    });
+    const size_t classified = static_cast<size_t>(std::count(mask.begin(), mask.end(), 1));
+    if (options.closeRadius > 0) {
+        std::vector<uint8_t> scratch(pixelCount);
+        filterMask(mask.data(), scratch.data(), width, height, options.closeRadius, true, threads);
+        filterMask(mask.data(), scratch.data(), width, height, options.closeRadius, false, threads);
+    }
+    fillSmallHoles(mask.data(), width, height, options.maxHoleSize);
+    stats.roadPixels = static_cast<size_t>(std::count(mask.begin(), mask.end(), 1));
+    stats.filledPixels = stats.roadPixels - classified;
+    stats.classifySeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    stats.iterations = thinRoadMask(mask.data(), width, height, threads);
+    stats.skeletonPixels = static_cast<size_t>(std::count(mask.begin(), mask.end(), 1));
+    stats.thinSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    if (width >= 3 && height >= 3) {
+        traceGraph(mask.data(), width, height, options, graph, stats);
+    } else {
+        graph.firstEdge.assign(1, 0);
+    }
+    stats.traceSeconds = secondsSince(start);
+}
+
+bool loadImageToRoadGraph(const char *filePath, const RoadGraphOptions &options, RoadGraph &graph,
+                          RoadGraphStats &stats) {
+    int width, height, channels;
+    unsigned char *imageData = stbi_load(filePath, &width, &height, &channels, 4);
+    if (!imageData) {
+        std::cout << "Greska pri citanju fajla sa putanje \"" << filePath << "\"!" << std::endl;
+        return false;
+    }
+
+    extractRoadGraph(imageData, width, height, options, graph, stats);
+    stbi_image_free(imageData);
+    return true;
+}
+
+bool saveRoadGraph(const char *path, const RoadGraph &graph) {
+    std::FILE *out = std::fopen(path, "wb");
+    if (!out) {
+        std::cout << "Greska pri pisanju fajla sa putanje \"" << path << "\"!" << std::endl;
+        return false;
+    }
+
+    // Header fields are written byte by byte, the arrays as they are in memory
+    uint8_t header[HEADER_SIZE] = {};
+    uint8_t *p = header;
+    std::memcpy(p, MAGIC, sizeof(MAGIC));
+    p += sizeof(MAGIC);
+    p = putField(p, VERSION);
+    p = putField(p, static_cast<uint32_t>(graph.width));
+    p = putField(p, static_cast<uint32_t>(graph.height));
+    p = putField(p, static_cast<uint32_t>(graph.xs.size()));
+    putField(p, static_cast<uint32_t>(graph.targets.size()));
+
+    const size_t nodeCount = graph.xs.size();
+    const size_t edgeCount = graph.targets.size();
+    bool written = std::fwrite(header, 1, HEADER_SIZE, out) == HEADER_SIZE;
+    written = written && std::fwrite(graph.xs.data(), sizeof(float), nodeCount, out) == nodeCount;
+    written = written && std::fwrite(graph.ys.data(), sizeof(float), nodeCount, out) == nodeCount;
+    written = written && std::fwrite(graph.firstEdge.data(), sizeof(uint32_t), nodeCount + 1, out) == nodeCount + 1;
+    written = written && std::fwrite(graph.targets.data(), sizeof(uint32_t), edgeCount, out) == edgeCount;
+    written = written && std::fwrite(graph.lengths.data(), sizeof(float), edgeCount, out) == edgeCount;
+    written = std::fclose(out) == 0 && written;
+    if (!written) {
+        std::cout << "Greska pri pisanju fajla sa putanje \"" << path << "\"!" << std::endl;
+    }
+    return written;
+}
+
+bool loadRoadGraph(const char *path, RoadGraph &graph) {
+    MappedFile file;
+    if (!openMappedFile(file, path)) {
+        return false;
+    }
+
+    const auto *data = reinterpret_cast<const uint8_t *>(file.data);
+    bool valid = file.size >= HEADER_SIZE && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0 &&
+                 getField(data + 4) == VERSION;
+    const size_t nodeCount = valid ? getField(data + 16) : 0;
+    const size_t edgeCount = valid ? getField(data + 20) : 0;
+    valid = valid && file.size == HEADER_SIZE + nodeCount * 12 + 4 + edgeCount * 8;
+
+    if (valid) {
+        graph.width = static_cast<int>(getField(data + 8));
+        graph.height = static_cast<int>(getField(data + 12));
+        const auto *floats = reinterpret_cast<const float *>(data + HEADER_SIZE);
+        const auto *offsets = reinterpret_cast<const uint32_t *>(floats + nodeCount * 2);
+        const auto *targets = offsets + nodeCount + 1;
+        const auto *lengths = reinterpret_cast<const float *>(targets + edgeCount);
+        graph.xs.assign(floats, floats + nodeCount);
+        graph.ys.assign(floats + nodeCount, floats + nodeCount * 2);
+        graph.firstEdge.assign(offsets, offsets + nodeCount + 1);
+        graph.targets.assign(targets, targets + edgeCount);
+        graph.lengths.assign(lengths, lengths + edgeCount);
+
+        // Offsets must be ordered and stay within the edges, targets within the nodes
+        valid = graph.firstEdge.front() == 0 && graph.firstEdge.back() == edgeCount &&
+                std::is_sorted(graph.firstEdge.begin(), graph.firstEdge.end()) &&
+                std::all_of(graph.targets.begin(), graph.targets.end(),
+                            [nodeCount](const uint32_t target) { return target < nodeCount; });
+    }
+    closeMappedFile(file);
+
+    if (!valid) {
+        std::cout << "Fajl \"" << path << "\" nije ispravan graf ulica!" << std::endl;
+        graph = RoadGraph{};
+    }
+    return valid;
+}
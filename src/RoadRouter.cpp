@@ -0,0 +1,121 @@
+#include "../Header/RoadRouter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Header/Trace.h"
+
+namespace {
+    // Min-heap on the estimate, ties to the lower node so results do not depend on push order
+    bool laterEntry(const RoadHeapEntry &a, const RoadHeapEntry &b) {
+        return a.estimate > b.estimate || (a.estimate == b.estimate && a.node > b.node);
+    }
+
+    float straightLine(const RoadGraph &graph, const uint32_t from, const uint32_t to) {
+        return std::hypot(graph.xs[to] - graph.xs[from], graph.ys[to] - graph.ys[from]);
+    }
+}
+
+void createRoadRouter(RoadRouter &router, const RoadGraph &graph, const float snapRadius) {
+    const size_t nodeCount = graph.xs.size();
+    router.graph = &graph;
+    router.snapRadius = snapRadius;
+
+    createSpatialGrid(router.nodes, 0.0f, 0.0f, static_cast<float>(graph.width), static_cast<float>(graph.height),
+                      std::max(snapRadius, 1.0f), nodeCount);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        insertIntoGrid(router.nodes, static_cast<uint32_t>(node), graph.xs[node], graph.ys[node]);
+    }
+
+    router.distances.assign(nodeCount, 0.0f);
+    router.parents.assign(nodeCount, 0);
+    router.reachedIn.assign(nodeCount, 0);
+    router.closedIn.assign(nodeCount, 0);
+    router.heap.clear();
+    router.heap.reserve(graph.targets.size() + 1);
+    router.path.clear();
+    router.path.reserve(nodeCount);
+    router.query = 0;
+}
+
+int32_t snapToRoad(const RoadRouter &router, const float x, const float y) {
+    return findNearestInGrid(router.nodes, x, y, router.snapRadius);
+}
+
+bool findRoadPath(RoadRouter &router, const uint32_t source, const uint32_t target) {
+    TRACE_SCOPE("findRoadPath", "loop");
+    const RoadGraph &graph = *router.graph;
+    router.path.clear();
+    router.pathLength = 0.0f;
+    router.settled = 0;
+    if (source >= graph.xs.size() || target >= graph.xs.size()) {
+        return false;
+    }
+
+    // Stamps start over after wrapping, with every node marked as from no query
+    if (++router.query == 0) {
+        std::fill(router.reachedIn.begin(), router.reachedIn.end(), 0);
+        std::fill(router.closedIn.begin(), router.closedIn.end(), 0);
+        router.query = 1;
+    }
+    const uint32_t query = router.query;
+
+    router.heap.clear();
+    router.distances[source] = 0.0f;
+    router.parents[source] = source;
+    router.reachedIn[source] = query;
+    router.heap.push_back({straightLine(graph, source, target), source});
+
+    bool found = false;
+    while (!router.heap.empty()) {
+        std::pop_heap(router.heap.begin(), router.heap.end(), laterEntry);
+        const uint32_t node = router.heap.back().node;
+        router.heap.pop_back();
+        if (router.closedIn[node] == query) {
+            continue;
+        }
+        router.closedIn[node] = query;
+        ++router.settled;
+        if (node == target) {
+            found = true;
+            break;
+        }
+
+        const float distance = router.distances[node];
+        for (uint32_t edge = graph.firstEdge[node]; edge < graph.firstEdge[node + 1]; ++edge) {
+            const uint32_t next = graph.targets[edge];
+            const float candidate = distance + graph.lengths[edge];
+            if (router.closedIn[next] == query ||
+                (router.reachedIn[next] == query && candidate >= router.distances[next])) {
+                continue;
+            }
+            router.distances[next] = candidate;
+            router.parents[next] = node;
+            router.reachedIn[next] = query;
+            router.heap.push_back({candidate + straightLine(graph, next, target), next});
+            std::push_heap(router.heap.begin(), router.heap.end(), laterEntry);
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    for (uint32_t node = target; node != source; node = router.parents[node]) {
+        router.path.push_back(node);
+    }
+    router.path.push_back(source);
+    std::reverse(router.path.begin(), router.path.end());
+    router.pathLength = router.distances[target];
+    return true;
+}
+
+void mapToRoadPixels(const int width, const int height, const float mapX, const float mapY, float &x, float &y) {
+    // Pixel centres, the image spans the map with its top row at y = 1
+    x = (mapX + 1.0f) * 0.5f * static_cast<float>(width) - 0.5f;
+    y = (1.0f - mapY) * 0.5f * static_cast<float>(height) - 0.5f;
+}
+
+void roadPixelsToMap(const int width, const int height, const float x, const float y, float &mapX, float &mapY) {
+    mapX = (x + 0.5f) / static_cast<float>(width) * 2.0f - 1.0f;
+    mapY = 1.0f - (y + 0.5f) / static_cast<float>(height) * 2.0f;
+}
@@ -0,0 +1,166 @@
+#include "../Header/RouteBuffer.h"
+
+#include <algorithm>
+
+#include "../Header/Simplify.h"
+#include "../Header/Trace.h"
+
+namespace {
+    constexpr GLsizei VERTEX_SIZE = 2 * sizeof(float);
+
+    // Appends the points of every block ranked at least minRank, returns how many were written
+    size_t stageRoute(const RouteStore &route, const float minRank, float *xys) {
+        size_t written = 0;
+        for (const uint32_t slot: route.order) {
+            const RouteBlock &block = route.blocks[slot];
+            written += selectRankedPoints(block.xs, block.ys, block.ranks, block.count, minRank, xys + written * 2);
+        }
+        return written;
+    }
+
+    // Uploads the staged vertices from the first one that differs from the buffer
+    void uploadStaging(RouteBuffer &routeBuffer, const size_t vertexCount) {
+        const size_t floatCount = vertexCount * 2;
+        size_t firstChanged = 0;
+
+        glBindBuffer(GL_ARRAY_BUFFER, routeBuffer.buffer);
+        if (vertexCount > routeBuffer.capacity) {
+            routeBuffer.capacity = std::max(vertexCount, routeBuffer.capacity * 2);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(routeBuffer.capacity * VERTEX_SIZE), nullptr,
+                         GL_DYNAMIC_DRAW);
+        } else {
+            const size_t common = std::min(floatCount, routeBuffer.uploaded.size());
+            firstChanged = static_cast<size_t>(std::mismatch(routeBuffer.staging.begin(),
+                                                             routeBuffer.staging.begin() + common,
+                                                             routeBuffer.uploaded.begin()).first -
+                                               routeBuffer.staging.begin()) / 2;
+        }
+
+        if (firstChanged < vertexCount) {
+            glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(firstChanged * VERTEX_SIZE),
+                            static_cast<GLsizeiptr>((vertexCount - firstChanged) * VERTEX_SIZE),
+                            routeBuffer.staging.data() + firstChanged * 2);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // The staging vector is rewritten by the next update, both keep their capacity
+        routeBuffer.staging.resize(floatCount);
+        routeBuffer.staging.swap(routeBuffer.uploaded);
+    }
+}
+
+void createRouteBuffer(RouteBuffer &routeBuffer, const unsigned int quadBuffer, const unsigned int quadIndices,
+                       const size_t reservedVertices, const size_t maxMarkers) {
+    // The line and the markers each hold up to every vertex, plus one for the last end attribute
+    routeBuffer.capacity = reservedVertices * 2 + 1;
+    routeBuffer.staging.reserve(routeBuffer.capacity * 2);
+    routeBuffer.uploaded.reserve(routeBuffer.capacity * 2);
+    routeBuffer.maxMarkers = maxMarkers;
+
+    glGenVertexArrays(1, &routeBuffer.vertexArray);
+    glGenBuffers(1, &routeBuffer.buffer);
+    glBindVertexArray(routeBuffer.vertexArray);
+
+    // Unit quad, same layout as setupBuffers
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndices);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void *>(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // Instance i reads vertex i as its start and vertex i + 1 as its end
+    glBindBuffer(GL_ARRAY_BUFFER, routeBuffer.buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(routeBuffer.capacity * VERTEX_SIZE), nullptr,
+                 GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(RouteBuffer::START_LOCATION, 2, GL_FLOAT, GL_FALSE, VERTEX_SIZE, nullptr);
+    glEnableVertexAttribArray(RouteBuffer::START_LOCATION);
+    glVertexAttribDivisor(RouteBuffer::START_LOCATION, 1);
+    glVertexAttribPointer(RouteBuffer::END_LOCATION, 2, GL_FLOAT, GL_FALSE, VERTEX_SIZE,
+                          reinterpret_cast<void *>(static_cast<uintptr_t>(VERTEX_SIZE)));
+    glEnableVertexAttribArray(RouteBuffer::END_LOCATION);
+    glVertexAttribDivisor(RouteBuffer::END_LOCATION, 1);
+
+    // The fan reads the same vertices per vertex, z and w of aPos default to 0 and 1
+    glGenVertexArrays(1, &routeBuffer.fillVertexArray);
+    glBindVertexArray(routeBuffer.fillVertexArray);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, VERTEX_SIZE, nullptr);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void destroyRouteBuffer(RouteBuffer &routeBuffer) {
+    glDeleteVertexArrays(1, &routeBuffer.vertexArray);
+    glDeleteVertexArrays(1, &routeBuffer.fillVertexArray);
+    glDeleteBuffers(1, &routeBuffer.buffer);
+    routeBuffer.vertexArray = 0;
+    routeBuffer.fillVertexArray = 0;
+    routeBuffer.buffer = 0;
+}
+
+bool updateRouteBuffer(RouteBuffer &routeBuffer, RouteStore &route, const float tolerance) {
+    if (route.revision == routeBuffer.revision && tolerance == routeBuffer.tolerance) {
+        return false;
+    }
+    TRACE_SCOPE("updateRouteBuffer", "loop");
+
+    rankRouteBlocks(route);
+    routeBuffer.revision = route.revision;
+    routeBuffer.tolerance = tolerance;
+
+    routeBuffer.staging.resize((route.size * 2 + 1) * 2);
+    float *xys = routeBuffer.staging.data();
+
+    const size_t lineCount = stageRoute(route, tolerance * tolerance, xys);
+    routeBuffer.lineFirst = 0;
+    routeBuffer.lineCount = static_cast<GLuint>(lineCount);
+
+    // Ranks are never negative, so a zero threshold stages every vertex
+    size_t vertexCount = lineCount;
+    if (lineCount == route.size || route.size > routeBuffer.maxMarkers) {
+        routeBuffer.markerFirst = 0;
+        routeBuffer.markerCount = static_cast<GLuint>(lineCount);
+    } else {
+        routeBuffer.markerFirst = static_cast<GLuint>(lineCount);
+        routeBuffer.markerCount = static_cast<GLuint>(stageRoute(route, 0.0f, xys + lineCount * 2));
+        vertexCount += routeBuffer.markerCount;
+    }
+
+    // Markers read an end attribute too, the last one past the staged vertices
+    xys[vertexCount * 2] = vertexCount > 0 ? xys[vertexCount * 2 - 2] : 0.0f;
+    xys[vertexCount * 2 + 1] = vertexCount > 0 ? xys[vertexCount * 2 - 1] : 0.0f;
+    uploadStaging(routeBuffer, vertexCount + 1);
+    return true;
+}
+
+void drawRouteSegments(const RouteBuffer &routeBuffer) {
+    if (routeBuffer.lineCount < 2) {
+        return;
+    }
+
+    glBindVertexArray(routeBuffer.vertexArray);
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr,
+                                        static_cast<GLsizei>(routeBuffer.lineCount - 1), routeBuffer.lineFirst);
+}
+
+void drawRouteMarkers(const RouteBuffer &routeBuffer) {
+    if (routeBuffer.markerCount == 0) {
+        return;
+    }
+
+    glBindVertexArray(routeBuffer.vertexArray);
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr,
+                                        static_cast<GLsizei>(routeBuffer.markerCount), routeBuffer.markerFirst);
+}
+
+void drawRouteFan(const RouteBuffer &routeBuffer) {
+    if (routeBuffer.lineCount < 3) {
+        return;
+    }
+
+    glBindVertexArray(routeBuffer.fillVertexArray);
+    glDrawArrays(GL_TRIANGLE_FAN, static_cast<GLint>(routeBuffer.lineFirst),
+                 static_cast<GLsizei>(routeBuffer.lineCount));
+}
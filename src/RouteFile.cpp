@@ -0,0 +1,394 @@
+#include "../Header/RouteFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "../Header/LzCompression.h"
+#include "../Header/Trace.h"
+
+namespace {
+    constexpr char MAGIC[4] = {'K', 'R', 'U', 'T'};
+    constexpr uint16_t VERSION = 1;
+    constexpr uint16_t FLAG_COMPRESSED = 1; // Blocks went through the LZ pass, each entry says whether it kept it
+    constexpr size_t HEADER_SIZE = 64;
+    constexpr size_t INDEX_ENTRY_SIZE = 40;
+
+    constexpr size_t MAX_VARINT_SIZE = 5;
+    constexpr size_t MAX_ENCODED_SIZE = ROUTE_FILE_BLOCK_POINTS * 2 * MAX_VARINT_SIZE;
+    static_assert(MAX_ENCODED_SIZE <= LZ_MAX_INPUT, "blocks are compressed in one go");
+
+    // Quantised coordinates stay within half the int32 range so differences never overflow
+    constexpr double QUANTISED_LIMIT = 1 << 30;
+
+    // Centres further apart than this, in world units, are different maps
+    constexpr double CENTRE_TOLERANCE = 1.0;
+
+    // ------------------------------------------------------------------------
+    // Little endian fields
+    // ------------------------------------------------------------------------
+    template<typename T>
+    uint8_t *putField(uint8_t *p, const T value) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            *p++ = static_cast<uint8_t>(bits >> (8 * i));
+        }
+        return p;
+    }
+
+    template<typename T>
+    const uint8_t *getField(const uint8_t *p, T &value) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bits |= static_cast<uint64_t>(*p++) << (8 * i);
+        }
+        std::memcpy(&value, &bits, sizeof(T));
+        return p;
+    }
+
+    // ------------------------------------------------------------------------
+    // Varints
+    // ------------------------------------------------------------------------
+    uint32_t encodeZigZag(const int32_t value) {
+        return static_cast<uint32_t>(value) << 1 ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    int32_t decodeZigZag(const uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    uint8_t *writeVarint(uint8_t *p, uint32_t value) {
+        while (value >= 0x80) {
+            *p++ = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *p++ = static_cast<uint8_t>(value);
+        return p;
+    }
+
+    bool readVarint(const uint8_t *&p, const uint8_t *end, uint32_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (p == end) {
+                return false;
+            }
+            const uint8_t byte = *p++;
+            value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int32_t quantise(const float value, const double scale) {
+        const double scaled = std::clamp(value * scale, -QUANTISED_LIMIT, QUANTISED_LIMIT);
+        return static_cast<int32_t>(scaled + (scaled >= 0.0 ? 0.5 : -0.5));
+    }
+
+    // ------------------------------------------------------------------------
+    // Writing
+    // ------------------------------------------------------------------------
+    struct BlockWriter {
+        std::FILE *out = nullptr;
+        bool compress = false;
+        uint64_t offset = HEADER_SIZE;
+        double scale = 1.0 / ROUTE_FILE_QUANTUM;
+
+        std::vector<int32_t> xs, ys; // Quantised points of the block being filled
+        size_t count = 0;
+        std::vector<uint8_t> encoded, compressed;
+        std::vector<RouteFileBlock> index;
+    };
+
+    void flushBlock(BlockWriter &writer) {
+        if (writer.count == 0) {
+            return;
+        }
+
+        RouteFileBlock entry;
+        entry.offset = writer.offset;
+        entry.count = static_cast<uint32_t>(writer.count);
+        entry.minX = entry.maxX = writer.xs[0];
+        entry.minY = entry.maxY = writer.ys[0];
+
+        uint8_t *p = writer.encoded.data();
+        int32_t previousX = 0, previousY = 0;
+        for (size_t i = 0; i < writer.count; ++i) {
+            const int32_t x = writer.xs[i];
+            const int32_t y = writer.ys[i];
+            p = writeVarint(p, encodeZigZag(x - previousX));
+            p = writeVarint(p, encodeZigZag(y - previousY));
+            previousX = x;
+            previousY = y;
+
+            entry.minX = std::min(entry.minX, x);
+            entry.maxX = std::max(entry.maxX, x);
+            entry.minY = std::min(entry.minY, y);
+            entry.maxY = std::max(entry.maxY, y);
+        }
+        entry.encodedSize = static_cast<uint32_t>(p - writer.encoded.data());
+        entry.storedSize = entry.encodedSize;
+
+        const uint8_t *stored = writer.encoded.data();
+        if (writer.compress) {
+            const size_t compressedSize = compressLz(writer.encoded.data(), entry.encodedSize, writer.compressed.data());
+            if (compressedSize < entry.encodedSize) {
+                entry.compressed = true;
+                entry.storedSize = static_cast<uint32_t>(compressedSize);
+                stored = writer.compressed.data();
+            }
+        }
+
+        std::fwrite(stored, 1, entry.storedSize, writer.out);
+        writer.offset += entry.storedSize;
+        writer.index.push_back(entry);
+        writer.count = 0;
+    }
+
+    bool reportWriteError(std::FILE *out, const char *path) {
+        if (out) {
+            std::fclose(out);
+        }
+        std::cout << "Greska pri pisanju fajla sa putanje \"" << path << "\"!" << std::endl;
+        return false;
+    }
+
+    // ------------------------------------------------------------------------
+    // Reading
+    // ------------------------------------------------------------------------
+    bool reportInvalidFile(RouteFile &file, const char *path) {
+        std::cout << "Fajl \"" << path << "\" nije ispravan fajl trase!" << std::endl;
+        closeRouteFile(file);
+        return false;
+    }
+
+    bool decodeVarints(const uint8_t *p, const size_t size, const uint32_t count, const double quantum,
+                       float *xs, float *ys) {
+        const uint8_t *end = p + size;
+        int32_t x = 0, y = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t dx, dy;
+            if (!readVarint(p, end, dx) || !readVarint(p, end, dy)) {
+                return false;
+            }
+            // Wrapping adds, corrupt data must not be undefined behaviour
+            x = static_cast<int32_t>(static_cast<uint32_t>(x) + static_cast<uint32_t>(decodeZigZag(dx)));
+            y = static_cast<int32_t>(static_cast<uint32_t>(y) + static_cast<uint32_t>(decodeZigZag(dy)));
+            xs[i] = static_cast<float>(x * quantum);
+            ys[i] = static_cast<float>(y * quantum);
+        }
+        return p == end;
+    }
+}
+
+// ============================================================================
+// SAVING
+// ============================================================================
+bool saveRouteFile(const char *path, const RouteStore &route, const Georeference &geo, const bool compress,
+                   RouteFileStats &stats) {
+    TRACE_SCOPE_DETAIL("saveRouteFile", "save", path);
+    const auto start = std::chrono::steady_clock::now();
+    stats = RouteFileStats{};
+
+    std::FILE *out = std::fopen(path, "wb");
+    if (!out) {
+        return reportWriteError(out, path);
+    }
+
+    // The header goes in last, once the index offset is known
+    uint8_t header[HEADER_SIZE] = {};
+    std::fwrite(header, 1, HEADER_SIZE, out);
+
+    BlockWriter writer;
+    writer.out = out;
+    writer.compress = compress;
+    writer.xs.resize(ROUTE_FILE_BLOCK_POINTS);
+    writer.ys.resize(ROUTE_FILE_BLOCK_POINTS);
+    writer.encoded.resize(MAX_ENCODED_SIZE);
+    writer.compressed.resize(lzBound(MAX_ENCODED_SIZE));
+    writer.index.reserve(route.size / ROUTE_FILE_BLOCK_POINTS + 1);
+
+    for (const uint32_t slot: route.order) {
+        const RouteBlock &block = route.blocks[slot];
+        for (uint32_t i = 0; i < block.count; ++i) {
+            writer.xs[writer.count] = quantise(block.xs[i], writer.scale);
+            writer.ys[writer.count] = quantise(block.ys[i], writer.scale);
+            if (++writer.count == ROUTE_FILE_BLOCK_POINTS) {
+                flushBlock(writer);
+            }
+        }
+    }
+    flushBlock(writer);
+
+    std::vector<uint8_t> index(writer.index.size() * INDEX_ENTRY_SIZE);
+    uint8_t *p = index.data();
+    for (const RouteFileBlock &entry: writer.index) {
+        p = putField(p, entry.offset);
+        p = putField(p, entry.storedSize);
+        p = putField(p, entry.encodedSize);
+        p = putField(p, entry.count);
+        p = putField(p, static_cast<uint32_t>(entry.compressed ? 1 : 0));
+        p = putField(p, entry.minX);
+        p = putField(p, entry.minY);
+        p = putField(p, entry.maxX);
+        p = putField(p, entry.maxY);
+    }
+    if (!index.empty()) {
+        std::fwrite(index.data(), 1, index.size(), out);
+    }
+
+    p = header;
+    std::memcpy(p, MAGIC, sizeof(MAGIC));
+    p += sizeof(MAGIC);
+    p = putField(p, VERSION);
+    p = putField(p, static_cast<uint16_t>(compress ? FLAG_COMPRESSED : 0));
+    p = putField(p, ROUTE_FILE_QUANTUM);
+    p = putField(p, geo.centreX);
+    p = putField(p, geo.centreY);
+    p = putField(p, static_cast<uint64_t>(route.size));
+    p = putField(p, static_cast<uint32_t>(writer.index.size()));
+    p = putField(p, static_cast<uint32_t>(ROUTE_FILE_BLOCK_POINTS));
+    p = putField(p, writer.offset);
+    putField(p, getRouteLength(route));
+    std::fseek(out, 0, SEEK_SET);
+    std::fwrite(header, 1, HEADER_SIZE, out);
+
+    if (std::ferror(out)) {
+        return reportWriteError(out, path);
+    }
+    if (std::fclose(out) != 0) {
+        return reportWriteError(nullptr, path);
+    }
+
+    stats.points = route.size;
+    stats.blocks = writer.index.size();
+    stats.bytes = writer.offset + index.size();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+// ============================================================================
+// LOADING
+// ============================================================================
+bool openRouteFile(RouteFile &file, const char *path, const Georeference &geo) {
+    TRACE_SCOPE_DETAIL("openRouteFile", "load", path);
+    file = RouteFile{};
+    if (!openMappedFile(file.mapped, path)) {
+        return false;
+    }
+
+    const auto *data = reinterpret_cast<const uint8_t *>(file.mapped.data);
+    const size_t size = file.mapped.size;
+    if (size < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        return reportInvalidFile(file, path);
+    }
+
+    const uint8_t *p = data + sizeof(MAGIC);
+    uint16_t version, flags;
+    uint32_t blockCount, blockPoints;
+    uint64_t indexOffset;
+    p = getField(p, version);
+    p = getField(p, flags);
+    p = getField(p, file.quantum);
+    p = getField(p, file.centreX);
+    p = getField(p, file.centreY);
+    p = getField(p, file.pointCount);
+    p = getField(p, blockCount);
+    p = getField(p, blockPoints);
+    p = getField(p, indexOffset);
+    getField(p, file.length);
+
+    if (version != VERSION || blockPoints > ROUTE_FILE_BLOCK_POINTS || !(file.quantum > 0.0) ||
+        indexOffset < HEADER_SIZE || indexOffset > size ||
+        static_cast<uint64_t>(blockCount) * INDEX_ENTRY_SIZE != size - indexOffset) {
+        return reportInvalidFile(file, path);
+    }
+
+    if (std::abs(file.centreX - geo.centreX) > CENTRE_TOLERANCE ||
+        std::abs(file.centreY - geo.centreY) > CENTRE_TOLERANCE) {
+        std::cout << "Trasa \"" << path << "\" je sacuvana na drugoj mapi!" << std::endl;
+        closeRouteFile(file);
+        return false;
+    }
+
+    // Blocks must lie between the header and the index and add up to the point count
+    file.blocks.resize(blockCount);
+    p = data + indexOffset;
+    uint64_t points = 0;
+    for (RouteFileBlock &entry: file.blocks) {
+        uint32_t blockFlags;
+        p = getField(p, entry.offset);
+        p = getField(p, entry.storedSize);
+        p = getField(p, entry.encodedSize);
+        p = getField(p, entry.count);
+        p = getField(p, blockFlags);
+        p = getField(p, entry.minX);
+        p = getField(p, entry.minY);
+        p = getField(p, entry.maxX);
+        p = getField(p, entry.maxY);
+        entry.compressed = (blockFlags & 1) != 0;
+
+        if (entry.offset < HEADER_SIZE || entry.offset > indexOffset ||
+            entry.storedSize > indexOffset - entry.offset || entry.count > blockPoints ||
+            entry.encodedSize > entry.count * 2 * MAX_VARINT_SIZE ||
+            (!entry.compressed && entry.storedSize != entry.encodedSize)) {
+            return reportInvalidFile(file, path);
+        }
+        points += entry.count;
+    }
+    if (points != file.pointCount) {
+        return reportInvalidFile(file, path);
+    }
+    return true;
+}
+
+void closeRouteFile(RouteFile &file) {
+    closeMappedFile(file.mapped);
+    file.blocks.clear();
+    file.pointCount = 0;
+}
+
+bool decodeRouteFileBlock(const RouteFile &file, const size_t block, float *xs, float *ys,
+                          std::vector<uint8_t> &scratch) {
+    const RouteFileBlock &entry = file.blocks[block];
+    const uint8_t *encoded = reinterpret_cast<const uint8_t *>(file.mapped.data) + entry.offset;
+
+    if (entry.compressed) {
+        scratch.resize(entry.encodedSize);
+        if (!decompressLz(encoded, entry.storedSize, scratch.data(), entry.encodedSize)) {
+            return false;
+        }
+        encoded = scratch.data();
+    }
+    return decodeVarints(encoded, entry.encodedSize, entry.count, file.quantum, xs, ys);
+}
+
+bool readRouteFile(const RouteFile &file, const TrackPointSink sink, void *context, RouteFileStats &stats) {
+    TRACE_SCOPE("readRouteFile", "load");
+    const auto start = std::chrono::steady_clock::now();
+    stats = RouteFileStats{};
+
+    std::vector<float> xs(ROUTE_FILE_BLOCK_POINTS), ys(ROUTE_FILE_BLOCK_POINTS);
+    std::vector<uint8_t> scratch(MAX_ENCODED_SIZE);
+    for (size_t block = 0; block < file.blocks.size(); ++block) {
+        if (!decodeRouteFileBlock(file, block, xs.data(), ys.data(), scratch)) {
+            return false;
+        }
+
+        const uint32_t count = file.blocks[block].count;
+        if (count > 0) {
+            sink(context, xs.data(), ys.data(), count);
+        }
+        stats.points += count;
+        ++stats.blocks;
+    }
+
+    stats.bytes = file.mapped.size;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,57 @@
+#include "../Header/RouteHistory.h"
+
+namespace {
+    RouteEdit &editAt(RouteHistory &history, const size_t position) {
+        return history.edits[(history.first + position) % history.edits.size()];
+    }
+
+    const RouteEdit &editAt(const RouteHistory &history, const size_t position) {
+        return history.edits[(history.first + position) % history.edits.size()];
+    }
+}
+
+void createRouteHistory(RouteHistory &history, const size_t capacity) {
+    history.edits.assign(capacity > 0 ? capacity : 1, RouteEdit{});
+    clearRouteHistory(history);
+}
+
+void clearRouteHistory(RouteHistory &history) {
+    history.first = 0;
+    history.undoCount = 0;
+    history.redoCount = 0;
+}
+
+void recordRouteEdit(RouteHistory &history, const RouteEdit &edit) {
+    history.redoCount = 0;
+    if (history.undoCount == history.edits.size()) {
+        history.first = (history.first + 1) % history.edits.size();
+        --history.undoCount;
+    }
+    editAt(history, history.undoCount++) = edit;
+}
+
+bool popUndoEdit(RouteHistory &history, RouteEdit &edit) {
+    if (history.undoCount == 0) {
+        return false;
+    }
+    edit = editAt(history, --history.undoCount);
+    ++history.redoCount;
+    return true;
+}
+
+bool popRedoEdit(RouteHistory &history, RouteEdit &edit) {
+    if (history.redoCount == 0) {
+        return false;
+    }
+    edit = editAt(history, history.undoCount++);
+    --history.redoCount;
+    return true;
+}
+
+bool peekRedoEdit(const RouteHistory &history, RouteEdit &edit) {
+    if (history.redoCount == 0) {
+        return false;
+    }
+    edit = editAt(history, history.undoCount);
+    return true;
+}
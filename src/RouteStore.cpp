@@ -0,0 +1,541 @@
+#include "../Header/RouteStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../Header/Simplify.h"
+
+static_assert(ROUTE_BLOCK_CAPACITY <= SIMPLIFY_MAX_POINTS, "route blocks are ranked in one go");
+
+namespace {
+    constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    uint32_t acquireSlot(RouteStore &store) {
+        if (!store.freeSlots.empty()) {
+            const uint32_t slot = store.freeSlots.back();
+            store.freeSlots.pop_back();
+            return slot;
+        }
+
+        store.blocks.emplace_back();
+        store.positionOf.push_back(0);
+        return static_cast<uint32_t>(store.blocks.size() - 1);
+    }
+
+    void releaseSlot(RouteStore &store, const uint32_t slot) {
+        store.blocks[slot].count = 0;
+        store.blocks[slot].length = 0.0;
+        store.freeSlots.push_back(slot);
+    }
+
+    void assignSlot(RouteStore &store, const uint32_t id, const uint32_t slot) {
+        if (id >= store.slotOfPoint.size()) {
+            store.slotOfPoint.resize(static_cast<size_t>(id) + 1, NO_SLOT);
+        }
+        store.slotOfPoint[id] = slot;
+    }
+
+    RouteBlock &blockAt(RouteStore &store, const size_t position) {
+        return store.blocks[store.order[position]];
+    }
+
+    const RouteBlock &blockAt(const RouteStore &store, const size_t position) {
+        return store.blocks[store.order[position]];
+    }
+
+    void writePoint(RouteBlock &block, const size_t offset, const Point &point) {
+        block.xs[offset] = point.x;
+        block.ys[offset] = point.y;
+        block.ids[offset] = point.id;
+        block.ranked = false;
+    }
+
+    // Copies count points from one block position to another, the ranges may overlap
+    void movePoints(RouteBlock &to, const size_t toOffset, const RouteBlock &from, const size_t fromOffset,
+                    const size_t count) {
+        std::memmove(to.xs + toOffset, from.xs + fromOffset, count * sizeof(float));
+        std::memmove(to.ys + toOffset, from.ys + fromOffset, count * sizeof(float));
+        std::memmove(to.ids + toOffset, from.ids + fromOffset, count * sizeof(uint32_t));
+        to.ranked = false;
+    }
+
+    double measurePolyline(const RouteStore &store, const float *xs, const float *ys, const size_t count) {
+        if (store.measure) {
+            return store.measure(store.measureContext, xs, ys, count);
+        }
+        return sumSegmentLengths(xs, ys, count);
+    }
+
+    double measureSegment(const RouteStore &store, const float x1, const float y1, const float x2, const float y2) {
+        const float xs[2] = {x1, x2};
+        const float ys[2] = {y1, y2};
+        return measurePolyline(store, xs, ys, 2);
+    }
+
+    // A segment is counted in the block holding its end point
+    void addBlockLength(RouteStore &store, const size_t position, const double delta) {
+        blockAt(store, position).length += delta;
+        addFenwick(store.lengths, position, delta);
+    }
+
+    double bridgeLength(const RouteStore &store, const size_t position) {
+        if (position == 0) {
+            return 0.0;
+        }
+
+        const RouteBlock &previous = blockAt(store, position - 1);
+        const RouteBlock &block = blockAt(store, position);
+        const float xs[2] = {previous.xs[previous.count - 1], block.xs[0]};
+        const float ys[2] = {previous.ys[previous.count - 1], block.ys[0]};
+        return measurePolyline(store, xs, ys, 2);
+    }
+
+    double computeBlockLength(const RouteStore &store, const size_t position) {
+        const RouteBlock &block = blockAt(store, position);
+        if (block.count == 0) {
+            return 0.0;
+        }
+        return bridgeLength(store, position) + measurePolyline(store, block.xs, block.ys, block.count);
+    }
+
+    // Cached length only, for blocks touched by a structural change that is followed by rebuildIndex
+    void setBlockLength(RouteStore &store, const size_t position) {
+        if (position < store.order.size()) {
+            blockAt(store, position).length = computeBlockLength(store, position);
+        }
+    }
+
+    void rebuildIndex(RouteStore &store) {
+        const size_t blockCount = store.order.size();
+        for (size_t position = 0; position < blockCount; ++position) {
+            store.positionOf[store.order[position]] = static_cast<uint32_t>(position);
+        }
+
+        buildFenwick(store.counts, blockCount, [&store](const size_t position) {
+            return static_cast<int64_t>(blockAt(store, position).count);
+        });
+        buildFenwick(store.lengths, blockCount, [&store](const size_t position) {
+            return blockAt(store, position).length;
+        });
+    }
+
+    void locate(const RouteStore &store, const size_t index, size_t &position, size_t &offset) {
+        position = findFenwick(store.counts, static_cast<int64_t>(index));
+        offset = index - static_cast<size_t>(prefixFenwick(store.counts, position));
+    }
+
+    // Moves the upper half of a full block into a new block right after it
+    void splitBlock(RouteStore &store, const size_t position) {
+        const uint32_t newSlot = acquireSlot(store);
+        RouteBlock &block = blockAt(store, position);
+        RouteBlock &upper = store.blocks[newSlot];
+
+        const uint32_t half = block.count / 2;
+        upper.count = block.count - half;
+        movePoints(upper, 0, block, half, upper.count);
+        block.count = half;
+        block.ranked = false;
+        for (uint32_t i = 0; i < upper.count; ++i) {
+            store.slotOfPoint[upper.ids[i]] = newSlot;
+        }
+
+        store.order.insert(store.order.begin() + static_cast<std::ptrdiff_t>(position) + 1, newSlot);
+        setBlockLength(store, position);
+        setBlockLength(store, position + 1);
+        rebuildIndex(store);
+    }
+
+    // Appends the block at position to the one before it and drops it
+    void mergeIntoPrevious(RouteStore &store, const size_t position) {
+        const uint32_t slot = store.order[position];
+        const uint32_t previousSlot = store.order[position - 1];
+        RouteBlock &previous = store.blocks[previousSlot];
+        const RouteBlock &block = store.blocks[slot];
+
+        movePoints(previous, previous.count, block, 0, block.count);
+        for (uint32_t i = 0; i < block.count; ++i) {
+            store.slotOfPoint[block.ids[i]] = previousSlot;
+        }
+        previous.count += block.count;
+
+        store.order.erase(store.order.begin() + static_cast<std::ptrdiff_t>(position));
+        releaseSlot(store, slot);
+        setBlockLength(store, position - 1);
+        setBlockLength(store, position);
+        rebuildIndex(store);
+    }
+
+    bool canMerge(const RouteStore &store, const size_t first, const size_t second) {
+        return blockAt(store, first).count + blockAt(store, second).count <= ROUTE_BLOCK_CAPACITY / 2;
+    }
+
+    // ------------------------------------------------------------------------
+    // Shoelace terms, in double so the products of float coordinates are exact
+    // ------------------------------------------------------------------------
+    double cross(const double x1, const double y1, const double x2, const double y2) {
+        return x1 * y2 - x2 * y1;
+    }
+
+    double cross(const Point &from, const Point &to) {
+        return cross(from.x, from.y, to.x, to.y);
+    }
+
+    Point firstPoint(const RouteStore &store) {
+        const RouteBlock &block = blockAt(store, 0);
+        return {block.xs[0], block.ys[0], block.ids[0]};
+    }
+
+    Point lastPoint(const RouteStore &store) {
+        const RouteBlock &block = blockAt(store, store.order.size() - 1);
+        return {block.xs[block.count - 1], block.ys[block.count - 1], block.ids[block.count - 1]};
+    }
+
+    // Change of the sum when point goes between previous and next, which are joined by an edge before
+    double splitCross(const Point &previous, const Point &point, const Point &next) {
+        return cross(previous, point) + cross(point, next) - cross(previous, next);
+    }
+
+    // Below three points the closed route has no area, snapping to zero keeps rounding from building up
+    void settleCrossSum(RouteStore &store) {
+        if (store.size < 3) {
+            store.crossSum = 0.0;
+        }
+    }
+}
+
+// ============================================================================
+// LIFETIME
+// ============================================================================
+void createRouteStore(RouteStore &store, const size_t reservedPoints) {
+    // Blocks are at least a quarter full after merges, split blocks start half full
+    const size_t reservedBlocks = reservedPoints / (ROUTE_BLOCK_CAPACITY / 4) + 2;
+
+    store.blocks.reserve(reservedBlocks);
+    store.positionOf.reserve(reservedBlocks);
+    store.freeSlots.reserve(reservedBlocks);
+    store.order.reserve(reservedBlocks);
+    store.slotOfPoint.reserve(reservedPoints);
+    store.counts.tree.reserve(reservedBlocks + 1);
+    store.lengths.tree.reserve(reservedBlocks + 1);
+
+    store.blocks.resize(reservedBlocks);
+    store.positionOf.resize(reservedBlocks, 0);
+    for (size_t i = reservedBlocks; i > 0; --i) {
+        store.freeSlots.push_back(static_cast<uint32_t>(i - 1));
+    }
+
+    clearRouteStore(store);
+}
+
+void clearRouteStore(RouteStore &store) {
+    for (const uint32_t slot: store.order) {
+        releaseSlot(store, slot);
+    }
+    store.order.clear();
+    store.size = 0;
+    store.crossSum = 0.0;
+    ++store.revision;
+    rebuildIndex(store);
+}
+
+void setRouteLengthFunction(RouteStore &store, const RouteLengthFunction measure, const void *context) {
+    store.measure = measure;
+    store.measureContext = context;
+    for (size_t position = 0; position < store.order.size(); ++position) {
+        setBlockLength(store, position);
+    }
+    rebuildIndex(store);
+}
+
+// ============================================================================
+// EDITING
+// ============================================================================
+void appendRoutePoint(RouteStore &store, const Point &point) {
+    ++store.revision;
+    if (store.size > 0) {
+        store.crossSum += splitCross(lastPoint(store), point, firstPoint(store));
+    }
+    if (store.order.empty() || blockAt(store, store.order.size() - 1).count >= ROUTE_BLOCK_CAPACITY) {
+        const uint32_t slot = acquireSlot(store);
+        store.order.push_back(slot);
+        writePoint(store.blocks[slot], 0, point);
+        store.blocks[slot].count = 1;
+        assignSlot(store, point.id, slot);
+        ++store.size;
+
+        setBlockLength(store, store.order.size() - 1);
+        rebuildIndex(store);
+        return;
+    }
+
+    const size_t position = store.order.size() - 1;
+    RouteBlock &block = blockAt(store, position);
+    writePoint(block, block.count++, point);
+    assignSlot(store, point.id, store.order[position]);
+    ++store.size;
+
+    // Only the new segment is measured, the rest of the block is unchanged
+    addFenwick<int64_t>(store.counts, position, 1);
+    addBlockLength(store, position, measurePolyline(store, block.xs + block.count - 2, block.ys + block.count - 2, 2));
+}
+
+void appendRoutePoints(RouteStore &store, const float *xs, const float *ys, const uint32_t *ids, const size_t count) {
+    if (count == 0) {
+        return;
+    }
+    ++store.revision;
+
+    // The closing edge moves from the old last point to the last new one
+    const Point batchFirst = {xs[0], ys[0], ids[0]};
+    const Point batchLast = {xs[count - 1], ys[count - 1], ids[count - 1]};
+    double crossDelta = 0.0;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        crossDelta += cross(xs[i], ys[i], xs[i + 1], ys[i + 1]);
+    }
+    if (store.size > 0) {
+        const Point first = firstPoint(store);
+        const Point last = lastPoint(store);
+        crossDelta += cross(last, batchFirst) + cross(batchLast, first) - cross(last, first);
+    } else {
+        crossDelta += cross(batchLast, batchFirst);
+    }
+    store.crossSum += crossDelta;
+
+    // The last block is topped up first, it is remeasured along with the new ones
+    size_t firstChanged = store.order.empty() ? 0 : store.order.size() - 1;
+    size_t copied = 0;
+    while (copied < count) {
+        if (store.order.empty() || blockAt(store, store.order.size() - 1).count >= ROUTE_BLOCK_CAPACITY) {
+            store.order.push_back(acquireSlot(store));
+        }
+
+        const uint32_t slot = store.order.back();
+        RouteBlock &block = store.blocks[slot];
+        const size_t take = std::min(count - copied, ROUTE_BLOCK_CAPACITY - block.count);
+        std::memcpy(block.xs + block.count, xs + copied, take * sizeof(float));
+        std::memcpy(block.ys + block.count, ys + copied, take * sizeof(float));
+        std::memcpy(block.ids + block.count, ids + copied, take * sizeof(uint32_t));
+        for (size_t i = 0; i < take; ++i) {
+            assignSlot(store, ids[copied + i], slot);
+        }
+        block.count += static_cast<uint32_t>(take);
+        block.ranked = false;
+        copied += take;
+    }
+    store.size += count;
+    settleCrossSum(store);
+
+    for (size_t position = firstChanged; position < store.order.size(); ++position) {
+        setBlockLength(store, position);
+    }
+    rebuildIndex(store);
+}
+
+void insertRoutePoint(RouteStore &store, const size_t index, const Point &point) {
+    if (index >= store.size) {
+        appendRoutePoint(store, point);
+        return;
+    }
+
+    ++store.revision;
+
+    // Going in front of the first point puts it on the closing edge
+    const Point previous = index > 0 ? getRoutePoint(store, index - 1) : lastPoint(store);
+    store.crossSum += splitCross(previous, point, getRoutePoint(store, index));
+
+    size_t position, offset;
+    locate(store, index, position, offset);
+    if (blockAt(store, position).count >= ROUTE_BLOCK_CAPACITY) {
+        splitBlock(store, position);
+        locate(store, index, position, offset);
+    }
+
+    RouteBlock &block = blockAt(store, position);
+    movePoints(block, offset + 1, block, offset, block.count - offset);
+    writePoint(block, offset, point);
+    ++block.count;
+    assignSlot(store, point.id, store.order[position]);
+    ++store.size;
+    addFenwick<int64_t>(store.counts, position, 1);
+
+    // Only the segments around the new point are measured: previous to new, new to next, minus previous to next
+    size_t nextPosition, nextOffset;
+    locate(store, index + 1, nextPosition, nextOffset);
+    const RouteBlock &nextBlock = blockAt(store, nextPosition);
+    const float nextX = nextBlock.xs[nextOffset];
+    const float nextY = nextBlock.ys[nextOffset];
+
+    double nextDelta = measureSegment(store, point.x, point.y, nextX, nextY);
+    if (index > 0) {
+        addBlockLength(store, position, measureSegment(store, previous.x, previous.y, point.x, point.y));
+        nextDelta -= measureSegment(store, previous.x, previous.y, nextX, nextY);
+    }
+    addBlockLength(store, nextPosition, nextDelta);
+}
+
+Point removeRoutePoint(RouteStore &store, const size_t index) {
+    ++store.revision;
+    size_t position, offset;
+    locate(store, index, position, offset);
+
+    // Neighbours along the closed route, the first and last point are joined
+    if (store.size > 1) {
+        const Point before = index > 0 ? getRoutePoint(store, index - 1) : lastPoint(store);
+        const Point after = index + 1 < store.size ? getRoutePoint(store, index + 1) : firstPoint(store);
+        const RouteBlock &block = blockAt(store, position);
+        store.crossSum -= splitCross(before, {block.xs[offset], block.ys[offset], block.ids[offset]}, after);
+    }
+
+    RouteBlock &block = blockAt(store, position);
+    const Point removed = {block.xs[offset], block.ys[offset], block.ids[offset]};
+    movePoints(block, offset, block, offset + 1, block.count - offset - 1);
+    --block.count;
+    --store.size;
+    settleCrossSum(store);
+
+    if (block.count == 0) {
+        releaseSlot(store, store.order[position]);
+        store.order.erase(store.order.begin() + static_cast<std::ptrdiff_t>(position));
+        setBlockLength(store, position);
+        rebuildIndex(store);
+        return removed;
+    }
+
+    // Every adjacent pair of blocks stays above half a block, so the trees stay short
+    if (position + 1 < store.order.size() && canMerge(store, position, position + 1)) {
+        mergeIntoPrevious(store, position + 1);
+        return removed;
+    }
+    if (position > 0 && canMerge(store, position - 1, position)) {
+        mergeIntoPrevious(store, position);
+        return removed;
+    }
+
+    addFenwick<int64_t>(store.counts, position, -1);
+
+    // The removed point's segments go, the one joining its neighbours comes in
+    Point previous{};
+    if (index > 0) {
+        previous = getRoutePoint(store, index - 1);
+        addBlockLength(store, position, -measureSegment(store, previous.x, previous.y, removed.x, removed.y));
+    }
+    if (index < store.size) {
+        size_t nextPosition, nextOffset;
+        locate(store, index, nextPosition, nextOffset);
+        const RouteBlock &nextBlock = blockAt(store, nextPosition);
+        const float nextX = nextBlock.xs[nextOffset];
+        const float nextY = nextBlock.ys[nextOffset];
+
+        double nextDelta = -measureSegment(store, removed.x, removed.y, nextX, nextY);
+        if (index > 0) {
+            nextDelta += measureSegment(store, previous.x, previous.y, nextX, nextY);
+        }
+        addBlockLength(store, nextPosition, nextDelta);
+    }
+    return removed;
+}
+
+// ============================================================================
+// QUERIES
+// ============================================================================
+Point getRoutePoint(const RouteStore &store, const size_t index) {
+    size_t position, offset;
+    locate(store, index, position, offset);
+
+    const RouteBlock &block = blockAt(store, position);
+    return {block.xs[offset], block.ys[offset], block.ids[offset]};
+}
+
+bool findRoutePoint(const RouteStore &store, const uint32_t id, size_t &index) {
+    if (id >= store.slotOfPoint.size() || store.slotOfPoint[id] == NO_SLOT) {
+        return false;
+    }
+
+    const uint32_t slot = store.slotOfPoint[id];
+    const RouteBlock &block = store.blocks[slot];
+    for (uint32_t offset = 0; offset < block.count; ++offset) {
+        if (block.ids[offset] == id) {
+            const size_t position = store.positionOf[slot];
+            index = static_cast<size_t>(prefixFenwick(store.counts, position)) + offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+double getRouteLength(const RouteStore &store) {
+    return prefixFenwick(store.lengths, store.order.size());
+}
+
+double getRouteDistanceTo(const RouteStore &store, const size_t index) {
+    size_t position, offset;
+    locate(store, index, position, offset);
+
+    const RouteBlock &block = blockAt(store, position);
+    return prefixFenwick(store.lengths, position) + bridgeLength(store, position) +
+           measurePolyline(store, block.xs, block.ys, offset + 1);
+}
+
+void computeRouteDistances(const RouteStore &store, double *distances) {
+    double distance = 0.0;
+    for (size_t position = 0; position < store.order.size(); ++position) {
+        const RouteBlock &block = blockAt(store, position);
+        distance += bridgeLength(store, position);
+        if (!store.measure) {
+            distance = accumulateDistances(block.xs, block.ys, block.count, distance, distances);
+            distances += block.count;
+            continue;
+        }
+
+        *distances++ = distance;
+        for (uint32_t i = 1; i < block.count; ++i) {
+            distance += store.measure(store.measureContext, block.xs + i - 1, block.ys + i - 1, 2);
+            *distances++ = distance;
+        }
+    }
+}
+
+bool findNearestRoutePoint(const RouteStore &store, const float x, const float y, size_t &index) {
+    bool found = false;
+    float nearestDistance = 0.0f;
+    size_t first = 0;
+
+    for (const uint32_t slot: store.order) {
+        const RouteBlock &block = store.blocks[slot];
+        float distance;
+        const int64_t offset = findNearestPoint(block.xs, block.ys, block.count, x, y, distance);
+        if (offset >= 0 && (!found || distance < nearestDistance)) {
+            found = true;
+            nearestDistance = distance;
+            index = first + static_cast<size_t>(offset);
+        }
+        first += block.count;
+    }
+    return found;
+}
+
+double getRouteSignedArea(const RouteStore &store) {
+    return store.crossSum * 0.5;
+}
+
+PointBounds getRouteBounds(const RouteStore &store) {
+    PointBounds bounds = emptyBounds();
+    for (const uint32_t slot: store.order) {
+        const RouteBlock &block = store.blocks[slot];
+        expandBounds(block.xs, block.ys, block.count, bounds);
+    }
+    return bounds;
+}
+
+// ============================================================================
+// LEVEL OF DETAIL
+// ============================================================================
+void rankRouteBlocks(RouteStore &store) {
+    for (const uint32_t slot: store.order) {
+        RouteBlock &block = store.blocks[slot];
+        if (!block.ranked) {
+            rankVisvalingam(block.xs, block.ys, block.count, block.ranks);
+            block.ranked = true;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#include "../Header/SceneTarget.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    void allocateSceneTarget(SceneTarget &target, const int width, const int height) {
+        if (!target.framebuffer) {
+            glGenFramebuffers(1, &target.framebuffer);
+            glGenTextures(1, &target.colorTexture);
+            glGenRenderbuffers(1, &target.stencilRenderbuffer);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, target.colorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, target.stencilRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.colorTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                                  target.stencilRenderbuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        target.textureWidth = width;
+        target.textureHeight = height;
+    }
+}
+
+void destroySceneTarget(SceneTarget &target) {
+    glDeleteFramebuffers(1, &target.framebuffer);
+    glDeleteTextures(1, &target.colorTexture);
+    glDeleteRenderbuffers(1, &target.stencilRenderbuffer);
+    target.framebuffer = 0;
+    target.colorTexture = 0;
+    target.stencilRenderbuffer = 0;
+}
+
+void bindSceneTarget(SceneTarget &target, const int framebufferWidth, const int framebufferHeight) {
+    if (framebufferWidth != target.textureWidth || framebufferHeight != target.textureHeight) {
+        allocateSceneTarget(target, framebufferWidth, framebufferHeight);
+    }
+
+    target.width = std::max(1, static_cast<int>(std::lround(framebufferWidth * target.scale)));
+    target.height = std::max(1, static_cast<int>(std::lround(framebufferHeight * target.scale)));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glViewport(0, 0, target.width, target.height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
+
+void resolveSceneTarget(const SceneTarget &target, const unsigned int outputFramebuffer,
+                        const int framebufferWidth, const int framebufferHeight) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+    glBlitFramebuffer(0, 0, target.width, target.height,
+                      0, 0, framebufferWidth, framebufferHeight,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+}
+
+void updateResolutionScale(SceneTarget &target, const ResolutionPolicy &policy, const double gpuFrameMs) {
+    // Pixel cost scales with area, so the side length is adjusted by the square root of the ratio.
+    // A dead band between 75% and 95% of the budget keeps the scale from oscillating every frame.
+    if (gpuFrameMs > policy.budgetMs * 0.95) {
+        const double ratio = std::sqrt(policy.budgetMs * 0.85 / gpuFrameMs);
+        target.scale *= static_cast<float>(std::max(ratio, 0.85));
+    } else if (gpuFrameMs < policy.budgetMs * 0.75) {
+        target.scale *= 1.02f;
+    }
+
+    target.scale = std::clamp(target.scale, policy.minScale, policy.maxScale);
+}
@@ -0,0 +1,184 @@
+#include "../Header/SegmentGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr size_t MAX_LEVELS = 32;
+
+    int clampCell(const float coordinate, const float origin, const float cellSize, const int cells) {
+        const int cell = static_cast<int>(std::floor((coordinate - origin) / cellSize));
+        return std::clamp(cell, 0, cells - 1);
+    }
+
+    void ensureIdCapacity(SegmentGrid &grid, const uint32_t id) {
+        if (id < grid.cellOf.size()) {
+            return;
+        }
+
+        const size_t size = static_cast<size_t>(id) + 1;
+        grid.next.resize(size, -1);
+        grid.previous.resize(size, -1);
+        grid.cellOf.resize(size, -1);
+        grid.levelOf.resize(size, 0);
+        grid.x1s.resize(size, 0.0f);
+        grid.y1s.resize(size, 0.0f);
+        grid.x2s.resize(size, 0.0f);
+        grid.y2s.resize(size, 0.0f);
+    }
+
+    // Finest level whose cells are at least as long as the segment, the last one takes the rest
+    size_t levelForLength(const SegmentGrid &grid, const float length) {
+        for (size_t level = 0; level + 1 < grid.levels.size(); ++level) {
+            if (length <= grid.levels[level].cellSize) {
+                return level;
+            }
+        }
+        return grid.levels.size() - 1;
+    }
+
+    float segmentDistanceSquared(const SegmentGrid &grid, const int32_t id, const float x, const float y) {
+        const float x1 = grid.x1s[id], y1 = grid.y1s[id];
+        const float dx = grid.x2s[id] - x1;
+        const float dy = grid.y2s[id] - y1;
+        const float lengthSquared = dx * dx + dy * dy;
+
+        float t = 0.0f;
+        if (lengthSquared > 0.0f) {
+            t = std::clamp(((x - x1) * dx + (y - y1) * dy) / lengthSquared, 0.0f, 1.0f);
+        }
+        const float ex = x1 + t * dx - x;
+        const float ey = y1 + t * dy - y;
+        return ex * ex + ey * ey;
+    }
+}
+
+void createSegmentGrid(SegmentGrid &grid, const float minX, const float minY, const float maxX, const float maxY,
+                       const float finestCellSize, const size_t reservedIds) {
+    grid.minX = minX;
+    grid.minY = minY;
+    grid.levels.clear();
+
+    size_t cellCount = 0;
+    float cellSize = finestCellSize;
+    while (grid.levels.size() < MAX_LEVELS) {
+        SegmentGridLevel level;
+        level.cellSize = cellSize;
+        level.columns = std::max(1, static_cast<int>(std::ceil((maxX - minX) / cellSize)));
+        level.rows = std::max(1, static_cast<int>(std::ceil((maxY - minY) / cellSize)));
+        level.firstCell = cellCount;
+        grid.levels.push_back(level);
+
+        cellCount += static_cast<size_t>(level.columns) * level.rows;
+        if (level.columns == 1 && level.rows == 1) {
+            break;
+        }
+        cellSize *= 2.0f;
+    }
+    grid.cellHeads.assign(cellCount, -1);
+
+    grid.next.reserve(reservedIds);
+    grid.previous.reserve(reservedIds);
+    grid.cellOf.reserve(reservedIds);
+    grid.levelOf.reserve(reservedIds);
+    grid.x1s.reserve(reservedIds);
+    grid.y1s.reserve(reservedIds);
+    grid.x2s.reserve(reservedIds);
+    grid.y2s.reserve(reservedIds);
+    grid.count = 0;
+}
+
+void clearSegmentGrid(SegmentGrid &grid) {
+    std::fill(grid.cellHeads.begin(), grid.cellHeads.end(), -1);
+    std::fill(grid.cellOf.begin(), grid.cellOf.end(), -1);
+    for (SegmentGridLevel &level: grid.levels) {
+        level.count = 0;
+    }
+    grid.count = 0;
+}
+
+void insertSegment(SegmentGrid &grid, const uint32_t id, const float x1, const float y1, const float x2,
+                   const float y2) {
+    ensureIdCapacity(grid, id);
+    if (grid.cellOf[id] >= 0) {
+        removeSegment(grid, id);
+    }
+
+    const size_t levelIndex = levelForLength(grid, std::hypot(x2 - x1, y2 - y1));
+    SegmentGridLevel &level = grid.levels[levelIndex];
+    const float midX = (x1 + x2) * 0.5f;
+    const float midY = (y1 + y2) * 0.5f;
+    const int cell = static_cast<int>(level.firstCell) +
+                     clampCell(midY, grid.minY, level.cellSize, level.rows) * level.columns +
+                     clampCell(midX, grid.minX, level.cellSize, level.columns);
+    const int32_t head = grid.cellHeads[cell];
+
+    grid.x1s[id] = x1;
+    grid.y1s[id] = y1;
+    grid.x2s[id] = x2;
+    grid.y2s[id] = y2;
+    grid.cellOf[id] = cell;
+    grid.levelOf[id] = static_cast<uint8_t>(levelIndex);
+    grid.previous[id] = -1;
+    grid.next[id] = head;
+    if (head >= 0) {
+        grid.previous[head] = static_cast<int32_t>(id);
+    }
+    grid.cellHeads[cell] = static_cast<int32_t>(id);
+    ++level.count;
+    ++grid.count;
+}
+
+void removeSegment(SegmentGrid &grid, const uint32_t id) {
+    if (id >= grid.cellOf.size() || grid.cellOf[id] < 0) {
+        return;
+    }
+
+    const int32_t before = grid.previous[id];
+    const int32_t after = grid.next[id];
+    if (before >= 0) {
+        grid.next[before] = after;
+    } else {
+        grid.cellHeads[grid.cellOf[id]] = after;
+    }
+    if (after >= 0) {
+        grid.previous[after] = before;
+    }
+
+    grid.cellOf[id] = -1;
+    --grid.levels[grid.levelOf[id]].count;
+    --grid.count;
+}
+
+int32_t findNearestSegment(const SegmentGrid &grid, const float x, const float y, const float radius) {
+    int32_t nearest = -1;
+    float nearestDistance = radius * radius;
+
+    for (const SegmentGridLevel &level: grid.levels) {
+        if (level.count == 0) {
+            continue;
+        }
+
+        // A segment within radius has its midpoint within radius plus half a cell
+        const float reach = radius + level.cellSize * 0.5f;
+        const int firstColumn = clampCell(x - reach, grid.minX, level.cellSize, level.columns);
+        const int lastColumn = clampCell(x + reach, grid.minX, level.cellSize, level.columns);
+        const int firstRow = clampCell(y - reach, grid.minY, level.cellSize, level.rows);
+        const int lastRow = clampCell(y + reach, grid.minY, level.cellSize, level.rows);
+
+        for (int row = firstRow; row <= lastRow; ++row) {
+            const size_t rowStart = level.firstCell + static_cast<size_t>(row) * level.columns;
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                for (int32_t id = grid.cellHeads[rowStart + column]; id >= 0; id = grid.next[id]) {
+                    const float distance = segmentDistanceSquared(grid, id, x, y);
+                    if (distance < nearestDistance) {
+                        nearestDistance = distance;
+                        nearest = id;
+                    }
+                }
+            }
+        }
+    }
+
+    return nearest;
+}
@@ -0,0 +1,138 @@
+#include "../Header/Simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+    // Min-heap of vertex indices keyed by area, with each vertex's heap slot for updates
+    struct AreaHeap {
+        uint16_t items[SIMPLIFY_MAX_POINTS];
+        uint16_t slotOf[SIMPLIFY_MAX_POINTS];
+        float areas[SIMPLIFY_MAX_POINTS];
+        size_t size = 0;
+    };
+
+    void placeItem(AreaHeap &heap, const size_t slot, const uint16_t item) {
+        heap.items[slot] = item;
+        heap.slotOf[item] = static_cast<uint16_t>(slot);
+    }
+
+    void siftUp(AreaHeap &heap, size_t slot) {
+        const uint16_t item = heap.items[slot];
+        while (slot > 0) {
+            const size_t parent = (slot - 1) / 2;
+            if (heap.areas[heap.items[parent]] <= heap.areas[item]) {
+                break;
+            }
+            placeItem(heap, slot, heap.items[parent]);
+            slot = parent;
+        }
+        placeItem(heap, slot, item);
+    }
+
+    void siftDown(AreaHeap &heap, size_t slot) {
+        const uint16_t item = heap.items[slot];
+        while (true) {
+            size_t child = slot * 2 + 1;
+            if (child >= heap.size) {
+                break;
+            }
+            if (child + 1 < heap.size && heap.areas[heap.items[child + 1]] < heap.areas[heap.items[child]]) {
+                ++child;
+            }
+            if (heap.areas[heap.items[child]] >= heap.areas[item]) {
+                break;
+            }
+            placeItem(heap, slot, heap.items[child]);
+            slot = child;
+        }
+        placeItem(heap, slot, item);
+    }
+
+    void pushItem(AreaHeap &heap, const uint16_t item, const float area) {
+        heap.areas[item] = area;
+        placeItem(heap, heap.size++, item);
+        siftUp(heap, heap.size - 1);
+    }
+
+    uint16_t popItem(AreaHeap &heap) {
+        const uint16_t top = heap.items[0];
+        if (--heap.size > 0) {
+            placeItem(heap, 0, heap.items[heap.size]);
+            siftDown(heap, 0);
+        }
+        return top;
+    }
+
+    void updateItem(AreaHeap &heap, const uint16_t item, const float area) {
+        heap.areas[item] = area;
+        siftUp(heap, heap.slotOf[item]);
+        siftDown(heap, heap.slotOf[item]);
+    }
+
+    // Differences are taken in double, route coordinates can sit far from their origin
+    float triangleArea(const float *xs, const float *ys, const size_t a, const size_t b, const size_t c) {
+        const double abX = static_cast<double>(xs[b]) - xs[a];
+        const double abY = static_cast<double>(ys[b]) - ys[a];
+        const double acX = static_cast<double>(xs[c]) - xs[a];
+        const double acY = static_cast<double>(ys[c]) - ys[a];
+        return static_cast<float>(std::abs(abX * acY - abY * acX) * 0.5);
+    }
+}
+
+void rankVisvalingam(const float *xs, const float *ys, const size_t count, float *ranks) {
+    if (count == 0) {
+        return;
+    }
+
+    ranks[0] = std::numeric_limits<float>::infinity();
+    ranks[count - 1] = std::numeric_limits<float>::infinity();
+    if (count < 3) {
+        return;
+    }
+
+    // Neighbours of the vertices still in the line
+    uint16_t previous[SIMPLIFY_MAX_POINTS], next[SIMPLIFY_MAX_POINTS];
+    AreaHeap heap;
+    for (size_t i = 1; i + 1 < count; ++i) {
+        previous[i] = static_cast<uint16_t>(i - 1);
+        next[i] = static_cast<uint16_t>(i + 1);
+        pushItem(heap, static_cast<uint16_t>(i), triangleArea(xs, ys, i - 1, i, i + 1));
+    }
+    previous[count - 1] = static_cast<uint16_t>(count - 2);
+    next[0] = 1;
+
+    float lastRank = 0.0f;
+    while (heap.size > 0) {
+        const uint16_t i = popItem(heap);
+        // A vertex that became cheaper after its neighbour went is still ranked after it
+        lastRank = std::max(lastRank, heap.areas[i]);
+        ranks[i] = lastRank;
+
+        const uint16_t before = previous[i];
+        const uint16_t after = next[i];
+        next[before] = after;
+        previous[after] = before;
+        if (before > 0) {
+            updateItem(heap, before, triangleArea(xs, ys, previous[before], before, after));
+        }
+        if (after < count - 1) {
+            updateItem(heap, after, triangleArea(xs, ys, before, after, next[after]));
+        }
+    }
+}
+
+size_t selectRankedPoints(const float *xs, const float *ys, const float *ranks, const size_t count,
+                          const float minRank, float *xys) {
+    size_t written = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (ranks[i] >= minRank) {
+            xys[written * 2] = xs[i];
+            xys[written * 2 + 1] = ys[i];
+            ++written;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,115 @@
+#include "../Header/SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    int clampCell(const float coordinate, const float origin, const float cellSize, const int cells) {
+        const int cell = static_cast<int>(std::floor((coordinate - origin) / cellSize));
+        return std::clamp(cell, 0, cells - 1);
+    }
+
+    void ensureIdCapacity(SpatialGrid &grid, const uint32_t id) {
+        if (id < grid.cellOf.size()) {
+            return;
+        }
+
+        const size_t size = static_cast<size_t>(id) + 1;
+        grid.next.resize(size, -1);
+        grid.previous.resize(size, -1);
+        grid.cellOf.resize(size, -1);
+        grid.xs.resize(size, 0.0f);
+        grid.ys.resize(size, 0.0f);
+    }
+}
+
+void createSpatialGrid(SpatialGrid &grid, const float minX, const float minY, const float maxX, const float maxY,
+                       const float cellSize, const size_t reservedIds) {
+    grid.minX = minX;
+    grid.minY = minY;
+    grid.cellSize = cellSize;
+    grid.columns = std::max(1, static_cast<int>(std::ceil((maxX - minX) / cellSize)));
+    grid.rows = std::max(1, static_cast<int>(std::ceil((maxY - minY) / cellSize)));
+    grid.cellHeads.assign(static_cast<size_t>(grid.columns) * grid.rows, -1);
+
+    grid.next.reserve(reservedIds);
+    grid.previous.reserve(reservedIds);
+    grid.cellOf.reserve(reservedIds);
+    grid.xs.reserve(reservedIds);
+    grid.ys.reserve(reservedIds);
+    grid.count = 0;
+}
+
+void clearSpatialGrid(SpatialGrid &grid) {
+    std::fill(grid.cellHeads.begin(), grid.cellHeads.end(), -1);
+    std::fill(grid.cellOf.begin(), grid.cellOf.end(), -1);
+    grid.count = 0;
+}
+
+void insertIntoGrid(SpatialGrid &grid, const uint32_t id, const float x, const float y) {
+    ensureIdCapacity(grid, id);
+    if (grid.cellOf[id] >= 0) {
+        removeFromGrid(grid, id);
+    }
+
+    const int cell = clampCell(y, grid.minY, grid.cellSize, grid.rows) * grid.columns +
+                     clampCell(x, grid.minX, grid.cellSize, grid.columns);
+    const int32_t head = grid.cellHeads[cell];
+
+    grid.xs[id] = x;
+    grid.ys[id] = y;
+    grid.cellOf[id] = cell;
+    grid.previous[id] = -1;
+    grid.next[id] = head;
+    if (head >= 0) {
+        grid.previous[head] = static_cast<int32_t>(id);
+    }
+    grid.cellHeads[cell] = static_cast<int32_t>(id);
+    ++grid.count;
+}
+
+void removeFromGrid(SpatialGrid &grid, const uint32_t id) {
+    if (id >= grid.cellOf.size() || grid.cellOf[id] < 0) {
+        return;
+    }
+
+    const int32_t before = grid.previous[id];
+    const int32_t after = grid.next[id];
+    if (before >= 0) {
+        grid.next[before] = after;
+    } else {
+        grid.cellHeads[grid.cellOf[id]] = after;
+    }
+    if (after >= 0) {
+        grid.previous[after] = before;
+    }
+
+    grid.cellOf[id] = -1;
+    --grid.count;
+}
+
+int32_t findNearestInGrid(const SpatialGrid &grid, const float x, const float y, const float radius) {
+    const int firstColumn = clampCell(x - radius, grid.minX, grid.cellSize, grid.columns);
+    const int lastColumn = clampCell(x + radius, grid.minX, grid.cellSize, grid.columns);
+    const int firstRow = clampCell(y - radius, grid.minY, grid.cellSize, grid.rows);
+    const int lastRow = clampCell(y + radius, grid.minY, grid.cellSize, grid.rows);
+
+    int32_t nearest = -1;
+    float nearestDistance = radius * radius;
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            for (int32_t id = grid.cellHeads[row * grid.columns + column]; id >= 0; id = grid.next[id]) {
+                const float dx = grid.xs[id] - x;
+                const float dy = grid.ys[id] - y;
+                const float distance = dx * dx + dy * dy;
+                if (distance < nearestDistance) {
+                    nearestDistance = distance;
+                    nearest = id;
+                }
+            }
+        }
+    }
+
+    return nearest;
+}
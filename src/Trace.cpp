@@ -0,0 +1,171 @@
+#include "../Header/Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+std::atomic<bool> traceEnabled{false};
+
+static std::chrono::steady_clock::time_point traceStart;
+static std::atomic<TraceBuffer *> traceBuffers{nullptr};
+static std::atomic<int> nextTraceThreadId{1};
+static thread_local TraceBuffer *localTraceBuffer = nullptr;
+
+// ============================================================================
+// BUFFERS
+// ============================================================================
+// Buffers are allocated on a thread's first event and pushed onto a lock-free
+// list. They are never freed, a thread may exit before the trace is written.
+static void registerTraceBuffer(TraceBuffer *buffer) {
+    TraceBuffer *head = traceBuffers.load(std::memory_order_relaxed);
+    do {
+        buffer->next = head;
+    } while (!traceBuffers.compare_exchange_weak(head, buffer, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+}
+
+static TraceBuffer &getLocalTraceBuffer() {
+    if (!localTraceBuffer) {
+        localTraceBuffer = new TraceBuffer();
+        localTraceBuffer->threadId = nextTraceThreadId.fetch_add(1, std::memory_order_relaxed);
+        registerTraceBuffer(localTraceBuffer);
+    }
+    return *localTraceBuffer;
+}
+
+static void appendTraceEvent(const char *name, const char *category, const TracePhase phase,
+                             const double value, const char *detail) {
+    TraceBuffer &buffer = getLocalTraceBuffer();
+    const size_t index = buffer.count.load(std::memory_order_relaxed);
+    if (index >= TraceBuffer::CAPACITY) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent &event = buffer.events[index];
+    event.name = name;
+    event.category = category;
+    event.phase = phase;
+    event.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - traceStart).count();
+    event.value = value;
+    event.detail[0] = '\0';
+    if (detail) {
+        std::strncpy(event.detail, detail, sizeof(event.detail) - 1);
+        event.detail[sizeof(event.detail) - 1] = '\0';
+    }
+
+    // Publish after the event is fully written, the writer reads up to count
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+// ============================================================================
+// RECORDING
+// ============================================================================
+void startTrace() {
+    traceStart = std::chrono::steady_clock::now();
+    traceEnabled.store(true, std::memory_order_relaxed);
+}
+
+void setTraceThreadName(const char *name) {
+    // Naming a thread creates its buffer, which only a recording thread needs
+    if (traceEnabled.load(std::memory_order_relaxed)) {
+        getLocalTraceBuffer().threadName = name;
+    }
+}
+
+void beginTraceSlice(const char *name, const char *category, const char *detail) {
+    if (traceEnabled.load(std::memory_order_relaxed)) {
+        appendTraceEvent(name, category, TracePhase::Begin, 0.0, detail);
+    }
+}
+
+void endTraceSlice(const char *name, const char *category) {
+    if (traceEnabled.load(std::memory_order_relaxed)) {
+        appendTraceEvent(name, category, TracePhase::End, 0.0, nullptr);
+    }
+}
+
+void recordTraceCounter(const char *name, const char *category, const double value) {
+    if (traceEnabled.load(std::memory_order_relaxed)) {
+        appendTraceEvent(name, category, TracePhase::Counter, value, nullptr);
+    }
+}
+
+// ============================================================================
+// JSON OUTPUT
+// ============================================================================
+static void writeJsonString(FILE *file, const char *text) {
+    std::fputc('"', file);
+    for (const char *c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            std::fputc('\\', file);
+            std::fputc(*c, file);
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            std::fprintf(file, "\\u%04x", *c);
+        } else {
+            std::fputc(*c, file);
+        }
+    }
+    std::fputc('"', file);
+}
+
+static void writeTraceEvent(FILE *file, const TraceEvent &event, const int threadId) {
+    std::fputs("{\"name\":", file);
+    writeJsonString(file, event.name);
+    std::fputs(",\"cat\":", file);
+    writeJsonString(file, event.category);
+    std::fprintf(file, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+                 static_cast<char>(event.phase), static_cast<double>(event.timestampNs) / 1000.0, threadId);
+
+    if (event.phase == TracePhase::Counter) {
+        std::fprintf(file, ",\"args\":{\"ms\":%.4f}", event.value);
+    } else if (event.detail[0]) {
+        std::fputs(",\"args\":{\"detail\":", file);
+        writeJsonString(file, event.detail);
+        std::fputc('}', file);
+    }
+    std::fputc('}', file);
+}
+
+bool writeTrace(const char *path) {
+    traceEnabled.store(false, std::memory_order_relaxed);
+
+    FILE *file = std::fopen(path, "w");
+    if (!file) {
+        std::cout << "Greska pri pisanju fajla sa putanje \"" << path << "\"!" << std::endl;
+        return false;
+    }
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    size_t dropped = 0;
+
+    for (const TraceBuffer *buffer = traceBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        if (buffer->threadName) {
+            std::fputs(first ? "" : ",\n", file);
+            std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                         buffer->threadId);
+            writeJsonString(file, buffer->threadName);
+            std::fputs("}}", file);
+            first = false;
+        }
+
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            std::fputs(first ? "" : ",\n", file);
+            writeTraceEvent(file, buffer->events[i], buffer->threadId);
+            first = false;
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+
+    std::fputs("\n]}\n", file);
+    std::fclose(file);
+
+    if (dropped > 0) {
+        std::cout << "Trace: " << dropped << " dogadjaja odbaceno, bafer je pun." << std::endl;
+    }
+    return true;
+}
@@ -0,0 +1,396 @@
+#include "../Header/TrackImport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../Header/MappedFile.h"
+#include "../Header/Trace.h"
+
+namespace {
+    constexpr size_t CHUNK_SIZE = 4 << 20;
+    constexpr size_t MAX_WORKERS = 16;
+    constexpr size_t CHUNKS_PER_WORKER = 2; // In flight, parsed but not yet taken by the sink
+
+    enum class TrackFormat {
+        Gpx,
+        Csv
+    };
+
+    struct CsvLayout {
+        char delimiter = ',';
+        int latitudeColumn = 0;
+        int longitudeColumn = 1;
+        size_t dataStart = 0; // First byte after the header row
+    };
+
+    // Parsed output of one chunk, reused by every chunk that maps to the same slot
+    struct ChunkSlot {
+        std::vector<double> longitudes, latitudes;
+        std::vector<float> xs, ys;
+        size_t skipped = 0;
+        bool ready = false;
+    };
+
+    struct ImportJob {
+        const MappedFile *file = nullptr;
+        const Georeference *geo = nullptr;
+        TrackFormat format = TrackFormat::Csv;
+        CsvLayout layout;
+        size_t chunkCount = 0;
+
+        std::vector<ChunkSlot> slots;
+        std::atomic<size_t> nextChunk{0};
+        size_t delivered = 0; // Chunks handed to the sink, guarded by mutex
+        std::mutex mutex;
+        std::condition_variable changed;
+    };
+
+    // ------------------------------------------------------------------------
+    // Tokenizer
+    // ------------------------------------------------------------------------
+    bool isSpace(const char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Leading blanks and quotes are skipped, whatever follows the number is ignored
+    bool parseNumber(const char *begin, const char *end, double &value) {
+        while (begin < end && (*begin == ' ' || *begin == '"' || *begin == '\'')) {
+            ++begin;
+        }
+        // from_chars takes no plus sign
+        if (begin < end && *begin == '+') {
+            ++begin;
+        }
+        return std::from_chars(begin, end, value).ec == std::errc{};
+    }
+
+    // from_chars also reads nan and inf, which would reach the map as NaN metres
+    bool isValidPosition(const double latitude, const double longitude) {
+        return std::isfinite(latitude) && std::isfinite(longitude) && std::abs(latitude) <= 90.0 &&
+               std::abs(longitude) <= 180.0;
+    }
+
+    const char *findLineEnd(const char *p, const char *end) {
+        const auto *newline = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        return newline ? newline : end;
+    }
+
+    std::string_view trimField(const char *begin, const char *end) {
+        while (begin < end && (isSpace(*begin) || *begin == '"')) {
+            ++begin;
+        }
+        while (end > begin && (isSpace(end[-1]) || end[-1] == '"')) {
+            --end;
+        }
+        return {begin, static_cast<size_t>(end - begin)};
+    }
+
+    bool equalsIgnoringCase(const std::string_view text, const char *name) {
+        const size_t length = std::strlen(name);
+        if (text.size() != length) {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            if (std::tolower(static_cast<unsigned char>(text[i])) != name[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // ------------------------------------------------------------------------
+    // Format detection
+    // ------------------------------------------------------------------------
+    TrackFormat detectFormat(const MappedFile &file) {
+        size_t i = 0;
+        // UTF-8 byte order mark
+        if (file.size >= 3 && std::memcmp(file.data, "\xEF\xBB\xBF", 3) == 0) {
+            i = 3;
+        }
+        while (i < file.size && isSpace(file.data[i])) {
+            ++i;
+        }
+        return i < file.size && file.data[i] == '<' ? TrackFormat::Gpx : TrackFormat::Csv;
+    }
+
+    bool detectCsvLayout(const MappedFile &file, CsvLayout &layout) {
+        const char *begin = file.data;
+        const char *end = file.data + file.size;
+        if (file.size >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+            begin += 3;
+        }
+        const char *lineEnd = findLineEnd(begin, end);
+
+        bool hasLetters = false;
+        for (const char *p = begin; p < lineEnd; ++p) {
+            if (*p == ';' || *p == '\t') {
+                layout.delimiter = *p;
+            }
+            // e and E also appear in exponents, a header has other letters as well
+            if (std::isalpha(static_cast<unsigned char>(*p)) && *p != 'e' && *p != 'E') {
+                hasLetters = true;
+            }
+        }
+        layout.dataStart = static_cast<size_t>(begin - file.data);
+        if (!hasLetters) {
+            return true;
+        }
+
+        layout.latitudeColumn = -1;
+        layout.longitudeColumn = -1;
+        int column = 0;
+        for (const char *field = begin; field <= lineEnd; ++column) {
+            const char *fieldEnd = field;
+            while (fieldEnd < lineEnd && *fieldEnd != layout.delimiter) {
+                ++fieldEnd;
+            }
+
+            const std::string_view name = trimField(field, fieldEnd);
+            if (equalsIgnoringCase(name, "lat") || equalsIgnoringCase(name, "latitude")) {
+                layout.latitudeColumn = column;
+            } else if (equalsIgnoringCase(name, "lon") || equalsIgnoringCase(name, "lng") ||
+                       equalsIgnoringCase(name, "long") || equalsIgnoringCase(name, "longitude")) {
+                layout.longitudeColumn = column;
+            }
+            field = fieldEnd + 1;
+        }
+        layout.dataStart = static_cast<size_t>(std::min(lineEnd + 1, end) - file.data);
+        return layout.latitudeColumn >= 0 && layout.longitudeColumn >= 0;
+    }
+
+    // ------------------------------------------------------------------------
+    // Chunk parsers
+    // ------------------------------------------------------------------------
+    // A chunk owns the records that start inside it and reads past its end to finish the last one
+    void parseCsvChunk(const ImportJob &job, const char *begin, const char *end, ChunkSlot &slot) {
+        const char *fileEnd = job.file->data + job.file->size;
+        const CsvLayout &layout = job.layout;
+        const int lastColumn = std::max(layout.latitudeColumn, layout.longitudeColumn);
+
+        // Skip the line that started in the previous chunk
+        const char *line = begin;
+        if (begin > job.file->data + layout.dataStart && begin[-1] != '\n') {
+            line = findLineEnd(begin, fileEnd) + 1;
+        }
+
+        while (line < end) {
+            const char *lineEnd = findLineEnd(line, fileEnd);
+            double latitude = 0.0, longitude = 0.0;
+            bool hasLatitude = false, hasLongitude = false;
+
+            const char *field = line;
+            for (int column = 0; column <= lastColumn && field <= lineEnd; ++column) {
+                const char *fieldEnd = field;
+                while (fieldEnd < lineEnd && *fieldEnd != layout.delimiter) {
+                    ++fieldEnd;
+                }
+                if (column == layout.latitudeColumn) {
+                    hasLatitude = parseNumber(field, fieldEnd, latitude);
+                } else if (column == layout.longitudeColumn) {
+                    hasLongitude = parseNumber(field, fieldEnd, longitude);
+                }
+                field = fieldEnd + 1;
+            }
+
+            if (hasLatitude && hasLongitude && isValidPosition(latitude, longitude)) {
+                slot.longitudes.push_back(longitude);
+                slot.latitudes.push_back(latitude);
+            } else if (!trimField(line, lineEnd).empty()) {
+                ++slot.skipped;
+            }
+            line = lineEnd + 1;
+        }
+    }
+
+    // Reads lat and lon from the attributes of a tag, up to its closing '>'
+    const char *parseGpxPoint(const char *p, const char *fileEnd, ChunkSlot &slot) {
+        double latitude = 0.0, longitude = 0.0;
+        bool hasLatitude = false, hasLongitude = false;
+
+        while (p < fileEnd && *p != '>') {
+            if (isSpace(*p)) {
+                ++p;
+                continue;
+            }
+
+            const char *name = p;
+            while (p < fileEnd && *p != '=' && *p != '>' && !isSpace(*p)) {
+                ++p;
+            }
+            const std::string_view attribute(name, static_cast<size_t>(p - name));
+            while (p < fileEnd && (isSpace(*p) || *p == '=')) {
+                ++p;
+            }
+            if (p >= fileEnd || (*p != '"' && *p != '\'')) {
+                continue; // Stray token or '/', not an attribute value
+            }
+
+            const char quote = *p++;
+            const char *value = p;
+            while (p < fileEnd && *p != quote) {
+                ++p;
+            }
+            if (attribute == "lat") {
+                hasLatitude = parseNumber(value, p, latitude);
+            } else if (attribute == "lon") {
+                hasLongitude = parseNumber(value, p, longitude);
+            }
+            ++p;
+        }
+
+        if (hasLatitude && hasLongitude && isValidPosition(latitude, longitude)) {
+            slot.longitudes.push_back(longitude);
+            slot.latitudes.push_back(latitude);
+        } else {
+            ++slot.skipped;
+        }
+        return p;
+    }
+
+    void parseGpxChunk(const ImportJob &job, const char *begin, const char *end, ChunkSlot &slot) {
+        const char *fileEnd = job.file->data + job.file->size;
+        const char *p = begin;
+
+        while (p < end) {
+            const auto *tag = static_cast<const char *>(std::memchr(p, '<', static_cast<size_t>(end - p)));
+            if (!tag) {
+                break;
+            }
+
+            p = tag + 1;
+            if (fileEnd - p > 6 && (std::memcmp(p, "trkpt", 5) == 0 || std::memcmp(p, "rtept", 5) == 0) &&
+                isSpace(p[5])) {
+                p = parseGpxPoint(p + 6, fileEnd, slot);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // Workers
+    // ------------------------------------------------------------------------
+    void parseChunk(const ImportJob &job, const size_t chunk, ChunkSlot &slot) {
+        TRACE_SCOPE("parseTrackChunk", "load");
+        slot.longitudes.clear();
+        slot.latitudes.clear();
+        slot.skipped = 0;
+
+        const char *begin = job.file->data + std::max(chunk * CHUNK_SIZE, job.layout.dataStart);
+        const char *end = job.file->data + std::min((chunk + 1) * CHUNK_SIZE, job.file->size);
+        if (begin < end) {
+            if (job.format == TrackFormat::Gpx) {
+                parseGpxChunk(job, begin, end, slot);
+            } else {
+                parseCsvChunk(job, begin, end, slot);
+            }
+        }
+
+        const size_t count = slot.longitudes.size();
+        slot.xs.resize(count);
+        slot.ys.resize(count);
+        geographicToMetres(*job.geo, slot.longitudes.data(), slot.latitudes.data(), count, slot.xs.data(),
+                           slot.ys.data());
+    }
+
+    void runWorker(ImportJob &job) {
+        setTraceThreadName("track import");
+        const size_t window = job.slots.size();
+
+        while (true) {
+            const size_t chunk = job.nextChunk.fetch_add(1);
+            if (chunk >= job.chunkCount) {
+                return;
+            }
+
+            // The slot is free once the chunk that used it before has gone to the sink
+            ChunkSlot &slot = job.slots[chunk % window];
+            {
+                std::unique_lock<std::mutex> lock(job.mutex);
+                job.changed.wait(lock, [&job, chunk, window] { return chunk < job.delivered + window; });
+            }
+
+            parseChunk(job, chunk, slot);
+            {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                slot.ready = true;
+            }
+            job.changed.notify_all();
+        }
+    }
+}
+
+bool importTrack(const char *path, const Georeference &geo, const TrackPointSink sink, void *context,
+                 TrackImportStats &stats) {
+    TRACE_SCOPE_DETAIL("importTrack", "load", path);
+    const auto start = std::chrono::steady_clock::now();
+    stats = TrackImportStats{};
+
+    if (geo.projection != MapProjection::WebMercator) {
+        std::cout << "Mapa nema geografsku referencu, trasa \"" << path << "\" ne moze da se ucita!" << std::endl;
+        return false;
+    }
+
+    MappedFile file;
+    if (!openMappedFile(file, path)) {
+        return false;
+    }
+
+    ImportJob job;
+    job.file = &file;
+    job.geo = &geo;
+    job.format = detectFormat(file);
+    if (job.format == TrackFormat::Csv && !detectCsvLayout(file, job.layout)) {
+        std::cout << "CSV fajl \"" << path << "\" nema kolone lat i lon!" << std::endl;
+        closeMappedFile(file);
+        return false;
+    }
+
+    job.chunkCount = (file.size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    const size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, MAX_WORKERS);
+    job.slots.resize(std::min(job.chunkCount, workerCount * CHUNKS_PER_WORKER));
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::min(job.chunkCount, workerCount); ++i) {
+        workers.emplace_back(runWorker, std::ref(job));
+    }
+
+    // Chunks go to the sink in file order as soon as they are parsed
+    for (size_t chunk = 0; chunk < job.chunkCount; ++chunk) {
+        ChunkSlot &slot = job.slots[chunk % job.slots.size()];
+        {
+            std::unique_lock<std::mutex> lock(job.mutex);
+            job.changed.wait(lock, [&slot] { return slot.ready; });
+        }
+
+        if (!slot.xs.empty()) {
+            sink(context, slot.xs.data(), slot.ys.data(), slot.xs.size());
+        }
+        stats.points += slot.xs.size();
+        stats.skipped += slot.skipped;
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            slot.ready = false;
+            job.delivered = chunk + 1;
+        }
+        job.changed.notify_all();
+    }
+
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+
+    stats.bytes = file.size;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    closeMappedFile(file);
+    return true;
+}
@@ -1,4 +1,5 @@
 #include "../Header/Util.h"
+#include "../Header/Trace.h"
 
 #define _CRT_SECURE_NO_WARNINGS
 #include <fstream>
@@ -62,6 +63,7 @@ unsigned int compileShader(GLenum type, const char* source)
 unsigned int createShader(const char* vsSource, const char* fsSource)
 {
     //Pravi objedinjeni sejder program koji se sastoji od Vertex sejdera ciji je kod na putanji vsSource
+    TRACE_SCOPE_DETAIL("createShader", "load", vsSource);
 
     unsigned int program; //Objedinjeni sejder
     unsigned int vertexShader; //Verteks sejder (za prostorne podatke)
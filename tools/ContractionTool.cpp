@@ -0,0 +1,124 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include "../Header/ContractionHierarchy.h"
+#include "../Header/RoadGraph.h"
+#include "../Header/RoadRouter.h"
+
+// ============================================================================
+// CONTRACTION TOOL
+// ============================================================================
+// Builds the contraction hierarchy of a road graph offline, so the application
+// only maps the file:
+//
+//   KosturContract [--threads N] [--verify N] [graph] [hierarchy]
+//
+// Run from the build directory like the application, the defaults read the
+// map.graph written by KosturRoadGraph and write map.ch next to it. --verify
+// compares N random queries against A* on the graph and reports both timings.
+namespace {
+    double millisecondsSince(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool verifyHierarchy(const RoadGraph &graph, const ContractionHierarchy &hierarchy, const size_t queries) {
+        RoadRouter router;
+        createRoadRouter(router, graph, 0.0f);
+        HierarchyQuery query;
+        createHierarchyQuery(query, hierarchy, 0.0f);
+
+        std::mt19937 random(12345);
+        std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(graph.xs.size() - 1));
+        size_t mismatches = 0, settledByRouter = 0, settledByHierarchy = 0;
+        double routerMs = 0.0, hierarchyMs = 0.0;
+        for (size_t i = 0; i < queries; ++i) {
+            const uint32_t source = pick(random);
+            const uint32_t target = pick(random);
+
+            auto start = std::chrono::steady_clock::now();
+            const bool routed = findRoadPath(router, source, target);
+            routerMs += millisecondsSince(start);
+            start = std::chrono::steady_clock::now();
+            const bool found = findHierarchyPath(query, source, target);
+            hierarchyMs += millisecondsSince(start);
+            settledByRouter += router.settled;
+            settledByHierarchy += query.settled;
+
+            // Sums taken in a different order differ in the last bits
+            const float tolerance = 1e-4f * std::max(1.0f, router.pathLength);
+            if (routed != found || (found && (std::abs(router.pathLength - query.pathLength) > tolerance ||
+                                              query.path.front() != source || query.path.back() != target))) {
+                ++mismatches;
+            }
+        }
+
+        std::cout << "Provereno " << queries << " upita, " << mismatches << " razlika." << std::endl;
+        std::cout << "A*: " << routerMs * 1000.0 / queries << " us, " << settledByRouter / queries
+                  << " cvorova po upitu. Hijerarhija: " << hierarchyMs * 1000.0 / queries << " us, "
+                  << settledByHierarchy / queries << " cvorova po upitu." << std::endl;
+        return mismatches == 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *graphPath = "../resources/textures/map.graph";
+    const char *hierarchyPath = "../resources/textures/map.ch";
+    ContractionOptions options;
+    size_t verifyQueries = 0;
+
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--verify") == 0 && i + 1 < argc) {
+            verifyQueries = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argv[i][0] != '-' && positional == 0) {
+            graphPath = argv[i];
+            ++positional;
+        } else if (argv[i][0] != '-' && positional == 1) {
+            hierarchyPath = argv[i];
+            ++positional;
+        } else {
+            std::cout << "Upotreba: KosturContract [--threads N] [--verify N] [graf] [hijerarhija]" << std::endl;
+            return 1;
+        }
+    }
+
+    RoadGraph graph;
+    if (!loadRoadGraph(graphPath, graph)) {
+        return 1;
+    }
+
+    ContractionHierarchyData data;
+    ContractionStats stats;
+    buildContractionHierarchy(graph, options, data, stats);
+    std::cout << "Hijerarhija: " << data.xs.size() << " cvorova, " << data.targets.size() << " ivica navise ("
+              << stats.shortcuts << " precica), " << stats.rounds << " rundi za " << stats.seconds << " s."
+              << std::endl;
+
+    if (!saveContractionHierarchy(hierarchyPath, data)) {
+        return 1;
+    }
+    std::cout << "Sacuvano u \"" << hierarchyPath << "\"." << std::endl;
+
+    // Queries run on the saved file, as in the application
+    if (verifyQueries > 0 && !graph.xs.empty()) {
+        ContractionHierarchy hierarchy;
+        if (!loadContractionHierarchy(hierarchyPath, hierarchy)) {
+            return 1;
+        }
+        const bool verified = verifyHierarchy(graph, hierarchy, verifyQueries);
+        closeContractionHierarchy(hierarchy);
+        if (!verified) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../Header/RoadGraph.h"
+
+// ============================================================================
+// ROAD GRAPH TOOL
+// ============================================================================
+// Traces the street graph of a map image offline, so the application can load
+// it instead of extracting it at startup:
+//
+//   KosturRoadGraph [--threads N] [image] [graph]
+//
+// Run from the build directory like the application, the defaults read the
+// shipped map and write map.graph next to it.
+int main(int argc, char **argv) {
+    const char *imagePath = "../resources/textures/map.jpg";
+    const char *graphPath = "../resources/textures/map.graph";
+    RoadGraphOptions options;
+
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argv[i][0] != '-' && positional == 0) {
+            imagePath = argv[i];
+            ++positional;
+        } else if (argv[i][0] != '-' && positional == 1) {
+            graphPath = argv[i];
+            ++positional;
+        } else {
+            std::cout << "Upotreba: KosturRoadGraph [--threads N] [slika] [graf]" << std::endl;
+            return 1;
+        }
+    }
+
+    RoadGraph graph;
+    RoadGraphStats stats;
+    if (!loadImageToRoadGraph(imagePath, options, graph, stats)) {
+        return 1;
+    }
+
+    double totalLength = 0.0;
+    for (const float length: graph.lengths) {
+        totalLength += length;
+    }
+    std::cout << "Piksela ulica: " << stats.roadPixels << " (" << stats.filledPixels << " popunjeno), skelet "
+              << stats.skeletonPixels << " posle " << stats.iterations << " iteracija." << std::endl;
+    std::cout << "Graf: " << graph.xs.size() << " cvorova, " << graph.targets.size() / 2 << " ivica, "
+              << totalLength / 2.0 << " px ulica, " << stats.prunedSpurs << " odsecenih krakova." << std::endl;
+    std::cout << "Klasifikacija " << stats.classifySeconds << " s, istanjivanje " << stats.thinSeconds
+              << " s, pracenje " << stats.traceSeconds << " s." << std::endl;
+
+    if (!saveRoadGraph(graphPath, graph)) {
+        return 1;
+    }
+    std::cout << "Sacuvano u \"" << graphPath << "\"." << std::endl;
+    return 0;
+}